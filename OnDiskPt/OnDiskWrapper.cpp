@@ -25,6 +25,7 @@
 #include "OnDiskWrapper.h"
 #include "moses/Factor.h"
 #include "util/exception.hh"
+#include "util/file.hh"
 #include "util/string_stream.hh"
 
 using namespace std;
@@ -35,6 +36,7 @@ namespace OnDiskPt
 int OnDiskWrapper::VERSION_NUM = 7;
 
 OnDiskWrapper::OnDiskWrapper()
+  : m_mapped(false)
 {
 }
 
@@ -43,12 +45,19 @@ OnDiskWrapper::~OnDiskWrapper()
   delete m_rootSourceNode;
 }
 
-void OnDiskWrapper::BeginLoad(const std::string &filePath)
+void OnDiskWrapper::BeginLoad(const std::string &filePath, bool mapped)
 {
   if (!OpenForLoad(filePath)) {
     UTIL_THROW(util::FileOpenException, "Couldn't open for loading: " << filePath);
   }
 
+  if (mapped) {
+    Map(filePath + "/Source.dat", m_memSource);
+    Map(filePath + "/TargetInd.dat", m_memTargetInd);
+    Map(filePath + "/TargetColl.dat", m_memTargetColl);
+    m_mapped = true;
+  }
+
   if (!m_vocab.Load(*this))
     UTIL_THROW(util::FileOpenException, "Couldn't load vocab");
 
@@ -92,6 +101,12 @@ bool OnDiskWrapper::OpenForLoad(const std::string &filePath)
   return true;
 }
 
+void OnDiskWrapper::Map(const std::string &path, util::scoped_memory &mem)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(path.c_str()));
+  util::MapRead(util::LAZY, file.get(), 0, util::CheckOverflow(util::SizeOrThrow(file.get())), mem);
+}
+
 bool OnDiskWrapper::LoadMisc()
 {
   char line[100000];
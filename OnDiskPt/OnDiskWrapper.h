@@ -23,6 +23,7 @@
 #include "Vocab.h"
 #include "PhraseNode.h"
 #include "moses/Word.h"
+#include "util/mmap.hh"
 
 namespace OnDiskPt
 {
@@ -40,6 +41,10 @@ protected:
   int m_numSourceFactors, m_numTargetFactors, m_numScores;
   std::fstream m_fileMisc, m_fileVocab, m_fileSource, m_fileTarget, m_fileTargetInd, m_fileTargetColl;
 
+  // source nodes, target phrases and collections when mapped instead of read through the streams
+  util::scoped_memory m_memSource, m_memTargetInd, m_memTargetColl;
+  bool m_mapped;
+
   size_t m_defaultNodeSize;
   PhraseNode *m_rootSourceNode;
 
@@ -47,6 +52,7 @@ protected:
 
   void SaveMisc();
   bool OpenForLoad(const std::string &filePath);
+  void Map(const std::string &path, util::scoped_memory &mem);
   bool LoadMisc();
 
 public:
@@ -55,7 +61,8 @@ public:
   OnDiskWrapper();
   ~OnDiskWrapper();
 
-  void BeginLoad(const std::string &filePath);
+  //! with mapped=true, nodes and target phrases are read from memory maps of the files
+  void BeginLoad(const std::string &filePath, bool mapped = false);
 
   void BeginSave(const std::string &filePath
                  , int numSourceFactors, int	numTargetFactors, int numScores);
@@ -84,6 +91,19 @@ public:
     return m_fileVocab;
   }
 
+  bool IsMapped() const {
+    return m_mapped;
+  }
+  const char *GetMemSource() const {
+    return static_cast<const char*>(m_memSource.get());
+  }
+  const char *GetMemTargetInd() const {
+    return static_cast<const char*>(m_memTargetInd.get());
+  }
+  const char *GetMemTargetColl() const {
+    return static_cast<const char*>(m_memTargetColl.get());
+  }
+
   size_t GetNumSourceFactors() const {
     return m_numSourceFactors;
   }
@@ -17,6 +17,7 @@
  License along with this library; if not, write to the Free Software
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***********************************************************************/
+#include <cstring>
 #include "PhraseNode.h"
 #include "OnDiskWrapper.h"
 #include "TargetPhraseCollection.h"
@@ -42,6 +43,7 @@ PhraseNode::PhraseNode()
   ,m_currChild(NULL)
   ,m_saved(false)
   ,m_memLoad(NULL)
+  ,m_ownMemLoad(true)
 {
 }
 
@@ -52,39 +54,49 @@ PhraseNode::PhraseNode(uint64_t filePos, OnDiskWrapper &onDiskWrapper)
   m_filePos = filePos;
 
   size_t countSize = onDiskWrapper.GetNumCounts();
+  size_t memAlloc;
+
+  if (onDiskWrapper.IsMapped()) {
+    // no copy, the node is read where it is in the mapped file
+    m_memLoad = const_cast<char*>(onDiskWrapper.GetMemSource() + filePos);
+    m_ownMemLoad = false;
+    memcpy(&m_numChildrenLoad, m_memLoad, sizeof(uint64_t));
+    memAlloc = GetNodeSize(m_numChildrenLoad, onDiskWrapper.GetSourceWordSize(), countSize);
+  } else {
+    std::fstream &file = onDiskWrapper.GetFileSource();
+    file.seekg(filePos);
+    assert(filePos == (uint64_t)file.tellg());
 
-  std::fstream &file = onDiskWrapper.GetFileSource();
-  file.seekg(filePos);
-  assert(filePos == (uint64_t)file.tellg());
-
-  file.read((char*) &m_numChildrenLoad, sizeof(uint64_t));
+    file.read((char*) &m_numChildrenLoad, sizeof(uint64_t));
 
-  size_t memAlloc = GetNodeSize(m_numChildrenLoad, onDiskWrapper.GetSourceWordSize(), countSize);
-  m_memLoad = (char*) malloc(memAlloc);
+    memAlloc = GetNodeSize(m_numChildrenLoad, onDiskWrapper.GetSourceWordSize(), countSize);
+    m_memLoad = (char*) malloc(memAlloc);
+    m_ownMemLoad = true;
 
-  // go to start of node again
-  file.seekg(filePos);
-  assert(filePos == (uint64_t)file.tellg());
+    // go to start of node again
+    file.seekg(filePos);
+    assert(filePos == (uint64_t)file.tellg());
 
-  // read everything into memory
-  file.read(m_memLoad, memAlloc);
-  assert(filePos + memAlloc == (uint64_t)file.tellg());
+    // read everything into memory
+    file.read(m_memLoad, memAlloc);
+    assert(filePos + memAlloc == (uint64_t)file.tellg());
+  }
 
   // get value
-  m_value = ((uint64_t*)m_memLoad)[1];
+  memcpy(&m_value, m_memLoad + sizeof(uint64_t), sizeof(uint64_t));
 
   // get counts
-  float *memFloat = (float*) (m_memLoad + sizeof(uint64_t) * 2);
-
   assert(countSize == 1);
-  m_counts[0] = memFloat[0];
+  memcpy(&m_counts[0], m_memLoad + sizeof(uint64_t) * 2, sizeof(float));
 
   m_memLoadLast = m_memLoad + memAlloc;
 }
 
 PhraseNode::~PhraseNode()
 {
-  free(m_memLoad);
+  if (m_ownMemLoad) {
+    free(m_memLoad);
+  }
 }
 
 float PhraseNode::GetCount(size_t ind) const
@@ -48,6 +48,7 @@ protected:
   TargetPhraseCollection m_targetPhraseColl;
 
   char *m_memLoad, *m_memLoadLast;
+  bool m_ownMemLoad; // false if m_memLoad points into the mapped file
   uint64_t m_numChildrenLoad;
 
   void AddTargetPhrase(size_t pos, const SourcePhrase &sourcePhrase
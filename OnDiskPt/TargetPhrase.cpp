@@ -19,6 +19,7 @@
  ***********************************************************************/
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "moses/Util.h"
 #include "moses/TargetPhrase.h"
@@ -434,6 +435,99 @@ uint64_t TargetPhrase::ReadScoresFromFile(std::fstream &fileTPColl)
   return bytesRead;
 }
 
+uint64_t TargetPhrase::ReadOtherInfoFromMemory(const char *memTPColl)
+{
+  uint64_t memUsed = 0;
+  memcpy(&m_filePos, memTPColl, sizeof(uint64_t));
+  memUsed += sizeof(uint64_t);
+  assert(m_filePos != 0);
+
+  memUsed += ReadAlignFromMemory(memTPColl + memUsed);
+  memUsed += ReadScoresFromMemory(memTPColl + memUsed);
+
+  // sparse features
+  memUsed += ReadStringFromMemory(memTPColl + memUsed, m_sparseFeatures);
+
+  // properties
+  memUsed += ReadStringFromMemory(memTPColl + memUsed, m_property);
+
+  return memUsed;
+}
+
+uint64_t TargetPhrase::ReadStringFromMemory(const char *mem, std::string &outStr)
+{
+  uint64_t strSize;
+  memcpy(&strSize, mem, sizeof(uint64_t));
+
+  if (strSize) {
+    outStr.assign(mem + sizeof(uint64_t), strSize);
+  }
+
+  return sizeof(uint64_t) + strSize;
+}
+
+uint64_t TargetPhrase::ReadFromMemory(const char *memTP)
+{
+  uint64_t bytesRead = 0;
+
+  uint64_t numWords;
+  memcpy(&numWords, memTP, sizeof(uint64_t));
+  bytesRead += sizeof(uint64_t);
+
+  for (size_t ind = 0; ind < numWords; ++ind) {
+    WordPtr word(new Word());
+    bytesRead += word->ReadFromMemory(memTP + bytesRead);
+    AddWord(word);
+  }
+
+  // read source words
+  uint64_t numSourceWords;
+  memcpy(&numSourceWords, memTP + bytesRead, sizeof(uint64_t));
+  bytesRead += sizeof(uint64_t);
+
+  PhrasePtr sp(new SourcePhrase());
+  for (size_t ind = 0; ind < numSourceWords; ++ind) {
+    WordPtr word( new Word());
+    bytesRead += word->ReadFromMemory(memTP + bytesRead);
+    sp->AddWord(word);
+  }
+  SetSourcePhrase(sp);
+
+  return bytesRead;
+}
+
+uint64_t TargetPhrase::ReadAlignFromMemory(const char *mem)
+{
+  uint64_t bytesRead = 0;
+
+  uint64_t numAlign;
+  memcpy(&numAlign, mem, sizeof(uint64_t));
+  bytesRead += sizeof(uint64_t);
+
+  for (size_t ind = 0; ind < numAlign; ++ind) {
+    AlignPair alignPair;
+    memcpy(&alignPair.first, mem + bytesRead, sizeof(uint64_t));
+    memcpy(&alignPair.second, mem + bytesRead + sizeof(uint64_t), sizeof(uint64_t));
+    m_align.push_back(alignPair);
+
+    bytesRead += sizeof(uint64_t) * 2;
+  }
+
+  return bytesRead;
+}
+
+uint64_t TargetPhrase::ReadScoresFromMemory(const char *mem)
+{
+  UTIL_THROW_IF2(m_scores.size() == 0, "Translation rules must must have some scores");
+
+  memcpy(&m_scores[0], mem, sizeof(float) * m_scores.size());
+
+  std::transform(m_scores.begin(),m_scores.end(),m_scores.begin(), Moses::TransformScore);
+  std::transform(m_scores.begin(),m_scores.end(),m_scores.begin(), Moses::FloorScore);
+
+  return sizeof(float) * m_scores.size();
+}
+
 void TargetPhrase::DebugPrint(ostream &out, const Vocab &vocab) const
 {
   Phrase::DebugPrint(out, vocab);
@@ -19,6 +19,7 @@
  ***********************************************************************/
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "moses/Util.h"
 #include "moses/TargetPhraseCollection.h"
@@ -149,6 +150,11 @@ Moses::TargetPhraseCollection::shared_ptr TargetPhraseCollection::ConvertToMoses
 
 void TargetPhraseCollection::ReadFromFile(size_t tableLimit, uint64_t filePos, OnDiskWrapper &onDiskWrapper)
 {
+  if (onDiskWrapper.IsMapped()) {
+    ReadFromMemory(tableLimit, filePos, onDiskWrapper);
+    return;
+  }
+
   fstream &fileTPColl = onDiskWrapper.GetFileTargetColl();
   fstream &fileTP = onDiskWrapper.GetFileTargetInd();
 
@@ -180,6 +186,32 @@ void TargetPhraseCollection::ReadFromFile(size_t tableLimit, uint64_t filePos, O
   }
 }
 
+void TargetPhraseCollection::ReadFromMemory(size_t tableLimit, uint64_t filePos, const OnDiskWrapper &onDiskWrapper)
+{
+  const char *memTPColl = onDiskWrapper.GetMemTargetColl() + filePos;
+  const char *memTP = onDiskWrapper.GetMemTargetInd();
+
+  size_t numScores = onDiskWrapper.GetNumScores();
+
+  uint64_t numPhrases;
+  memcpy(&numPhrases, memTPColl, sizeof(uint64_t));
+  memTPColl += sizeof(uint64_t);
+
+  // table limit
+  if (tableLimit) {
+    numPhrases = std::min(numPhrases, (uint64_t) tableLimit);
+  }
+
+  for (size_t ind = 0; ind < numPhrases; ++ind) {
+    TargetPhrase *tp = new TargetPhrase(numScores);
+
+    memTPColl += tp->ReadOtherInfoFromMemory(memTPColl);
+    tp->ReadFromMemory(memTP + tp->GetFilePos());
+
+    m_coll.push_back(tp);
+  }
+}
+
 uint64_t TargetPhraseCollection::GetFilePos() const
 {
   return m_filePos;
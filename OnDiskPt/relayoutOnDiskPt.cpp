@@ -0,0 +1,221 @@
+// Rewrite the source trie of a binary rule table so that nodes walked
+// together are stored together.
+//
+// CreateOnDiskPt saves each node after all of its children, so a lookup from
+// the root touches nodes scattered over the whole of Source.dat. This tool
+// writes the nodes again in breadth-first order, which keeps the top of the
+// trie and the children of each node contiguous, or in van Emde Boas order,
+// which also keeps every node near its parent. Only Source.dat and the root
+// offset in Misc.dat change; the other files are copied and the format is the
+// same, so the output can be used wherever the input was.
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "moses/Util.h"
+#include "util/exception.hh"
+#include "OnDiskWrapper.h"
+
+using namespace std;
+using namespace OnDiskPt;
+
+void usage();
+
+namespace
+{
+
+// a node of Source.dat, with its children stored contiguously in breadth-first order
+struct Node {
+  uint64_t filePos;
+  uint64_t firstChild, numChildren;
+};
+
+class Trie
+{
+public:
+  Trie(const OnDiskWrapper &wrapper)
+    : m_mem(wrapper.GetMemSource())
+    , m_wordSize(wrapper.GetSourceWordSize())
+    , m_numCounts(wrapper.GetNumCounts())
+    , m_height(0) {
+    vector<size_t> depth(1, 1);
+    Node root = { wrapper.GetMisc("RootNodeOffset"), 0, 0 };
+    m_nodes.push_back(root);
+    for (size_t ind = 0; ind < m_nodes.size(); ++ind) {
+      Node &node = m_nodes[ind];
+      memcpy(&node.numChildren, m_mem + node.filePos, sizeof(uint64_t));
+      node.firstChild = m_nodes.size();
+      m_height = max(m_height, depth[ind]);
+
+      uint64_t filePos = node.filePos;
+      uint64_t numChildren = node.numChildren;
+      for (size_t child = 0; child < numChildren; ++child) {
+        Node childNode = { 0, 0, 0 };
+        memcpy(&childNode.filePos, m_mem + filePos + ChildPtrOffset(child), sizeof(uint64_t));
+        m_nodes.push_back(childNode);
+        depth.push_back(depth[ind] + 1);
+      }
+    }
+  }
+
+  size_t GetSize() const {
+    return m_nodes.size();
+  }
+
+  void BreadthFirstOrder(vector<uint64_t> &order) const {
+    for (uint64_t ind = 0; ind < m_nodes.size(); ++ind) {
+      order.push_back(ind);
+    }
+  }
+
+  void VanEmdeBoasOrder(vector<uint64_t> &order) const {
+    VanEmdeBoasOrder(0, m_height, order);
+  }
+
+  // writes the nodes in the given order and returns the new file position of the root
+  uint64_t Write(const vector<uint64_t> &order, ostream &out) const {
+    vector<uint64_t> newPos(m_nodes.size());
+    uint64_t filePos = 1; // 0 offset is reserved
+    for (size_t ind = 0; ind < order.size(); ++ind) {
+      newPos[order[ind]] = filePos;
+      filePos += NodeSize(m_nodes[order[ind]]);
+    }
+
+    char c = 0xff;
+    out.write(&c, 1);
+
+    vector<char> mem;
+    for (size_t ind = 0; ind < order.size(); ++ind) {
+      const Node &node = m_nodes[order[ind]];
+      mem.assign(m_mem + node.filePos, m_mem + node.filePos + NodeSize(node));
+      for (size_t child = 0; child < node.numChildren; ++child) {
+        memcpy(&mem[ChildPtrOffset(child)], &newPos[node.firstChild + child], sizeof(uint64_t));
+      }
+      out.write(&mem[0], mem.size());
+    }
+    UTIL_THROW_IF2(!out, "Couldn't write source trie");
+
+    return newPos[0];
+  }
+
+private:
+  const char *m_mem;
+  size_t m_wordSize, m_numCounts, m_height;
+  vector<Node> m_nodes;
+
+  size_t NodeSize(const Node &node) const {
+    return PhraseNode::GetNodeSize(node.numChildren, m_wordSize, m_numCounts);
+  }
+
+  // see PhraseNode::GetChild()
+  size_t ChildPtrOffset(size_t child) const {
+    return sizeof(uint64_t) * 2 + sizeof(float) * m_numCounts
+           + (m_wordSize + sizeof(uint64_t)) * child + m_wordSize;
+  }
+
+  // the top half of the levels below node first, then each subtree hanging off it
+  void VanEmdeBoasOrder(uint64_t node, size_t height, vector<uint64_t> &order) const {
+    if (height <= 1) {
+      order.push_back(node);
+      return;
+    }
+    size_t top = height / 2;
+    VanEmdeBoasOrder(node, top, order);
+
+    vector<uint64_t> level(1, node), next;
+    for (size_t depth = 0; depth < top; ++depth) {
+      next.clear();
+      for (size_t ind = 0; ind < level.size(); ++ind) {
+        const Node &parent = m_nodes[level[ind]];
+        for (uint64_t child = 0; child < parent.numChildren; ++child) {
+          next.push_back(parent.firstChild + child);
+        }
+      }
+      level.swap(next);
+    }
+    for (size_t ind = 0; ind < level.size(); ++ind) {
+      VanEmdeBoasOrder(level[ind], height - top, order);
+    }
+  }
+};
+
+void CopyMisc(const string &inPath, const string &outPath, uint64_t rootFilePos)
+{
+  ifstream in((inPath + "/Misc.dat").c_str());
+  ofstream out((outPath + "/Misc.dat").c_str());
+  string line;
+  while (getline(in, line)) {
+    vector<string> tokens;
+    Moses::Tokenize(tokens, line);
+    if (tokens.size() == 2 && tokens[0] == "RootNodeOffset") {
+      out << "RootNodeOffset " << rootFilePos << endl;
+    } else {
+      out << line << endl;
+    }
+  }
+  UTIL_THROW_IF2(!out, "Couldn't write " << outPath << "/Misc.dat");
+}
+
+}
+
+int main(int argc, char **argv)
+{
+  string order = "veb";
+  vector<string> paths;
+
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-order")) {
+      if(i + 1 == argc)
+        usage();
+      order = argv[++i];
+    } else
+      paths.push_back(argv[i]);
+  }
+
+  if(paths.size() != 2 || (order != "bfs" && order != "veb"))
+    usage();
+  const string &inPath = paths[0], &outPath = paths[1];
+
+  OnDiskWrapper onDiskWrapper;
+  onDiskWrapper.BeginLoad(inPath, true);
+  Trie trie(onDiskWrapper);
+  cerr << "Read " << trie.GetSize() << " nodes" << endl;
+
+  vector<uint64_t> nodeOrder;
+  nodeOrder.reserve(trie.GetSize());
+  if (order == "bfs") {
+    trie.BreadthFirstOrder(nodeOrder);
+  } else {
+    trie.VanEmdeBoasOrder(nodeOrder);
+  }
+
+  boost::filesystem::create_directories(outPath);
+  ofstream source((outPath + "/Source.dat").c_str(), ios::out | ios::binary);
+  uint64_t rootFilePos = trie.Write(nodeOrder, source);
+  source.close();
+
+  const char *copied[] = { "TargetInd.dat", "TargetColl.dat", "Vocab.dat" };
+  for (size_t i = 0; i < sizeof(copied) / sizeof(copied[0]); ++i) {
+    ifstream in((inPath + "/" + copied[i]).c_str(), ios::in | ios::binary);
+    ofstream out((outPath + "/" + copied[i]).c_str(), ios::out | ios::binary);
+    out << in.rdbuf();
+    UTIL_THROW_IF2(!out, "Couldn't write " << outPath << "/" << copied[i]);
+  }
+  CopyMisc(inPath, outPath, rootFilePos);
+
+  cerr << "Finished." << endl;
+}
+
+void usage()
+{
+  std::cerr << "Usage: relayoutOnDiskPt [-order bfs|veb] <in ttable> <out ttable>\n"
+            "Writes the source trie of a binary rule table in a layout that keeps lookups within fewer pages.\n"
+            "-order bfs|veb    breadth-first or van Emde Boas order (default: veb)\n";
+  exit(1);
+}
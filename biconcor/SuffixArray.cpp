@@ -1,23 +1,45 @@
 #include "SuffixArray.h"
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <cstdlib>
 #include <cstring>
 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+using namespace std;
+
 namespace
 {
 
 const int LINE_MAX_LENGTH = 10000;
 
+// buckets with more suffixes first, so that the big ones do not come last
+bool LargerBucket( const pair< SuffixArray::INDEX, SuffixArray::INDEX > &a,
+                   const pair< SuffixArray::INDEX, SuffixArray::INDEX > &b )
+{
+  return a.second - a.first > b.second - b.first;
+}
+
 } // namespace
 
-using namespace std;
+// orders corpus positions by the suffixes starting there, while sorting
+class SuffixArray::SuffixLess
+{
+public:
+  SuffixLess( const SuffixArray &suffixArray ) : m_suffixArray( suffixArray ) {}
+  bool operator()( SuffixArray::INDEX a, SuffixArray::INDEX b ) const {
+    return m_suffixArray.CompareIndexByRank( a, b ) < 0;
+  }
+private:
+  const SuffixArray &m_suffixArray;
+};
 
 SuffixArray::SuffixArray()
   : m_array(NULL),
     m_index(NULL),
-    m_buffer(NULL),
     m_wordInSentence(NULL),
     m_sentence(NULL),
     m_sentenceLength(NULL),
@@ -28,7 +50,8 @@ SuffixArray::SuffixArray()
     m_useDocument(false),
     m_vcb(),
     m_size(0),
-    m_sentenceCount(0) { }
+    m_sentenceCount(0),
+    m_threads(max(boost::thread::hardware_concurrency(), 1u)) { }
 
 SuffixArray::~SuffixArray()
 {
@@ -128,16 +151,7 @@ void SuffixArray::Create(const string& fileName )
   cerr << "done reading " << wordIndex << " words, " << sentenceId << " sentences." << endl;
   // List(0,9);
 
-  // sort
-  m_buffer = (INDEX*) calloc( sizeof( INDEX ), m_size );
-
-  if (m_buffer == NULL) {
-    cerr << "Error: cannot allocate memory to m_buffer" << endl;
-    exit(1);
-  }
-
-  Sort( 0, m_size-1 );
-  free( m_buffer );
+  Sort();
   cerr << "done sorting" << endl;
 }
 
@@ -180,35 +194,61 @@ bool SuffixArray::ProcessDocumentLine( const char *line, const size_t sentenceId
   return true;
 }
 
-// good ol' quick sort
-void SuffixArray::Sort(INDEX start, INDEX end)
+// Sorts the suffixes into buckets by their first word, then the suffixes in
+// each bucket, spreading the buckets over several threads. Words are compared
+// by their rank in the sorted vocabulary, which gives the same order as
+// comparing their strings.
+void SuffixArray::Sort()
 {
-  if (start == end) return;
-  INDEX mid = (start+end+1)/2;
-  Sort( start, mid-1 );
-  Sort( mid, end );
-
-  // merge
-  INDEX i = start;
-  INDEX j = mid;
-  INDEX k = 0;
-  INDEX length = end-start+1;
-  while( k<length ) {
-    if (i == mid ) {
-      m_buffer[ k++ ] = m_index[ j++ ];
-    } else if (j > end ) {
-      m_buffer[ k++ ] = m_index[ i++ ];
-    } else {
-      if (CompareIndex( m_index[i], m_index[j] ) < 0) {
-        m_buffer[ k++ ] = m_index[ i++ ];
-      } else {
-        m_buffer[ k++ ] = m_index[ j++ ];
-      }
+  m_rank.resize( m_vcb.vocab.size() );
+  WORD_ID rank = 0;
+  for( map< WORD, WORD_ID >::const_iterator i = m_vcb.lookup.begin(); i != m_vcb.lookup.end(); i++ ) {
+    m_rank[ i->second ] = rank++;
+  }
+
+  // counting sort by first word
+  vector< INDEX > first( m_rank.size()+1, 0 );
+  for( INDEX i=0; i<m_size; i++ ) {
+    first[ m_rank[ m_array[i] ]+1 ]++;
+  }
+  for( size_t r=1; r<first.size(); r++ ) {
+    first[ r ] += first[ r-1 ];
+  }
+  vector< INDEX > next( first.begin(), first.end()-1 );
+  for( INDEX i=0; i<m_size; i++ ) {
+    m_index[ next[ m_rank[ m_array[i] ] ]++ ] = i;
+  }
+
+  vector< pair< INDEX, INDEX > > buckets;
+  for( size_t r=0; r+1<first.size(); r++ ) {
+    if (first[ r+1 ] - first[ r ] > 1) {
+      buckets.push_back( make_pair( first[ r ], first[ r+1 ] ) );
     }
   }
+  std::sort( buckets.begin(), buckets.end(), LargerBucket );
 
-  memcpy( ((char*)m_index) + sizeof( INDEX ) * start,
-          ((char*)m_buffer), sizeof( INDEX ) * (end-start+1) );
+  size_t nextBucket = 0;
+  boost::mutex mutex;
+  boost::thread_group threads;
+  for( size_t t=0; t<m_threads; t++ ) {
+    threads.create_thread( boost::bind( &SuffixArray::SortBuckets, this, boost::cref( buckets ), &nextBucket, &mutex ) );
+  }
+  threads.join_all();
+
+  vector< WORD_ID >().swap( m_rank );
+}
+
+void SuffixArray::SortBuckets( const vector< pair< INDEX, INDEX > > &buckets, size_t *next, boost::mutex *mutex )
+{
+  while( true ) {
+    size_t b;
+    {
+      boost::mutex::scoped_lock lock( *mutex );
+      if (*next == buckets.size()) return;
+      b = (*next)++;
+    }
+    std::sort( m_index + buckets[ b ].first, m_index + buckets[ b ].second, SuffixLess( *this ) );
+  }
 }
 
 int SuffixArray::CompareIndex( INDEX a, INDEX b ) const
@@ -226,6 +266,22 @@ int SuffixArray::CompareIndex( INDEX a, INDEX b ) const
   return CompareWord( m_array[ a+offset ], m_array[ b+offset ] );
 }
 
+// same as CompareIndex(), but words are compared by m_rank, which only
+// exists during Sort()
+int SuffixArray::CompareIndexByRank( INDEX a, INDEX b ) const
+{
+  INDEX offset = 0;
+  while( a+offset < m_size &&
+         b+offset < m_size &&
+         m_array[ a+offset ] == m_array[ b+offset ] ) {
+    offset++;
+  }
+
+  if( a+offset == m_size ) return -1;
+  if( b+offset == m_size ) return 1;
+  return m_rank[ m_array[ a+offset ] ] < m_rank[ m_array[ b+offset ] ] ? -1 : 1;
+}
+
 inline int SuffixArray::CompareWord( WORD_ID a, WORD_ID b ) const
 {
   return m_vcb.GetWord(a).compare( m_vcb.GetWord(b) );
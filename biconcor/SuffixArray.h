@@ -2,6 +2,8 @@
 
 #include "Vocabulary.h"
 
+#include <boost/thread/mutex.hpp>
+
 class SuffixArray
 {
 public:
@@ -10,7 +12,6 @@ public:
 private:
   WORD_ID *m_array;
   INDEX *m_index;
-  INDEX *m_buffer;
   char *m_wordInSentence;
   INDEX *m_sentence;
   char *m_sentenceLength;
@@ -24,6 +25,13 @@ private:
   Vocabulary m_vcb;
   INDEX m_size;
   INDEX m_sentenceCount;
+  std::vector< WORD_ID > m_rank; // of each word in sorted order, while sorting
+  size_t m_threads;
+
+  class SuffixLess;
+
+  void SortBuckets( const std::vector< std::pair< INDEX, INDEX > > &buckets, size_t *next, boost::mutex *mutex );
+  int CompareIndexByRank( INDEX a, INDEX b ) const;
 
   // No copying allowed.
   SuffixArray(const SuffixArray&);
@@ -35,7 +43,7 @@ public:
 
   void Create(const std::string& fileName );
   bool ProcessDocumentLine( const char* const, const size_t );
-  void Sort(INDEX start, INDEX end);
+  void Sort();
   int CompareIndex( INDEX a, INDEX b ) const;
   inline int CompareWord( WORD_ID a, WORD_ID b ) const;
   int Count( const std::vector< WORD > &phrase );
@@ -69,6 +77,9 @@ public:
   void UseDocument() {
     m_useDocument = true;
   }
+  void SetThreads( size_t threads ) {
+    m_threads = threads;
+  }
   INDEX GetDocument( INDEX sentence ) const;
   void PrintDocumentName( INDEX document ) {
     for(INDEX i=m_documentName[ document ]; m_documentNameBuffer[i] != 0; i++) {
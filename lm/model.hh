@@ -75,6 +75,15 @@ template <class Search, class VocabularyT> class GenericModel : public base::Mod
      */
     void GetState(const WordIndex *context_rbegin, const WordIndex *context_rend, State &out_state) const;
 
+    /* Issue software prefetches for the table entries that scoring new_word
+     * after the context will need, without doing the lookup.  Call this for a
+     * batch of queries before scoring them so that their cache misses
+     * overlap.
+     */
+    void Prefetch(const WordIndex *context_rbegin, const WordIndex *context_rend, const WordIndex new_word) const {
+      search_.Prefetch(context_rbegin, context_rend, new_word);
+    }
+
     /* More efficient version of FullScore where a partial n-gram has already
      * been scored.
      * NOTE: THE RETURNED .rest AND .prob ARE RELATIVE TO THE .rest RETURNED BEFORE.
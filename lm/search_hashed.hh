@@ -136,6 +136,23 @@ template <class Value> class HashedSearch {
       return true;
     }
 
+    // Hint the cache about the buckets a later lookup of new_word after
+    // context (most recent word first) will probe.  Keys only depend on the
+    // words, so this touches no table memory itself.
+    void Prefetch(const WordIndex *context_rbegin, const WordIndex *context_rend, WordIndex new_word) const {
+      __builtin_prefetch(&unigram_.Lookup(new_word), 0, 1);
+      Node node = static_cast<Node>(new_word);
+      unsigned char order_minus_2 = 0;
+      for (const WordIndex *i = context_rbegin; i != context_rend; ++i, ++order_minus_2) {
+        node = CombineWordHash(node, *i);
+        if (order_minus_2 == middle_.size()) {
+          __builtin_prefetch(&*longest_.Ideal(node), 0, 1);
+          return;
+        }
+        __builtin_prefetch(&*middle_[order_minus_2].Ideal(node), 0, 1);
+      }
+    }
+
   private:
     // Interpret config's rest cost build policy and pass the right template argument to ApplyBuild.
     void DispatchBuild(util::FilePiece &f, const std::vector<uint64_t> &counts, const Config &config, const ProbingVocabulary &vocab, PositiveProbWarn &warn);
@@ -88,6 +88,11 @@ template <class Quant, class Bhiksha> class TrieSearch {
       return LongestPointer(quant_, longest_.Find(word, node));
     }
 
+    // Only the unigram position is known without walking the trie.
+    void Prefetch(const WordIndex * /*context_rbegin*/, const WordIndex * /*context_rend*/, WordIndex new_word) const {
+      __builtin_prefetch(&unigram_.Lookup(new_word), 0, 1);
+    }
+
     bool FastMakeNode(const WordIndex *begin, const WordIndex *end, Node &node) const {
       assert(begin != end);
       bool independent_left;
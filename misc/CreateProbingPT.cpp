@@ -1,3 +1,5 @@
+#include <cstdlib>
+
 #include "util/usage.hh"
 #include "moses/TranslationModel/ProbingPT/storing.hh"
 
@@ -7,21 +9,30 @@ int main(int argc, char* argv[])
 {
 
   const char * is_reordering = "false";
+  int num_threads = 1;
 
-  if (!(argc == 5 || argc == 4)) {
+  if (!(argc == 6 || argc == 5 || argc == 4)) {
     // Tell the user how to run the program
-    std::cerr << "Provided " << argc << " arguments, needed 4 or 5." << std::endl;
-    std::cerr << "Usage: " << argv[0] << " path_to_phrasetable output_dir num_scores is_reordering" << std::endl;
+    std::cerr << "Provided " << argc << " arguments, needed 4, 5 or 6." << std::endl;
+    std::cerr << "Usage: " << argv[0] << " path_to_phrasetable output_dir num_scores is_reordering [num_threads]" << std::endl;
     std::cerr << "is_reordering should be either true or false, but it is currently a stub feature." << std::endl;
+    std::cerr << "With num_threads > 1 the phrase table is counted and encoded in parallel; the output is the same." << std::endl;
     //std::cerr << "Usage: " << argv[0] << " path_to_phrasetable number_of_uniq_lines output_bin_file output_hash_table output_vocab_id" << std::endl;
     return 1;
   }
 
-  if (argc == 5) {
+  if (argc >= 5) {
     is_reordering = argv[4];
   }
+  if (argc == 6) {
+    num_threads = atoi(argv[5]);
+  }
 
-  createProbingPT(argv[1], argv[2], argv[3], is_reordering);
+  if (num_threads > 1) {
+    createProbingPTParallel(argv[1], argv[2], argv[3], is_reordering, num_threads);
+  } else {
+    createProbingPT(argv[1], argv[2], argv[3], is_reordering);
+  }
 
   util::PrintUsage(std::cout);
   return 0;
@@ -0,0 +1,60 @@
+// Convert a Moses-format text rule table into the binary image read by
+// PhraseDictionaryMemoryImage.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "moses/TranslationModel/RuleTable/RuleTableImageWriter.h"
+#include "util/exception.hh"
+#include "util/file_piece.hh"
+#include "util/usage.hh"
+
+int main(int argc, char* argv[])
+{
+  size_t sourceFactors = 0;
+  if (argc > 2 && !strcmp(argv[1], "--source-factors")) {
+    sourceFactors = atoi(argv[2]);
+    argv += 2;
+    argc -= 2;
+  }
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " [--source-factors N] rule_table num_scores output_image" << std::endl;
+    std::cerr << "rule_table is a text phrase or rule table in Moses format, optionally gzipped." << std::endl;
+    std::cerr << "--source-factors N keeps only the first N factors of each source word; use it when" << std::endl;
+    std::cerr << "the table's source words have more factors than the phrase table's input-factor." << std::endl;
+    std::cerr << "Use it with: PhraseDictionaryMemoryImage path=output_image num-features=num_scores ..." << std::endl;
+    return 1;
+  }
+
+  try {
+    Moses::RuleTableImageWriter writer(atoi(argv[2]), sourceFactors);
+    util::FilePiece in(argv[1], &std::cerr);
+    size_t skipped = 0;
+    while (true) {
+      StringPiece line;
+      try {
+        line = in.ReadLine();
+      } catch (const util::EndOfFileException &e) {
+        break;
+      }
+      if (!writer.AddRule(line)) {
+        ++skipped;
+      }
+    }
+    writer.Write(argv[3]);
+    std::cerr << "Wrote " << writer.GetNumRules() << " rules in " << writer.GetNumNodes()
+              << " trie nodes to " << argv[3];
+    if (skipped) {
+      std::cerr << ", skipped " << skipped << " rules with an empty source side";
+    }
+    std::cerr << std::endl;
+  } catch (const util::Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  util::PrintUsage(std::cerr);
+  return 0;
+}
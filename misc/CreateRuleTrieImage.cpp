@@ -0,0 +1,58 @@
+// Convert a text rule table for the syntax decoders (S2T, T2S and F2S) into
+// the binary image that RuleTableFF maps instead of loading the text.  With
+// an image the decoder starts quickly and reads each input's lexical rules
+// on demand.  The S2T CYK+ parser matches against the image in place; for
+// the other algorithms the rules are still built into in-memory tries.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "moses/Syntax/RuleTrieImageWriter.h"
+#include "util/exception.hh"
+#include "util/file_piece.hh"
+#include "util/usage.hh"
+
+using namespace Moses::Syntax;
+
+int main(int argc, char* argv[])
+{
+  bool treeSource = (argc > 1 && !strcmp(argv[1], "--tree"));
+  if (argc - treeSource != 4) {
+    std::cerr << "Usage: " << argv[0] << " [--tree] rule_table num_scores output_image" << std::endl;
+    std::cerr << "rule_table is a text rule table in Moses format, optionally gzipped." << std::endl;
+    std::cerr << "Use --tree if its source sides are tree fragments, as for -search-algorithm 7 or 9 (T2S and F2S);" << std::endl;
+    std::cerr << "leave it out for string source sides, as for 6 or 8 (S2T and T2S with SCFG rules)." << std::endl;
+    std::cerr << "Use it with: RuleTable path=output_image num-features=num_scores ..." << std::endl;
+    return 1;
+  }
+  const char *inPath = argv[1 + treeSource];
+  const char *numScores = argv[2 + treeSource];
+  const char *outPath = argv[3 + treeSource];
+
+  try {
+    RuleTrieImageWriter writer(atoi(numScores),
+                               treeSource ? RuleTrieImageFormat::TreeSource
+                               : RuleTrieImageFormat::StringSource);
+    util::FilePiece in(inPath, &std::cerr);
+    while (true) {
+      StringPiece line;
+      try {
+        line = in.ReadLine();
+      } catch (const util::EndOfFileException &e) {
+        break;
+      }
+      writer.AddRule(line);
+    }
+    writer.Write(outPath);
+    std::cerr << "Wrote " << writer.GetNumRules() << " rules to " << outPath
+              << std::endl;
+  } catch (const util::Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  util::PrintUsage(std::cerr);
+  return 0;
+}
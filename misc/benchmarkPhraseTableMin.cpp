@@ -0,0 +1,91 @@
+// Time lookups in binary phrase tables.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "moses/TranslationModel/CompactPT/PhraseDictionaryCompact.h"
+#include "moses/Util.h"
+#include "moses/Phrase.h"
+#include "moses/Timer.h"
+#include "moses/parameters/AllOptions.h"
+
+void usage();
+
+using namespace Moses;
+
+int main(int argc, char **argv)
+{
+  int nscores = 4;
+  std::string ttable = "";
+  size_t limit = 0;
+
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-n")) {
+      if(i + 1 == argc)
+        usage();
+      nscores = atoi(argv[++i]);
+    } else if(!strcmp(argv[i], "-t")) {
+      if(i + 1 == argc)
+        usage();
+      ttable = argv[++i];
+    } else if(!strcmp(argv[i], "-l")) {
+      if(i + 1 == argc)
+        usage();
+      limit = atoi(argv[++i]);
+    } else
+      usage();
+  }
+
+  if(ttable == "")
+    usage();
+
+  std::vector<FactorType> input(1, 0);
+
+  std::stringstream ss;
+  ss << "PhraseDictionaryCompact input-factor=0 output-factor=0 num-features=" << nscores
+     << " path=" << ttable << " table-limit=" << limit;
+  if(limit)
+    ss << " best-first=true";
+  PhraseDictionaryCompact pdc(ss.str());
+  AllOptions::ptr opts(new AllOptions);
+  pdc.Load(opts);
+
+  std::vector<Phrase> sourcePhrases;
+  std::string line;
+  while(getline(std::cin, line)) {
+    sourcePhrases.push_back(Phrase());
+    sourcePhrases.back().CreateFromString(Input, input, line, NULL);
+  }
+
+  Timer timer;
+  timer.start();
+  size_t found = 0, targetPhrases = 0;
+  for(size_t i = 0; i < sourcePhrases.size(); i++) {
+    TargetPhraseVectorPtr decodedPhraseColl
+    = pdc.GetTargetPhraseCollectionRaw(sourcePhrases[i]);
+    if(decodedPhraseColl != NULL) {
+      found++;
+      targetPhrases += decodedPhraseColl->size();
+    }
+  }
+  double seconds = timer.get_elapsed_time();
+
+  std::cout << sourcePhrases.size() << " lookups (" << found << " found, "
+            << targetPhrases << " target phrases) in " << seconds << " seconds, "
+            << (seconds ? sourcePhrases.size() / seconds : 0) << " lookups per second"
+            << std::endl;
+}
+
+void usage()
+{
+  std::cerr << 	"Usage: benchmarkPhraseTableMin [-n <nscores>] [-l <limit>] -t <ttable> < phrases\n"
+            "Looks up each source phrase read from stdin once and reports lookups per second.\n"
+            "-n <nscores>      number of scores in phrase table (default: 4)\n"
+            "-l <limit>        decode only the first <limit> target phrases (best-first)\n"
+            "-t <ttable>       phrase table\n";
+  exit(1);
+}
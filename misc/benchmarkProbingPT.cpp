@@ -0,0 +1,109 @@
+// Time the lookups of all spans of sentences in a ProbingPT table, one span at
+// a time or a sentence at a time with the batch API.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "moses/TranslationModel/ProbingPT/quering.hh"
+#include "moses/Timer.h"
+#include "util/file.hh"
+#include "util/tokenize_piece.hh"
+
+void usage();
+
+// Ask the kernel to drop the table from the page cache, so that lookups start
+// from disk like for a table that does not fit in memory.
+void dropFromCache(const std::string &path)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(path.c_str()));
+  posix_fadvise(file.get(), 0, 0, POSIX_FADV_DONTNEED);
+}
+
+int main(int argc, char **argv)
+{
+  std::string table = "";
+  size_t maxLength = 7;
+  bool batch = false, cold = false;
+
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-l")) {
+      if(i + 1 == argc)
+        usage();
+      maxLength = atoi(argv[++i]);
+    } else if(!strcmp(argv[i], "-b")) {
+      batch = true;
+    } else if(!strcmp(argv[i], "-c")) {
+      cold = true;
+    } else if(table == "") {
+      table = argv[i];
+    } else
+      usage();
+  }
+
+  if(table == "")
+    usage();
+
+  // source phrases of every span, with the vocabulary ids of QueryEngine::query
+  std::vector<std::vector<std::vector<uint64_t> > > sentences;
+  std::string line;
+  while(getline(std::cin, line)) {
+    std::vector<uint64_t> words = getVocabIDs(StringPiece(line));
+    sentences.push_back(std::vector<std::vector<uint64_t> >());
+    for(size_t start = 0; start < words.size(); start++)
+      for(size_t end = start + 1; end <= words.size() && end - start <= maxLength; end++)
+        sentences.back().push_back(std::vector<uint64_t>(words.begin() + start, words.begin() + end));
+  }
+
+  if(cold) {
+    dropFromCache(table + "/probing_hash.dat");
+    dropFromCache(table + "/binfile.dat");
+  }
+  QueryEngine engine(table.c_str());
+
+  Moses::Timer timer;
+  timer.start();
+  size_t lookups = 0, found = 0, targetPhrases = 0;
+  std::vector<uint64_t> keys;
+  std::vector<const Entry *> entries;
+  std::vector<target_text> targets;
+  for(size_t s = 0; s < sentences.size(); s++) {
+    const std::vector<std::vector<uint64_t> > &spans = sentences[s];
+    lookups += spans.size();
+    // a batch holds all spans of the sentence, or a single span
+    size_t batchSize = batch ? spans.size() : 1;
+    for(size_t begin = 0; begin < spans.size(); begin += batchSize) {
+      size_t end = std::min(begin + batchSize, spans.size());
+      keys.clear();
+      for(size_t i = begin; i < end; i++)
+        keys.push_back(QueryEngine::getKey(spans[i]));
+      engine.findBatch(keys, entries);
+      for(size_t i = 0; i < entries.size(); i++) {
+        if(entries[i]) {
+          found++;
+          targetPhrases += engine.decode(*entries[i], targets);
+        }
+      }
+    }
+  }
+  double seconds = timer.get_elapsed_time();
+
+  std::cout << lookups << " lookups (" << found << " found, "
+            << targetPhrases << " target phrases) in " << seconds << " seconds, "
+            << (seconds ? lookups / seconds : 0) << " lookups per second"
+            << std::endl;
+}
+
+void usage()
+{
+  std::cerr << 	"Usage: benchmarkProbingPT [-b] [-c] [-l <length>] <table> < sentences\n"
+            "Looks up every span of the sentences read from stdin and reports lookups per second.\n"
+            "-b                look up the spans of a sentence with one batch query\n"
+            "-c                drop the table from the page cache first (cold start)\n"
+            "-l <length>       maximum span length (default: 7)\n";
+  exit(1);
+}
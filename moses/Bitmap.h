@@ -50,10 +50,12 @@ typedef unsigned long WordsBitmapID;
 class Bitmap
 {
   friend std::ostream& operator<<(std::ostream& out, const Bitmap& bitmap);
+  friend class Bitmaps;
 private:
   std::vector<char> m_bitmap; //! Ticks of words in sentence that have been done.
   size_t m_firstGap; //! Cached position of first gap, or NOT_FOUND.
   size_t m_numWordsCovered;
+  size_t m_index; //! Dense number given by the Bitmaps factory, or NOT_FOUND.
 
   Bitmap(); // not implemented
   Bitmap& operator= (const Bitmap& other);
@@ -106,6 +108,12 @@ public:
 
   explicit Bitmap(const Bitmap &copy, const Range &range);
 
+  /** contiguous number of this coverage within its Bitmaps collection,
+   *  for arrays indexed by coverage. NOT_FOUND if not made by Bitmaps */
+  size_t GetIndex() const {
+    return m_index;
+  }
+
   //! Count of words translated.
   size_t GetNumWordsCovered() const {
     return m_numWordsCovered;
@@ -8,7 +8,9 @@ namespace Moses
 {
 Bitmaps::Bitmaps(size_t inputSize, const std::vector<bool> &initSourceCompleted)
 {
-  m_initBitmap = new Bitmap(inputSize, initSourceCompleted);
+  Bitmap *initBitmap = new Bitmap(inputSize, initSourceCompleted);
+  initBitmap->m_index = 0;
+  m_initBitmap = initBitmap;
   m_coll[m_initBitmap];
 }
 
@@ -26,6 +28,7 @@ const Bitmap &Bitmaps::GetNextBitmap(const Bitmap &bm, const Range &range)
 
   Coll::const_iterator iter = m_coll.find(newBM);
   if (iter == m_coll.end()) {
+    newBM->m_index = m_coll.size();
     m_coll[newBM] = NextBitmaps();
     return *newBM;
   } else {
@@ -27,6 +27,11 @@ public:
   }
   const Bitmap &GetBitmap(const Bitmap &bm, const Range &range);
 
+  //! number of distinct coverages so far; Bitmap::GetIndex() is below this
+  size_t size() const {
+    return m_coll.size();
+  }
+
 };
 
 }
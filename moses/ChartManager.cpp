@@ -28,6 +28,7 @@
 #include "HypergraphOutput.h"
 #include "StaticData.h"
 #include "DecodeStep.h"
+#include "ThreadPool.h"
 #include "TreeInput.h"
 #include "moses/FF/StatefulFeatureFunction.h"
 #include "moses/FF/WordPenaltyProducer.h"
@@ -47,15 +48,132 @@ extern bool g_mosesDebug;
  * \param source the sentence to be decoded
  * \param system which particular set of models to use.
  */
+namespace
+{
+#ifdef WITH_THREADS
+//! m_taskStats points at stats owned by a CellTask
+void KeepStats(SentenceStats *)
+{
+}
+#endif
+}
+
 ChartManager::ChartManager(ttasksptr const& ttask)
   : BaseManager(ttask)
   , m_hypoStackColl(m_source, *this)
+#ifdef WITH_THREADS
+  , m_taskStats(&KeepStats)
+#endif
   , m_start(clock())
   , m_hypothesisId(0)
   , m_parser(ttask, m_hypoStackColl)
   , m_translationOptionList(ttask->options()->syntax.rule_limit, m_source)
 { }
 
+/** Decodes a chart cell, once the translation options for its span have been
+ *  collected. Cells of the same width only read the finished cells inside
+ *  them, so their tasks can run concurrently. Counts go to the task's own
+ *  SentenceStats, which ChartManager::DecodeWidth() adds up afterwards.
+ */
+class ChartManager::CellTask : public Task
+{
+public:
+#ifdef WITH_THREADS
+  //! counts the tasks of a width that have not finished yet
+  class Batch
+  {
+  public:
+    Batch(size_t size) : m_pending(size) {}
+
+    void Done() {
+      boost::mutex::scoped_lock lock(m_mutex);
+      if (--m_pending == 0) m_done.notify_all();
+    }
+
+    void Wait() {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (m_pending) m_done.wait(lock);
+    }
+
+  private:
+    boost::mutex m_mutex;
+    boost::condition_variable m_done;
+    size_t m_pending;
+  };
+#endif
+
+  CellTask(ChartManager &manager, const Range &range)
+    : m_manager(manager)
+    , m_range(range)
+    , m_transOptList(manager.options()->syntax.rule_limit, manager.m_source)
+    , m_stats(manager.m_source)
+#ifdef WITH_THREADS
+    , m_batch(NULL)
+#endif
+  {
+  }
+
+  ChartTranslationOptionList &GetTranslationOptionList() {
+    return m_transOptList;
+  }
+
+  const SentenceStats &GetSentenceStats() const {
+    return m_stats;
+  }
+
+  //! what went wrong in Run(), if anything
+  const std::string &GetError() const {
+    return m_error;
+  }
+
+#ifdef WITH_THREADS
+  void SetBatch(Batch *batch) {
+    m_batch = batch;
+  }
+#endif
+
+  void Run() {
+#ifdef WITH_THREADS
+    Finish finish(*this);
+    m_manager.m_taskStats.reset(&m_stats);
+#endif
+    // errors are reported by DecodeWidth(), in the decoder's own thread
+    try {
+      ChartCell &cell = m_manager.m_hypoStackColl.Get(m_range);
+      cell.Decode(m_transOptList, m_manager.m_hypoStackColl);
+
+      m_transOptList.Clear();
+      cell.PruneToSize();
+      cell.CleanupArcList();
+      cell.SortHypotheses();
+    } catch (const std::exception &e) {
+      m_error = e.what();
+    }
+  }
+
+private:
+#ifdef WITH_THREADS
+  //! on leaving Run(), however that happens
+  struct Finish {
+    CellTask &task;
+    Finish(CellTask &t) : task(t) {}
+    ~Finish() {
+      task.m_manager.m_taskStats.release();
+      if (task.m_batch) task.m_batch->Done();
+    }
+  };
+#endif
+
+  ChartManager &m_manager;
+  Range m_range;
+  ChartTranslationOptionList m_transOptList;
+  SentenceStats m_stats;
+  std::string m_error;
+#ifdef WITH_THREADS
+  Batch *m_batch;
+#endif
+};
+
 ChartManager::~ChartManager()
 {
   clock_t end = clock();
@@ -78,32 +196,54 @@ void ChartManager::Decode()
 
   AddXmlChartOptions();
 
-  // MAIN LOOP
   size_t size = m_source.GetSize();
-  for (int startPos = size-1; startPos >= 0; --startPos) {
-    for (size_t width = 1; width <= size-startPos; ++width) {
-      size_t endPos = startPos + width - 1;
-      Range range(startPos, endPos);
-
-      // create trans opt
-      m_translationOptionList.Clear();
-      m_parser.Create(range, m_translationOptionList);
-      m_translationOptionList.ApplyThreshold(options()->search.trans_opt_threshold);
-
-      const InputPath &inputPath = m_parser.GetInputPath(range);
-      m_translationOptionList.EvaluateWithSourceContext(m_source, inputPath);
-
-      // decode
-      ChartCell &cell = m_hypoStackColl.Get(range);
-      cell.Decode(m_translationOptionList, m_hypoStackColl);
-
-      m_translationOptionList.Clear();
-      cell.PruneToSize();
-      cell.CleanupArcList();
-      cell.SortHypotheses();
+  size_t threads = options()->syntax.cell_threads;
+  if (threads > 1 && !m_parser.SupportsWidthOrder()) {
+    VERBOSE(1, "A rule table needs the spans in the default order, "
+            "decoding the cells on one thread" << endl);
+    threads = 1;
+  }
+  if (threads > 1) {
+#ifdef WITH_THREADS
+    // no point in more threads than cells of width 1
+    m_cellPool.reset(new ThreadPool(std::min(threads, size)));
+#endif
+    for (size_t width = 1; width <= size; ++width) {
+      DecodeWidth(width);
+    }
+#ifdef WITH_THREADS
+    m_cellPool.reset();
+#endif
+  } else {
+    // MAIN LOOP
+    for (int startPos = size-1; startPos >= 0; --startPos) {
+      for (size_t width = 1; width <= size-startPos; ++width) {
+        size_t endPos = startPos + width - 1;
+        Range range(startPos, endPos);
+
+        // create trans opt
+        m_translationOptionList.Clear();
+        m_parser.Create(range, m_translationOptionList);
+        m_translationOptionList.ApplyThreshold(options()->search.trans_opt_threshold);
+
+        const InputPath &inputPath = m_parser.GetInputPath(range);
+        m_translationOptionList.EvaluateWithSourceContext(m_source, inputPath);
+
+        // decode
+        ChartCell &cell = m_hypoStackColl.Get(range);
+        cell.Decode(m_translationOptionList, m_hypoStackColl);
+
+        m_translationOptionList.Clear();
+        cell.PruneToSize();
+        cell.CleanupArcList();
+        cell.SortHypotheses();
+      }
     }
   }
 
+  VERBOSE(2, "Hypotheses scored: " << m_sentenceStats->GetTotalHypos()
+          << ", popped: " << m_sentenceStats->GetNumHyposPopped() << endl);
+
   IFVERBOSE(1) {
 
     for (size_t startPos = 0; startPos < size; ++startPos) {
@@ -125,6 +265,45 @@ void ChartManager::Decode()
   }
 }
 
+/** decode the cells of all spans of the given width on m_cellPool. The rules
+ *  are looked up one span after the other first: rule lookup keeps state
+ *  across spans.
+ */
+void ChartManager::DecodeWidth(size_t width)
+{
+  std::vector<boost::shared_ptr<CellTask> > tasks;
+  for (size_t startPos = 0; startPos + width <= m_source.GetSize(); ++startPos) {
+    Range range(startPos, startPos + width - 1);
+    boost::shared_ptr<CellTask> task(new CellTask(*this, range));
+    ChartTranslationOptionList &transOptList = task->GetTranslationOptionList();
+
+    m_parser.Create(range, transOptList);
+    transOptList.ApplyThreshold(options()->search.trans_opt_threshold);
+
+    const InputPath &inputPath = m_parser.GetInputPath(range);
+    transOptList.EvaluateWithSourceContext(m_source, inputPath);
+    tasks.push_back(task);
+  }
+
+#ifdef WITH_THREADS
+  CellTask::Batch batch(tasks.size());
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    tasks[i]->SetBatch(&batch);
+    m_cellPool->Submit(tasks[i]);
+  }
+  batch.Wait();
+#else
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    tasks[i]->Run();
+  }
+#endif
+
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    UTIL_THROW_IF2(!tasks[i]->GetError().empty(), tasks[i]->GetError());
+    m_sentenceStats->Add(tasks[i]->GetSentenceStats());
+  }
+}
+
 /** add specific translation options and hypotheses according to the XML override translation scheme.
  *  Doesn't seem to do anything about walls and zones.
  *  @todo check walls & zones. Check that the implementation doesn't leak, xml options sometimes does if you're not careful
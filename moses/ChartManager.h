@@ -22,7 +22,12 @@
 #pragma once
 
 #include <vector>
+#include <boost/atomic.hpp>
 #include <boost/unordered_map.hpp>
+#include <boost/scoped_ptr.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#endif
 #include "ChartCell.h"
 #include "ChartCellCollection.h"
 #include "Range.h"
@@ -38,6 +43,7 @@ namespace Moses
 
 class ChartHypothesis;
 class ChartSearchGraphWriter;
+class ThreadPool;
 
 /** Holds everything you need to decode 1 sentence with the hierachical/syntax decoder
  */
@@ -46,13 +52,20 @@ class ChartManager : public BaseManager
 private:
   ChartCellCollection m_hypoStackColl;
   std::auto_ptr<SentenceStats> m_sentenceStats;
+#ifdef WITH_THREADS
+  boost::thread_specific_ptr<SentenceStats> m_taskStats; /**< stats of the cell being decoded by this thread, if any; not owned */
+  boost::scoped_ptr<ThreadPool> m_cellPool; /**< decodes the cells of a width, while Decode() runs with cell-threads > 1 */
+#endif
   clock_t m_start; /**< starting time, used for logging */
-  unsigned m_hypothesisId; /* For handing out hypothesis ids to ChartHypothesis */
+  boost::atomic<unsigned> m_hypothesisId; /* For handing out hypothesis ids to ChartHypothesis */
 
   ChartParser m_parser;
 
   ChartTranslationOptionList m_translationOptionList; /**< pre-computed list of translation options for the phrases in this sentence */
 
+  class CellTask;
+  void DecodeWidth(size_t width);
+
   /* auxilliary functions for SearchGraphs */
   void FindReachableHypotheses(
     const ChartHypothesis *hypo, std::map<unsigned,bool> &reachable , size_t* winners, size_t* losers) const;
@@ -116,6 +129,11 @@ public:
 
   //! debug data collected when decoding sentence
   SentenceStats& GetSentenceStats() const {
+#ifdef WITH_THREADS
+    if (SentenceStats *stats = m_taskStats.get()) {
+      return *stats;
+    }
+#endif
     return *m_sentenceStats;
   }
 
@@ -231,6 +231,17 @@ void ChartParser::Create(const Range &range, ChartParserCallback &to)
   }
 }
 
+bool ChartParser::SupportsWidthOrder() const
+{
+  std::vector<ChartRuleLookupManager*>::const_iterator iter;
+  for (iter = m_ruleLookupManagers.begin(); iter != m_ruleLookupManagers.end(); ++iter) {
+    if (!(*iter)->SupportsWidthOrder()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void ChartParser::CreateInputPaths(const InputType &input)
 {
   size_t size = input.GetSize();
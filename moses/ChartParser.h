@@ -69,6 +69,9 @@ public:
 
   void Create(const Range &range, ChartParserCallback &to);
 
+  //! true if Create() may be called for the spans width by width
+  bool SupportsWidthOrder() const;
+
   //! the sentence being decoded
   //const Sentence &GetSentence() const;
   long GetTranslationId() const;
@@ -69,6 +69,16 @@ public:
     size_t lastPos,  // last position to consider if using lookahead
     ChartParserCallback &outColl) = 0;
 
+  /** Whether GetChartRuleCollection() can be called for the spans of a
+   *  sentence width by width, i.e. once all shorter spans are decoded. The
+   *  default is no: the spans are visited in the order of
+   *  ChartManager::Decode(), right to left by start position and then by
+   *  increasing width, and lookups may rely on that.
+   */
+  virtual bool SupportsWidthOrder() const {
+    return false;
+  }
+
 private:
   //! Non-copyable: copy constructor and assignment operator not implemented.
   ChartRuleLookupManager(const ChartRuleLookupManager &);
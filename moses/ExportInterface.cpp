@@ -28,6 +28,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <sstream>
 #include <vector>
 
+#include <boost/scoped_ptr.hpp>
+
 #include "util/random.hh"
 #include "util/usage.hh"
 
@@ -195,7 +197,9 @@ batch_run()
   }
 
 #ifdef WITH_THREADS
-  ThreadPool pool(staticData.ThreadCount());
+  std::string scheduler;
+  params.SetParameter(scheduler, "thread-scheduler", string("fifo"));
+  boost::scoped_ptr<TaskScheduler> pool(CreateTaskScheduler(scheduler, staticData.ThreadCount()));
 #endif
 
   // using context for adaptation:
@@ -279,9 +283,9 @@ batch_run()
         VERBOSE(1,"[" << HERE << " added trg] " << trg << endl);
         VERBOSE(1,"[" << HERE << " added aln] " << aln << endl);
       }
-    } else pool.Submit(task);
+    } else pool->Submit(task);
 #else
-    pool.Submit(task);
+    pool->Submit(task);
 
 #endif
 #else
@@ -291,7 +295,7 @@ batch_run()
 
   // we are done, finishing up
 #ifdef WITH_THREADS
-  pool.Stop(true); //flush remaining jobs
+  pool->Stop(true); //flush remaining jobs
 #endif
 
   FeatureFunction::Destroy();
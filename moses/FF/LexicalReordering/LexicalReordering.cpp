@@ -15,6 +15,13 @@ using namespace boost::algorithm;
 
 namespace Moses
 {
+
+namespace
+{
+// default cache-size: phrase pairs whose scores are kept between sentences
+const size_t DEFAULT_REORDERING_CACHE_SIZE = 100000;
+}
+
 LexicalReordering::
 LexicalReordering(const std::string &line)
   : StatefulFeatureFunction(line,false)
@@ -23,6 +30,7 @@ LexicalReordering(const std::string &line)
 
   map<string,string> sparseArgs;
   m_haveDefaultScores = false;
+  size_t cacheSize = DEFAULT_REORDERING_CACHE_SIZE;
   for (size_t i = 0; i < m_args.size(); ++i) {
     const vector<string> &args = m_args[i];
 
@@ -43,6 +51,9 @@ LexicalReordering(const std::string &line)
       for(size_t i=0; i<tokens.size(); i++)
         m_defaultScores.push_back( TransformScore( Scan<float>(tokens[i])));
       m_haveDefaultScores = true;
+    } else if (args[0] == "cache-size") {
+      // 0 = no cache, look up the table for every translation option
+      cacheSize = Scan<size_t>(args[1]);
     } else UTIL_THROW2("Unknown argument " + args[0]);
   }
 
@@ -75,12 +86,20 @@ LexicalReordering(const std::string &line)
                  << m_configuration->GetNumScoreComponents() << ")");
 
   m_configuration->ConfigureSparse(sparseArgs, this);
+  if (cacheSize) m_cache.reset(new ReorderingScoreCache(cacheSize));
   // this->Register();
 }
 
 LexicalReordering::
 ~LexicalReordering()
-{ }
+{
+  if (m_cache && (m_cache->GetHits() || m_cache->GetMisses())) {
+    VERBOSE(2, GetScoreProducerDescription() << " cache: "
+            << m_cache->GetHits() << " hits, "
+            << m_cache->GetMisses() << " misses (table lookups), "
+            << m_cache->GetEvictions() << " evictions" << std::endl);
+  }
+}
 
 void
 LexicalReordering::
@@ -142,7 +161,12 @@ SetCache(TranslationOption& to) const
   if (m_table) {
     Phrase const& sphrase = to.GetInputPath().GetPhrase();
     Phrase const& tphrase = to.GetTargetPhrase();
-    to.CacheLexReorderingScores(*this, this->GetProb(sphrase,tphrase));
+    Scores scores;
+    if (!m_cache || !m_cache->Get(sphrase, tphrase, scores)) {
+      scores = this->GetProb(sphrase,tphrase);
+      if (m_cache) m_cache->Put(sphrase, tphrase, scores);
+    }
+    to.CacheLexReorderingScores(*this, scores);
   } else { // e.g. OOV with Mmsapt
     // Scores vals(GetNumScoreComponents(), 0);
     // to.CacheLexReorderingScores(*this, vals);
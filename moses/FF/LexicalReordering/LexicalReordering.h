@@ -16,6 +16,7 @@
 
 #include "LRState.h"
 #include "LexicalReorderingTable.h"
+#include "ReorderingScoreCache.h"
 #include "SparseReordering.h"
 
 
@@ -91,6 +92,7 @@ private:
   std::string m_modelTypeString;
   std::vector<std::string> m_modelType;
   boost::scoped_ptr<LexicalReorderingTable> m_table;
+  boost::scoped_ptr<ReorderingScoreCache> m_cache; //! shared by all threads; NULL if disabled
   std::vector<LRModel::Condition> m_condition;
   std::vector<FactorType> m_factorsE, m_factorsF;
   std::string m_filePath;
@@ -0,0 +1,54 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#pragma once
+
+#include <utility>
+
+#include "moses/Phrase.h"
+#include "moses/ShardedClockCache.h"
+#include "moses/TypeDef.h"
+
+namespace Moses
+{
+
+/** Cache of lexical reordering scores shared by all decoder threads.
+ *
+ * Keyed by the (source, target) phrase pair of a translation option, so the
+ * scores of pairs that come up again in later sentences are not looked up and
+ * decoded from the reordering table again. Pairs the table has no entry for
+ * are cached with empty scores. The cache keeps a copy of both phrases, so
+ * pairs whose hashes collide never share scores.
+ */
+class ReorderingScoreCache
+{
+public:
+  ReorderingScoreCache(size_t maxEntries)
+    : m_cache(maxEntries) {
+  }
+
+  //! look up the pair; returns false on a miss
+  bool Get(const Phrase &f, const Phrase &e, Scores &out) {
+    return m_cache.Get(Key(f, e), out);
+  }
+
+  void Put(const Phrase &f, const Phrase &e, const Scores &scores) {
+    m_cache.Put(Key(f, e), scores);
+  }
+
+  size_t GetHits() const {
+    return m_cache.GetHits();
+  }
+  size_t GetMisses() const {
+    return m_cache.GetMisses();
+  }
+  size_t GetEvictions() const {
+    return m_cache.GetEvictions();
+  }
+
+private:
+  // plain phrases, so a TargetPhrase passed as e is copied without its scores
+  typedef std::pair<Phrase, Phrase> Key;
+
+  ShardedClockCache<Key, Scores> m_cache;
+};
+
+}
@@ -66,6 +66,22 @@ public:
   //! return the state associated with the empty hypothesis for a given sentence
   virtual const FFState* EmptyHypothesisState(const InputType &input) const = 0;
 
+  //! whether the phrase-based search should call PrefetchWhenApplied()
+  virtual bool UsesPrefetch() const {
+    return false;
+  }
+
+  /**
+   * Optional hook for batched evaluation in phrase-based search. Before a
+   * hypothesis is expanded with a list of translation options, this is called
+   * for every option, so that a feature can issue software prefetches for the
+   * data EvaluateWhenApplied() will look up. Must not change any state.
+   */
+  virtual void PrefetchWhenApplied(
+    const FFState* /* prev_state */,
+    const TargetPhrase& /* targetPhrase */) const {
+  }
+
   bool IsStateless() const {
     return false;
   }
@@ -20,9 +20,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
 #include <boost/version.hpp>
-#ifdef WITH_THREADS
-#include <boost/thread/locks.hpp>
-#endif
+#include <cstring>
 #include <ostream>
 #include <string>
 #include "FactorCollection.h"
@@ -35,52 +33,94 @@ namespace Moses
 {
 FactorCollection FactorCollection::s_instance;
 
-const Factor *FactorCollection::AddFactor(const StringPiece &factorString, bool isNonTerminal)
+FactorCollection::Table::Table()
+  : m_size(0)
 {
-  FactorFriend to_ins;
-  to_ins.in.m_string = factorString;
-  to_ins.in.m_id = (isNonTerminal) ? m_factorIdNonTerminal : m_factorId;
-  Set & set = (isNonTerminal) ? m_set : m_setNonTerminal;
-  // If we're threaded, hope a read-only lock is sufficient.
-#ifdef WITH_THREADS
-  {
-    // read=lock scope
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-    Set::const_iterator i = set.find(to_ins);
-    if (i != set.end()) return &i->in;
+  m_all.push_back(NewSlots(1024));
+  m_current.store(m_all.back(), boost::memory_order_release);
+}
+
+FactorCollection::Table::~Table()
+{
+  for (size_t i = 0; i < m_all.size(); ++i) {
+    delete [] m_all[i]->slot;
+    delete m_all[i];
   }
-  boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
-#endif // WITH_THREADS
-  std::pair<Set::iterator, bool> ret(set.insert(to_ins));
-  if (ret.second) {
-    ret.first->in.m_string.set(
-      memcpy(m_string_backing.Allocate(factorString.size()), factorString.data(), factorString.size()),
-      factorString.size());
-    if (isNonTerminal) {
-      m_factorIdNonTerminal++;
-      UTIL_THROW_IF2(m_factorIdNonTerminal >= moses_MaxNumNonterminals, "Number of non-terminals exceeds maximum size reserved. Adjust parameter moses_MaxNumNonterminals, then recompile");
-    } else {
-      m_factorId++;
-    }
+}
+
+FactorCollection::Table::Slots *FactorCollection::Table::NewSlots(size_t buckets)
+{
+  Slots *ret = new Slots;
+  ret->mask = buckets - 1;
+  ret->slot = new boost::atomic<const FactorFriend*>[buckets];
+  for (size_t i = 0; i < buckets; ++i) {
+    ret->slot[i].store(NULL, boost::memory_order_relaxed);
   }
-  return &ret.first->in;
+  return ret;
 }
 
-const Factor *FactorCollection::GetFactor(const StringPiece &factorString, bool isNonTerminal)
+void FactorCollection::Table::Grow()
+{
+  const Slots &from = *m_all.back();
+  Slots *to = NewSlots(2 * (from.mask + 1));
+  for (size_t i = 0; i <= from.mask; ++i) {
+    const FactorFriend *factor = from.slot[i].load(boost::memory_order_relaxed);
+    if (!factor) continue;
+    const StringPiece &str = factor->in.GetString();
+    size_t j = util::MurmurHashNative(str.data(), str.size()) & to->mask;
+    while (to->slot[j].load(boost::memory_order_relaxed)) j = (j + 1) & to->mask;
+    to->slot[j].store(factor, boost::memory_order_relaxed);
+  }
+  m_all.push_back(to);
+  // readers that still hold the old array are fine: it stays valid
+  m_current.store(to, boost::memory_order_release);
+}
+
+void FactorCollection::Table::Insert(const FactorFriend *factor, uint64_t hash)
 {
-  FactorFriend to_find;
-  to_find.in.m_string = factorString;
-  to_find.in.m_id = (isNonTerminal) ? m_factorIdNonTerminal : m_factorId;
-  Set & set = (isNonTerminal) ? m_set : m_setNonTerminal;
-  {
-    // read=lock scope
+  // keep the load factor at most 1/2 so probe sequences stay short
+  if (2 * (m_size + 1) > m_all.back()->mask + 1) Grow();
+  const Slots &s = *m_all.back();
+  size_t i = hash & s.mask;
+  while (s.slot[i].load(boost::memory_order_relaxed)) i = (i + 1) & s.mask;
+  // the factor is fully constructed before it becomes visible
+  s.slot[i].store(factor, boost::memory_order_release);
+  ++m_size;
+}
+
+const Factor *FactorCollection::AddFactor(const StringPiece &factorString, bool isNonTerminal)
+{
+  const uint64_t hash = util::MurmurHashNative(factorString.data(), factorString.size());
+  Table &set = (isNonTerminal) ? m_set : m_setNonTerminal;
+  // fast path: no locking for factors that already exist
+  const FactorFriend *found = set.Find(factorString, hash);
+  if (found) return &found->in;
 #ifdef WITH_THREADS
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
+  boost::mutex::scoped_lock lock(m_insertLock);
+  // somebody may have added it since we looked
+  found = set.Find(factorString, hash);
+  if (found) return &found->in;
 #endif // WITH_THREADS
-    Set::const_iterator i = set.find(to_find);
-    if (i != set.end()) return &i->in;
+  FactorFriend *ins = new (m_factor_backing.Allocate(sizeof(FactorFriend))) FactorFriend;
+  ins->in.m_string.set(
+    memcpy(m_string_backing.Allocate(factorString.size()), factorString.data(), factorString.size()),
+    factorString.size());
+  if (isNonTerminal) {
+    ins->in.m_id = m_factorIdNonTerminal++;
+    UTIL_THROW_IF2(m_factorIdNonTerminal >= moses_MaxNumNonterminals, "Number of non-terminals exceeds maximum size reserved. Adjust parameter moses_MaxNumNonterminals, then recompile");
+  } else {
+    ins->in.m_id = m_factorId++;
   }
-  return NULL;
+  set.Insert(ins, hash);
+  return &ins->in;
+}
+
+const Factor *FactorCollection::GetFactor(const StringPiece &factorString, bool isNonTerminal)
+{
+  const uint64_t hash = util::MurmurHashNative(factorString.data(), factorString.size());
+  const Table &set = (isNonTerminal) ? m_set : m_setNonTerminal;
+  const FactorFriend *found = set.Find(factorString, hash);
+  return found ? &found->in : NULL;
 }
 
 
@@ -89,14 +129,21 @@ FactorCollection::~FactorCollection() {}
 TO_STRING_BODY(FactorCollection);
 
 // friend
-ostream& operator<<(ostream& out, const FactorCollection& factorCollection)
+namespace
 {
-#ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(factorCollection.m_accessLock);
-#endif
-  for (FactorCollection::Set::const_iterator i = factorCollection.m_set.begin(); i != factorCollection.m_set.end(); ++i) {
-    out << i->in;
+struct PrintFactor {
+  ostream &out;
+  explicit PrintFactor(ostream &o) : out(o) {}
+  void operator()(const Factor &factor) {
+    out << factor;
   }
+};
+}
+
+ostream& operator<<(ostream& out, const FactorCollection& factorCollection)
+{
+  PrintFactor print(out);
+  factorCollection.m_set.ForEach(print);
   return out;
 }
 
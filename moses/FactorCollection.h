@@ -28,14 +28,14 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 #ifdef WITH_THREADS
-#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
 #endif
 
 #include "util/murmur_hash.hh"
-#include <boost/unordered_set.hpp>
+#include <boost/atomic.hpp>
 
-#include <functional>
 #include <string>
+#include <vector>
 
 #include "util/string_piece.hh"
 #include "util/pool.hh"
@@ -67,26 +67,70 @@ class FactorCollection
 {
   friend std::ostream& operator<<(std::ostream&, const FactorCollection&);
 
-  struct HashFactor : public std::unary_function<const FactorFriend &, std::size_t> {
-    std::size_t operator()(const FactorFriend &factor) const {
-      return util::MurmurHashNative(factor.in.m_string.data(), factor.in.m_string.size());
+  /** Open-addressing intern table that can be read without locking.
+   *
+   * Slots only ever go from empty to holding a factor, and are never
+   * changed or cleared afterwards. When the table grows, the new slot
+   * array is published with a release store and the old one is kept alive
+   * until destruction, so a concurrent reader always probes a consistent
+   * array. A reader may miss a factor that is being added at the same
+   * time; AddFactor() then re-checks under the insert lock.
+   *
+   * Insert() must be serialized by the caller.
+   */
+  class Table
+  {
+    struct Slots {
+      size_t mask;
+      boost::atomic<const FactorFriend*> *slot;
+    };
+
+    boost::atomic<Slots*> m_current;
+    std::vector<Slots*> m_all; //! every slot array ever published
+    size_t m_size;
+
+    static Slots *NewSlots(size_t buckets);
+    void Grow();
+
+  public:
+    Table();
+    ~Table();
+
+    const FactorFriend *Find(const StringPiece &str, uint64_t hash) const {
+      const Slots &s = *m_current.load(boost::memory_order_acquire);
+      for (size_t i = hash & s.mask; ; i = (i + 1) & s.mask) {
+        const FactorFriend *found = s.slot[i].load(boost::memory_order_acquire);
+        if (!found) return NULL;
+        if (found->in.GetString() == str) return found;
+      }
     }
-  };
-  struct EqualsFactor : public std::binary_function<const FactorFriend &, const FactorFriend &, bool> {
-    bool operator()(const FactorFriend &left, const FactorFriend &right) const {
-      return left.in.GetString() == right.in.GetString();
+
+    void Insert(const FactorFriend *factor, uint64_t hash);
+
+    //! call f on every factor; not safe against concurrent inserts
+    template <class F> void ForEach(F &f) const {
+      const Slots &s = *m_current.load(boost::memory_order_acquire);
+      for (size_t i = 0; i <= s.mask; ++i) {
+        const FactorFriend *factor = s.slot[i].load(boost::memory_order_relaxed);
+        if (factor) f(factor->in);
+      }
     }
+
+  private:
+    Table(const Table &);
+    Table &operator=(const Table &);
   };
-  typedef boost::unordered_set<FactorFriend, HashFactor, EqualsFactor> Set;
-  Set m_set;
-  Set m_setNonTerminal;
+
+  Table m_set;
+  Table m_setNonTerminal;
 
   util::Pool m_string_backing;
+  util::Pool m_factor_backing;
 
   static FactorCollection s_instance;
 #ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::shared_mutex m_accessLock;
+  //! serializes inserts; lookups of existing factors never take it
+  boost::mutex m_insertLock;
 #endif
 
   size_t m_factorIdNonTerminal; /**< unique, contiguous ids, starting from 0, for each non-terminal factor */
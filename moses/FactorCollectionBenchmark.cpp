@@ -0,0 +1,85 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+// AddFactor() throughput against thread count.
+// Usage: factor_collection_benchmark [max_threads] [lookups_per_thread]
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include "moses/FactorCollection.h"
+#include "moses/Util.h"
+#include "util/usage.hh"
+
+using namespace Moses;
+
+namespace
+{
+
+const size_t kVocabSize = 100000;
+
+// Mostly existing words, as in tokenized input, with one new word every
+// 1000 lookups (OOVs, placeholders).
+void Worker(const std::vector<std::string> &vocab, size_t thread, size_t lookups)
+{
+  FactorCollection &collection = FactorCollection::Instance();
+  size_t word = thread * 7919;
+  for (size_t i = 0; i < lookups; ++i) {
+    word = (word * 1103515245 + 12345) % vocab.size();
+    if (i % 1000 == 999) {
+      collection.AddFactor("oov-" + SPrint(thread) + "-" + SPrint(i));
+    } else {
+      collection.AddFactor(vocab[word]);
+    }
+  }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  size_t maxThreads = argc > 1 ? std::atoi(argv[1]) : boost::thread::hardware_concurrency();
+  size_t lookups = argc > 2 ? std::atoi(argv[2]) : 2000000;
+  if (maxThreads == 0) maxThreads = 1;
+
+  std::vector<std::string> vocab;
+  for (size_t i = 0; i < kVocabSize; ++i) {
+    vocab.push_back("word" + SPrint(i));
+    FactorCollection::Instance().AddFactor(vocab.back());
+  }
+
+  std::cout << "threads\tlookups/sec" << std::endl;
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    double start = util::WallTime();
+    boost::thread_group group;
+    for (size_t t = 0; t < threads; ++t) {
+      group.create_thread(boost::bind(&Worker, boost::cref(vocab), t, lookups));
+    }
+    group.join_all();
+    double elapsed = util::WallTime() - start;
+    std::cout << threads << "\t" << (threads * lookups) / elapsed << std::endl;
+  }
+  return 0;
+}
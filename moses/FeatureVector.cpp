@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #endif // WITH_THREADS
 
 #include "FeatureVector.h"
+#include "SimdKernels.h"
 #include "util/string_piece_hash.hh"
 #include "util/string_stream.hh"
 
@@ -166,7 +167,7 @@ FVector::FVector(size_t coreFeatures) : m_coreFeatures(coreFeatures) {}
 
 void FVector::resize(size_t newsize)
 {
-  valarray<FValue> oldValues(m_coreFeatures);
+  FCoreVector oldValues(m_coreFeatures);
   m_coreFeatures.resize(newsize);
   for (size_t i = 0; i < min(m_coreFeatures.size(), oldValues.size()); ++i) {
     m_coreFeatures[i] = oldValues[i];
@@ -370,10 +371,11 @@ FVector& FVector::operator+= (const FVector& rhs)
 {
   if (rhs.m_coreFeatures.size() > m_coreFeatures.size())
     resize(rhs.m_coreFeatures.size());
-  for (const_iterator i = rhs.cbegin(); i != rhs.cend(); ++i)
-    set(i->first, get(i->first) + i->second);
-  for (size_t i = 0; i < rhs.m_coreFeatures.size(); ++i)
-    m_coreFeatures[i] += rhs.m_coreFeatures[i];
+  if (!rhs.m_features.empty()) {
+    for (const_iterator i = rhs.cbegin(); i != rhs.cend(); ++i)
+      set(i->first, get(i->first) + i->second);
+  }
+  corePlusEquals(rhs);
   return *this;
 }
 
@@ -387,10 +389,11 @@ void FVector::sparsePlusEquals(const FVector& rhs)
 // add only core features
 void FVector::corePlusEquals(const FVector& rhs)
 {
-  if (rhs.m_coreFeatures.size() > m_coreFeatures.size())
-    resize(rhs.m_coreFeatures.size());
-  for (size_t i = 0; i < rhs.m_coreFeatures.size(); ++i)
-    m_coreFeatures[i] += rhs.m_coreFeatures[i];
+  const size_t size = rhs.m_coreFeatures.size();
+  if (size > m_coreFeatures.size())
+    resize(size);
+  if (size == 0) return;
+  simd::PlusEquals(&m_coreFeatures[0], &rhs.m_coreFeatures[0], size);
 }
 
 // assign only core features
@@ -806,11 +809,14 @@ FValue FVector::inner_product(const FVector& rhs) const
 {
   assert(m_coreFeatures.size() == rhs.m_coreFeatures.size());
   FValue product = 0.0;
-  for (const_iterator i = cbegin(); i != cend(); ++i) {
-    product += ((i->second)*(rhs.get(i->first)));
+  if (!m_features.empty() && !rhs.m_features.empty()) {
+    for (const_iterator i = cbegin(); i != cend(); ++i) {
+      product += ((i->second)*(rhs.get(i->first)));
+    }
   }
-  for (size_t i = 0; i < m_coreFeatures.size(); ++i) {
-    product += m_coreFeatures[i]*rhs.m_coreFeatures[i];
+  const size_t size = m_coreFeatures.size();
+  if (size) {
+    product += simd::InnerProduct(&m_coreFeatures[0], &rhs.m_coreFeatures[0], size);
   }
   return product;
 }
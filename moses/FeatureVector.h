@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef FEATUREVECTOR_H
 #define FEATUREVECTOR_H
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <sstream>
@@ -121,6 +122,81 @@ struct FNameHash
 
 class ProxyFVector;
 
+#if MAX_DENSE_FEATURES > 0
+/**
+ * Dense feature values stored inside the vector itself, so copying a
+ * ScoreComponentCollection never touches the heap. The subset of the
+ * std::valarray interface that FVector uses.
+ * Enabled with bjam --max-dense-features=N; N must be at least the number of
+ * dense scores of the configuration.
+ **/
+class FDenseArray
+{
+public:
+  explicit FDenseArray(size_t size = 0) : m_size(0) {
+    resize(size);
+  }
+
+  FDenseArray(const FDenseArray &copy) : m_size(copy.m_size) {
+    std::copy(copy.m_values, copy.m_values + m_size, m_values);
+  }
+
+  FDenseArray &operator=(const FDenseArray &rhs) {
+    m_size = rhs.m_size;
+    std::copy(rhs.m_values, rhs.m_values + m_size, m_values);
+    return *this;
+  }
+
+  size_t size() const {
+    return m_size;
+  }
+
+  //! as valarray::resize(), all values are set to value
+  void resize(size_t size, FValue value = FValue()) {
+    UTIL_THROW_IF2(size > MAX_DENSE_FEATURES,
+                   "This configuration has " << size << " dense features, "
+                   "rebuild with bjam --max-dense-features=" << size << " or more");
+    m_size = size;
+    std::fill(m_values, m_values + m_size, value);
+  }
+
+  FValue &operator[](size_t index) {
+    return m_values[index];
+  }
+  const FValue &operator[](size_t index) const {
+    return m_values[index];
+  }
+
+  FValue sum() const {
+    FValue ret = 0;
+    for (size_t i = 0; i < m_size; ++i) ret += m_values[i];
+    return ret;
+  }
+
+  FDenseArray &operator*=(FValue rhs) {
+    for (size_t i = 0; i < m_size; ++i) m_values[i] *= rhs;
+    return *this;
+  }
+  FDenseArray &operator/=(FValue rhs) {
+    for (size_t i = 0; i < m_size; ++i) m_values[i] /= rhs;
+    return *this;
+  }
+
+private:
+  size_t m_size;
+  FValue m_values[MAX_DENSE_FEATURES];
+};
+
+inline void swap(FDenseArray &first, FDenseArray &second)
+{
+  std::swap(first, second);
+}
+
+typedef FDenseArray FCoreVector;
+#else
+typedef std::valarray<FValue> FCoreVector;
+#endif
+
 /**
  * A sparse feature (or weight) vector.
  **/
@@ -131,7 +207,9 @@ public:
   FVector(size_t coreFeatures = 0);
 
   FVector& operator=( const FVector& rhs ) {
-    m_features = rhs.m_features;
+    // dense-only configurations never fill the maps
+    if (!m_features.empty() || !rhs.m_features.empty())
+      m_features = rhs.m_features;
     m_coreFeatures = rhs.m_coreFeatures;
     return *this;
   }
@@ -184,7 +262,7 @@ public:
     return m_coreFeatures.size();
   }
 
-  const std::valarray<FValue> &getCoreFeatures() const {
+  const FCoreVector &getCoreFeatures() const {
     return m_coreFeatures;
   }
 
@@ -273,7 +351,7 @@ private:
   void set(const FName& name, const FValue& value);
 
   FNVmap m_features;
-  std::valarray<FValue> m_coreFeatures;
+  FCoreVector m_coreFeatures;
 
 #ifdef MPI_ENABLE
   //serialization
@@ -289,7 +367,14 @@ private:
     }
     ar << names;
     ar << values;
+#if MAX_DENSE_FEATURES > 0
+    std::valarray<FValue> coreFeatures(m_coreFeatures.size());
+    for (size_t i = 0; i < m_coreFeatures.size(); ++i)
+      coreFeatures[i] = m_coreFeatures[i];
+    ar << coreFeatures;
+#else
     ar << m_coreFeatures;
+#endif
   }
 
   template<class Archive>
@@ -299,7 +384,15 @@ private:
     std::vector<FValue> values;
     ar >> names;
     ar >> values;
+#if MAX_DENSE_FEATURES > 0
+    std::valarray<FValue> coreFeatures;
+    ar >> coreFeatures;
+    m_coreFeatures.resize(coreFeatures.size());
+    for (size_t i = 0; i < coreFeatures.size(); ++i)
+      m_coreFeatures[i] = coreFeatures[i];
+#else
     ar >> m_coreFeatures;
+#endif
     UTIL_THROW_IF2(names.size() != values.size(), "Error");
     for (size_t i = 0; i < names.size(); ++i) {
       set(FName(names[i]), values[i]);
@@ -306,6 +306,33 @@ BOOST_AUTO_TEST_CASE(ip)
   BOOST_CHECK_CLOSE((FValue)p1, 1.1*0.5 + -0.1*0.25 + 2.2*2.4, TOL);
 }
 
+BOOST_AUTO_TEST_CASE(dense_only)
+{
+  // no sparse features: the fast paths of +=, = and inner_product
+  FVector f1(5);
+  FVector f2(5);
+  for (size_t i = 0; i < 5; ++i) {
+    f1[i] = i;
+    f2[i] = 0.5;
+  }
+  f1 += f2;
+  BOOST_CHECK_CLOSE(f1[4], 4.5, TOL);
+  BOOST_CHECK_CLOSE(inner_product(f1,f2), (0.5+1.5+2.5+3.5+4.5)*0.5, TOL);
+
+  FVector f3;
+  f3 = f1;
+  BOOST_CHECK_EQUAL(f3.size(), 5);
+  BOOST_CHECK_CLOSE(f3[2], 2.5, TOL);
+
+  // a sparse feature on the right-hand side only
+  f2[FName("a")] = 2;
+  f1 += f2;
+  BOOST_CHECK_CLOSE((FValue)f1[FName("a")], 2, TOL);
+  BOOST_CHECK_CLOSE(f1[0], 1, TOL);
+  f3 = f2;
+  BOOST_CHECK_EQUAL(f3.size(), 6);
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
 
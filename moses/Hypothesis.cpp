@@ -55,7 +55,10 @@ Hypothesis(Manager& manager, InputType const& source, const TranslationOption &i
   , m_wordDeleted(false)
   , m_futureScore(0.0f)
   , m_estimatedScore(0.0f)
-  , m_ffStates(StatefulFeatureFunction::GetStatefulFeatureFunctions().size())
+  , m_ffStates(NULL)
+  , m_numFFStates(StatefulFeatureFunction::GetStatefulFeatureFunctions().size())
+  , m_hash(0)
+  , m_hashComputed(false)
   , m_arcList(NULL)
   , m_transOpt(initialTransOpt)
   , m_manager(manager)
@@ -65,6 +68,7 @@ Hypothesis(Manager& manager, InputType const& source, const TranslationOption &i
   // initialize scores
   //_hash_computed = false;
   //s_HypothesesCreated = 1;
+  AllocateFFStates();
   const vector<const StatefulFeatureFunction*>& ffs = StatefulFeatureFunction::GetStatefulFeatureFunctions();
   for (unsigned i = 0; i < ffs.size(); ++i)
     m_ffStates[i] = ffs[i]->EmptyHypothesisState(source);
@@ -85,12 +89,16 @@ Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt, const
   , m_wordDeleted(false)
   , m_futureScore(0.0f)
   , m_estimatedScore(0.0f)
-  , m_ffStates(prevHypo.m_ffStates.size())
+  , m_ffStates(NULL)
+  , m_numFFStates(prevHypo.m_numFFStates)
+  , m_hash(0)
+  , m_hashComputed(false)
   , m_arcList(NULL)
   , m_transOpt(transOpt)
   , m_manager(prevHypo.GetManager())
   , m_id(id)
 {
+  AllocateFFStates();
   m_currScoreBreakdown.PlusEquals(transOpt.GetScoreBreakdown());
   m_wordDeleted = transOpt.IsDeletionOption();
 }
@@ -98,8 +106,9 @@ Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt, const
 Hypothesis::
 ~Hypothesis()
 {
-  for (unsigned i = 0; i < m_ffStates.size(); ++i)
+  for (unsigned i = 0; i < m_numFFStates; ++i)
     delete m_ffStates[i];
+  HypothesisArena::Free(m_ffStates);
 
   if (m_arcList) {
     ArcList::iterator iter;
@@ -113,6 +122,37 @@ Hypothesis::
   }
 }
 
+void *
+Hypothesis::
+operator new(size_t size, Manager &manager)
+{
+  return manager.GetHypothesisArena().Allocate(size);
+}
+
+void
+Hypothesis::
+operator delete(void *ptr, Manager &manager)
+{
+  // only called if a constructor throws
+  HypothesisArena::Free(ptr);
+}
+
+void
+Hypothesis::
+operator delete(void *ptr)
+{
+  HypothesisArena::Free(ptr);
+}
+
+void
+Hypothesis::
+AllocateFFStates()
+{
+  void *mem = m_manager.GetHypothesisArena().Allocate(m_numFFStates * sizeof(const FFState*));
+  m_ffStates = static_cast<const FFState**>(mem);
+  std::fill(m_ffStates, m_ffStates + m_numFFStates, static_cast<const FFState*>(NULL));
+}
+
 void
 Hypothesis::
 AddArc(Hypothesis *loserHypo)
@@ -393,7 +433,7 @@ GetPlaceholders(const Hypothesis &hypo, FactorType placeholderFactor) const
   return ret;
 }
 
-size_t Hypothesis::hash() const
+size_t Hypothesis::ComputeHash() const
 {
   size_t seed;
 
@@ -408,7 +448,7 @@ size_t Hypothesis::hash() const
   seed = m_sourceCompleted.hash();
 
   // states
-  for (size_t i = 0; i < m_ffStates.size(); ++i) {
+  for (size_t i = 0; i < m_numFFStates; ++i) {
     const FFState *state = m_ffStates[i];
     size_t hash = state->hash();
     boost::hash_combine(seed, hash);
@@ -424,7 +464,7 @@ bool Hypothesis::operator==(const Hypothesis& other) const
   }
 
   // states
-  for (size_t i = 0; i < m_ffStates.size(); ++i) {
+  for (size_t i = 0; i < m_numFFStates; ++i) {
     const FFState &thisState = *m_ffStates[i];
     const FFState &otherState = *other.m_ffStates[i];
     if (thisState != otherState) {
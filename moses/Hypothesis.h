@@ -77,7 +77,10 @@ protected:
   /*! sum of scores of this hypothesis, and previous hypotheses. Lazily initialised.  */
   mutable boost::scoped_ptr<ScoreComponentCollection> m_scoreBreakdown;
   ScoreComponentCollection m_currScoreBreakdown; /*! scores for this hypothesis only */
-  std::vector<const FFState*> m_ffStates;
+  const FFState **m_ffStates; /*! one state per stateful feature, allocated from the manager's arena */
+  size_t m_numFFStates;
+  mutable size_t m_hash; /*! combined coverage and FF state hash, computed on first use */
+  mutable bool m_hashComputed;
   const Hypothesis 	*m_winningHypo;
   ArcList 					*m_arcList; /*! all arcs that end at the same trellis point as this hypothesis */
   const TranslationOption &m_transOpt;
@@ -85,6 +88,9 @@ protected:
 
   int m_id; /*! numeric ID of this hypothesis, used for logging */
 
+  void AllocateFFStates();
+  size_t ComputeHash() const;
+
 public:
   /*! used by initial seeding of the translation process */
   Hypothesis(Manager& manager, InputType const& source, const TranslationOption &initialTransOpt, const Bitmap &bitmap, int id);
@@ -92,6 +98,12 @@ public:
   Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt, const Bitmap &bitmap, int id);
   ~Hypothesis();
 
+  /*! hypotheses are allocated from the HypothesisArena of their Manager.
+   *  delete runs the destructor; the memory goes when the sentence is done */
+  static void *operator new(size_t size, Manager &manager);
+  static void operator delete(void *ptr, Manager &manager);
+  static void operator delete(void *ptr);
+
   void PrintHypothesis() const;
 
   const InputType& GetInput() const {
@@ -247,8 +259,15 @@ public:
   // creates a map of TARGET positions which should be replaced by word using placeholder
   std::map<size_t, const Moses::Factor*> GetPlaceholders(const Moses::Hypothesis &hypo, Moses::FactorType placeholderFactor) const;
 
-  // for unordered_set in stack
-  size_t hash() const;
+  // for recombination in the stack. The FF states must be final, as the
+  // hash is only computed once
+  size_t hash() const {
+    if (!m_hashComputed) {
+      m_hash = ComputeHash();
+      m_hashComputed = true;
+    }
+    return m_hash;
+  }
   bool operator==(const Hypothesis& other) const;
 
 #ifdef HAVE_XMLRPC_C
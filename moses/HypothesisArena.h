@@ -0,0 +1,65 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include "util/pool.hh"
+
+namespace Moses
+{
+
+/** Per-sentence memory region for phrase-based hypotheses.
+ *
+ * Hypotheses and their arrays of feature function states are carved out of
+ * one util::Pool owned by the Manager. Deleting a hypothesis still runs its
+ * destructor (which releases the FF states and arc list), but the memory
+ * itself is only returned when the arena is destroyed with the Manager, i.e.
+ * once the sentence is finished. This includes hypotheses that were pruned
+ * or recombined away during search.
+ *
+ * Compile with --without-hypothesis-arena (NO_HYPOTHESIS_ARENA) to fall back
+ * to the global heap, e.g. to compare allocation counts and speed.
+ */
+class HypothesisArena
+{
+public:
+  HypothesisArena()
+    : m_numAllocations(0)
+    , m_numBytes(0) {
+  }
+
+  void *Allocate(std::size_t size) {
+    ++m_numAllocations;
+    m_numBytes += size;
+#ifdef NO_HYPOTHESIS_ARENA
+    return ::operator new(size);
+#else
+    // keep every block pointer-aligned
+    return m_pool.Allocate((size + sizeof(void*) - 1) & ~(sizeof(void*) - 1));
+#endif
+  }
+
+  //! counterpart of Allocate(); a no-op unless the arena is disabled
+  static void Free(void *ptr) {
+#ifdef NO_HYPOTHESIS_ARENA
+    ::operator delete(ptr);
+#endif
+  }
+
+  std::size_t GetNumAllocations() const {
+    return m_numAllocations;
+  }
+  std::size_t GetNumBytes() const {
+    return m_numBytes;
+  }
+
+private:
+  util::Pool m_pool;
+  std::size_t m_numAllocations;
+  std::size_t m_numBytes;
+
+  HypothesisArena(const HypothesisArena &);
+  HypothesisArena &operator=(const HypothesisArena &);
+};
+
+}
@@ -0,0 +1,86 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#include <algorithm>
+#include "HypothesisRecombinationTable.h"
+#include "Hypothesis.h"
+
+namespace Moses
+{
+
+std::pair<HypothesisRecombinationTable::iterator, bool>
+HypothesisRecombinationTable::insert(Hypothesis *hypo)
+{
+  // keep live + tombstones at or below half of the buckets
+  if (2 * (m_used + 1) > m_slots.size()) {
+    Rehash(4 * (m_size + 1));
+  }
+
+  const std::size_t hash = hypo->hash();
+  const std::size_t mask = m_slots.size() - 1;
+  Slot *reuse = NULL;
+  for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+    Slot &slot = m_slots[i];
+    if (slot.hypo == NULL) {
+      if (!reuse) {
+        reuse = &slot;
+        ++m_used;
+      }
+      break;
+    }
+    if (slot.hypo == Tombstone()) {
+      if (!reuse) reuse = &slot;
+    } else if (slot.hash == hash && *slot.hypo == *hypo) {
+      return std::make_pair(iterator(&slot, SlotsEnd()), false);
+    }
+  }
+  reuse->hash = hash;
+  reuse->hypo = hypo;
+  ++m_size;
+  return std::make_pair(iterator(reuse, SlotsEnd()), true);
+}
+
+HypothesisRecombinationTable::iterator
+HypothesisRecombinationTable::find(const Hypothesis *hypo) const
+{
+  if (m_slots.empty()) return end();
+  const std::size_t hash = hypo->hash();
+  const std::size_t mask = m_slots.size() - 1;
+  for (std::size_t i = hash & mask; m_slots[i].hypo != NULL; i = (i + 1) & mask) {
+    const Slot &slot = m_slots[i];
+    if (slot.hypo != Tombstone() && slot.hash == hash && *slot.hypo == *hypo) {
+      return iterator(SlotsBegin() + i, SlotsEnd());
+    }
+  }
+  return end();
+}
+
+void HypothesisRecombinationTable::clear()
+{
+  // keep the buckets, pruned stacks are refilled straight away
+  Slot empty = { 0, NULL };
+  std::fill(m_slots.begin(), m_slots.end(), empty);
+  m_size = 0;
+  m_used = 0;
+}
+
+void HypothesisRecombinationTable::Rehash(std::size_t minBuckets)
+{
+  std::size_t buckets = 16;
+  while (buckets < minBuckets) buckets *= 2;
+
+  std::vector<Slot> old;
+  old.swap(m_slots);
+  Slot empty = { 0, NULL };
+  m_slots.resize(buckets, empty);
+  m_used = m_size;
+
+  // hashes are stored, so moving never calls back into the hypotheses
+  const std::size_t mask = buckets - 1;
+  for (std::size_t i = 0; i < old.size(); ++i) {
+    if (!IsLive(old[i])) continue;
+    std::size_t j = old[i].hash & mask;
+    while (m_slots[j].hypo != NULL) j = (j + 1) & mask;
+    m_slots[j] = old[i];
+  }
+}
+
+}
@@ -0,0 +1,130 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace Moses
+{
+
+class Hypothesis;
+
+/** Set of hypotheses in a stack, keyed by recombination state.
+ *
+ * Replaces the node-based boost::unordered_set: hypotheses are kept in one
+ * flat array of (hash, pointer) slots with linear probing, next to the
+ * combined coverage + FF state hash stored in each hypothesis. A probe
+ * only calls Hypothesis::operator== (and with it the virtual FFState
+ * comparisons) when the full hashes match.
+ *
+ * Erased slots become tombstones rather than shifting their neighbours,
+ * so iterators to other hypotheses stay valid across erase(), as they did
+ * with unordered_set. insert() may rehash and invalidate all iterators.
+ */
+class HypothesisRecombinationTable
+{
+  struct Slot {
+    std::size_t hash;
+    Hypothesis *hypo; //! NULL = never used, Tombstone() = erased
+  };
+
+public:
+  class iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Hypothesis *value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Hypothesis *const *pointer;
+    typedef Hypothesis *const &reference;
+
+    iterator() : m_slot(NULL), m_end(NULL) {}
+
+    reference operator*() const {
+      return m_slot->hypo;
+    }
+    iterator &operator++() {
+      ++m_slot;
+      Skip();
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator ret(*this);
+      ++*this;
+      return ret;
+    }
+    bool operator==(const iterator &other) const {
+      return m_slot == other.m_slot;
+    }
+    bool operator!=(const iterator &other) const {
+      return m_slot != other.m_slot;
+    }
+
+  private:
+    friend class HypothesisRecombinationTable;
+    iterator(Slot *slot, Slot *end) : m_slot(slot), m_end(end) {
+      Skip();
+    }
+    void Skip() {
+      while (m_slot != m_end && !IsLive(*m_slot)) ++m_slot;
+    }
+    Slot *m_slot;
+    Slot *m_end;
+  };
+  typedef iterator const_iterator;
+
+  HypothesisRecombinationTable() : m_size(0), m_used(0) {}
+
+  iterator begin() const {
+    return iterator(SlotsBegin(), SlotsEnd());
+  }
+  iterator end() const {
+    return iterator(SlotsEnd(), SlotsEnd());
+  }
+  std::size_t size() const {
+    return m_size;
+  }
+  bool empty() const {
+    return m_size == 0;
+  }
+
+  /** add hypo unless a hypothesis with the same recombination state is
+   *  present; in that case return an iterator to it and false */
+  std::pair<iterator, bool> insert(Hypothesis *hypo);
+
+  //! hypothesis with the same recombination state as hypo, or end()
+  iterator find(const Hypothesis *hypo) const;
+
+  void erase(const iterator &iter) {
+    iter.m_slot->hypo = Tombstone();
+    --m_size;
+  }
+
+  void clear();
+
+private:
+  std::vector<Slot> m_slots; //! size is 0 or a power of 2
+  std::size_t m_size; //! live hypotheses
+  std::size_t m_used; //! live hypotheses + tombstones
+
+  static Hypothesis *Tombstone() {
+    static char tombstone;
+    return reinterpret_cast<Hypothesis*>(&tombstone);
+  }
+  static bool IsLive(const Slot &slot) {
+    return slot.hypo != NULL && slot.hypo != Tombstone();
+  }
+
+  Slot *SlotsBegin() const {
+    return m_slots.empty() ? NULL : const_cast<Slot*>(&m_slots[0]);
+  }
+  Slot *SlotsEnd() const {
+    return SlotsBegin() + m_slots.size();
+  }
+
+  void Rehash(std::size_t minBuckets);
+};
+
+}
@@ -3,8 +3,8 @@
 
 #include <vector>
 #include <set>
-#include <boost/unordered_set.hpp>
 #include "Hypothesis.h"
+#include "HypothesisRecombinationTable.h"
 #include "Bitmap.h"
 
 namespace Moses
@@ -19,7 +19,7 @@ class HypothesisStack
 {
 
 protected:
-  typedef boost::unordered_set< Hypothesis*, UnorderedComparer<Hypothesis>, UnorderedComparer<Hypothesis> > _HCType;
+  typedef HypothesisRecombinationTable _HCType;
   _HCType m_hypos; /**< contains hypotheses */
   Manager& m_manager;
 
@@ -40,9 +40,6 @@ public:
   virtual inline float GetWorstScore() const {
     return -std::numeric_limits<float>::infinity();
   };
-  virtual float GetWorstScoreForBitmap( WordsBitmapID ) {
-    return -std::numeric_limits<float>::infinity();
-  };
   virtual float GetWorstScoreForBitmap( const Bitmap& ) {
     return -std::numeric_limits<float>::infinity();
   };
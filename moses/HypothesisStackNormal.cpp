@@ -66,7 +66,7 @@ pair<HypothesisStackNormal::iterator, bool> HypothesisStackNormal::Add(Hypothesi
     // update best/worst score for stack diversity 1
     if ( m_minHypoStackDiversity == 1 &&
          hypo->GetFutureScore() > GetWorstScoreForBitmap( hypo->GetWordsBitmap() ) ) {
-      SetWorstScoreForBitmap( hypo->GetWordsBitmap().GetID(), hypo->GetFutureScore() );
+      SetWorstScoreForBitmap( hypo->GetWordsBitmap(), hypo->GetFutureScore() );
     }
 
     VERBOSE(3,", now size " << m_hypos.size());
@@ -160,39 +160,38 @@ void HypothesisStackNormal::PruneToSize(size_t newSize)
   if ( size() <= newSize ) return; // ok, if not over the limit
 
   // we need to store a temporary list of hypotheses
-  vector< Hypothesis* > hypos = GetSortedListNOTCONST();
-  bool* included = (bool*) malloc(sizeof(bool) * hypos.size());
-  for(size_t i=0; i<hypos.size(); i++) included[i] = false;
+  vector< Hypothesis* > hypos(m_hypos.begin(), m_hypos.end());
+  vector< bool > included(hypos.size(), false);
 
   // clear out original set
-  for( iterator iter = m_hypos.begin(); iter != m_hypos.end(); ) {
-    iterator removeHyp = iter++;
-    Detach(removeHyp);
-  }
+  m_hypos.clear();
 
-  // add best hyps for each coverage according to minStackDiversity
   if ( m_minHypoStackDiversity > 0 ) {
-    map< WordsBitmapID, size_t > diversityCount;
+    // the best hypotheses per coverage go first, so this needs the full order
+    sort(hypos.begin(), hypos.end(), CompareHypothesisTotalScore());
+
+    // add best hyps for each coverage according to minStackDiversity
+    vector< size_t > diversityCount;
     for(size_t i=0; i<hypos.size(); i++) {
       Hypothesis *hyp = hypos[i];
-      WordsBitmapID coverage = hyp->GetWordsBitmap().GetID();;
-      if (diversityCount.find( coverage ) == diversityCount.end())
-        diversityCount[ coverage ] = 0;
-
-      if (diversityCount[ coverage ] < m_minHypoStackDiversity) {
+      const Bitmap &coverage = hyp->GetWordsBitmap();
+      size_t index = coverage.GetIndex();
+      // stack decoding only sees coverages made by the Bitmaps factory
+      UTIL_THROW_IF2(index == NOT_FOUND,
+                     "Stack diversity needs a numbered coverage, got " << coverage);
+      if (index >= diversityCount.size())
+        diversityCount.resize(index + 1, 0);
+
+      if (diversityCount[ index ] < m_minHypoStackDiversity) {
         m_hypos.insert( hyp );
         included[i] = true;
-        diversityCount[ coverage ]++;
-        if (diversityCount[ coverage ] == m_minHypoStackDiversity)
+        diversityCount[ index ]++;
+        if (diversityCount[ index ] == m_minHypoStackDiversity)
           SetWorstScoreForBitmap( coverage, hyp->GetFutureScore());
       }
     }
-  }
-
-  // only add more if stack not full after satisfying minStackDiversity
-  if ( size() < newSize ) {
 
-    // add best remaining hypotheses
+    // then the best remaining hypotheses, while the stack is not full
     for(size_t i=0; i<hypos.size()
         && size() < newSize
         && hypos[i]->GetFutureScore() > m_bestScore+m_beamWidth; i++) {
@@ -203,6 +202,20 @@ void HypothesisStackNormal::PruneToSize(size_t newSize)
           m_worstScore = hypos[i]->GetFutureScore();
       }
     }
+  } else {
+    // only the newSize best are needed, and in no particular order
+    nth_element(hypos.begin(), hypos.begin() + newSize - 1, hypos.end(),
+                CompareHypothesisTotalScore());
+
+    for(size_t i=0; i<newSize; i++) {
+      if (hypos[i]->GetFutureScore() > m_bestScore+m_beamWidth) {
+        m_hypos.insert( hypos[i] );
+        included[i] = true;
+      }
+    }
+    // hypos[newSize-1] is the worst of the best newSize
+    if (size() == newSize)
+      m_worstScore = hypos[newSize-1]->GetFutureScore();
   }
 
   // delete hypotheses that have not been included
@@ -212,7 +225,6 @@ void HypothesisStackNormal::PruneToSize(size_t newSize)
       m_manager.GetSentenceStats().AddPruning();
     }
   }
-  free(included);
 
   // some reporting....
   VERBOSE(3,", pruned to size " << size() << endl);
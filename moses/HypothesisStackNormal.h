@@ -42,7 +42,7 @@ public:
 protected:
   float m_bestScore; /**< score of the best hypothesis in collection */
   float m_worstScore; /**< score of the worse hypothesis in collection */
-  std::map< WordsBitmapID, float > m_diversityWorstScore; /**< score of worst hypothesis for particular source word coverage */
+  std::vector<float> m_diversityWorstScore; /**< score of worst hypothesis for particular source word coverage, indexed by Bitmap::GetIndex() */
   float m_beamWidth; /**< minimum score due to threashold pruning */
   size_t m_maxHypoStackSize; /**< maximum number of hypothesis allowed in this stack */
   size_t m_minHypoStackDiversity; /**< minimum number of hypothesis with different source word coverage */
@@ -56,18 +56,21 @@ protected:
   /** destroy all instances of Hypothesis in this collection */
   void RemoveAll();
 
-  void SetWorstScoreForBitmap( WordsBitmapID id, float worstScore ) {
-    m_diversityWorstScore[ id ] = worstScore;
+  void SetWorstScoreForBitmap( const Bitmap &coverage, float worstScore ) {
+    size_t index = coverage.GetIndex();
+    assert(index != NOT_FOUND);
+    if (index >= m_diversityWorstScore.size()) {
+      m_diversityWorstScore.resize(index + 1, -std::numeric_limits<float>::infinity());
+    }
+    m_diversityWorstScore[ index ] = worstScore;
   }
 
 public:
-  float GetWorstScoreForBitmap( WordsBitmapID id ) {
-    if (m_diversityWorstScore.find( id ) == m_diversityWorstScore.end())
-      return -std::numeric_limits<float>::infinity();
-    return m_diversityWorstScore[ id ];
-  }
   virtual float GetWorstScoreForBitmap( const Bitmap &coverage ) {
-    return GetWorstScoreForBitmap( coverage.GetID() );
+    size_t index = coverage.GetIndex();
+    if (index >= m_diversityWorstScore.size())
+      return -std::numeric_limits<float>::infinity();
+    return m_diversityWorstScore[ index ];
   }
 
   HypothesisStackNormal(Manager& manager);
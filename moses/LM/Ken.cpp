@@ -113,6 +113,7 @@ template <class Model> LanguageModelKen<Model>::LanguageModelKen(const std::stri
   :LanguageModel(line)
   ,m_factorType(factorType)
   ,m_beginSentenceFactor(FactorCollection::Instance().AddFactor(BOS_))
+  ,m_prefetch(false)
 {
   ReadParameters();
   LoadModel(file, load_method);
@@ -124,6 +125,7 @@ template <class Model> LanguageModelKen<Model>::LanguageModelKen(const LanguageM
 // TODO: don't copy this.
    m_beginSentenceFactor(copy_from.m_beginSentenceFactor),
    m_factorType(copy_from.m_factorType),
+   m_prefetch(copy_from.m_prefetch),
    m_lmIdLookup(copy_from.m_lmIdLookup)
 {
 }
@@ -242,6 +244,38 @@ template <class Model> FFState *LanguageModelKen<Model>::EvaluateWhenApplied(con
   return ret.release();
 }
 
+template <class Model> void LanguageModelKen<Model>::PrefetchWhenApplied(const FFState *ps, const TargetPhrase &targetPhrase) const
+{
+  const lm::ngram::State &in_state = static_cast<const KenLMState&>(*ps).state;
+  const std::size_t order = m_ngram->Order();
+  // only the first order-1 words of the phrase see the incoming state
+  const std::size_t prefix = std::min(targetPhrase.GetSize(), order - 1);
+  if (!prefix) return;
+
+  // history, most recent word first: the phrase prefix reversed, followed
+  // by the words of the incoming state
+  lm::WordIndex history[2 * KENLM_MAX_ORDER];
+  for (std::size_t i = 0; i < prefix; ++i) {
+    history[prefix - 1 - i] = TranslateID(targetPhrase.GetWord(i));
+  }
+  std::copy(in_state.words, in_state.words + in_state.length, history + prefix);
+  const lm::WordIndex *history_end = history + prefix + in_state.length;
+
+  for (std::size_t i = 0; i < prefix; ++i) {
+    const lm::WordIndex *context = history + prefix - i;
+    m_ngram->Prefetch(context, std::min(history_end, context + order - 1), history[prefix - 1 - i]);
+  }
+}
+
+template <class Model> void LanguageModelKen<Model>::SetParameter(const std::string& key, const std::string& value)
+{
+  if (key == "prefetch") {
+    m_prefetch = Scan<bool>(value);
+  } else {
+    LanguageModel::SetParameter(key, value);
+  }
+}
+
 class LanguageModelChartStateKenLM : public FFState
 {
 public:
@@ -58,6 +58,12 @@ public:
 
   virtual FFState *EvaluateWhenApplied(const Hypothesis &hypo, const FFState *ps, ScoreComponentCollection *out) const;
 
+  virtual bool UsesPrefetch() const {
+    return m_prefetch;
+  }
+
+  virtual void PrefetchWhenApplied(const FFState *ps, const TargetPhrase &targetPhrase) const;
+
   virtual FFState *EvaluateWhenApplied(const ChartHypothesis& cur_hypo, int featureID, ScoreComponentCollection *accumulator) const;
 
   virtual FFState *EvaluateWhenApplied(const Syntax::SHyperedge& hyperedge, int featureID, ScoreComponentCollection *accumulator) const;
@@ -67,6 +73,8 @@ public:
 
   virtual bool IsUseable(const FactorMask &mask) const;
 
+  virtual void SetParameter(const std::string& key, const std::string& value);
+
 protected:
   boost::shared_ptr<Model> m_ngram;
 
@@ -74,6 +82,8 @@ protected:
 
   FactorType m_factorType;
 
+  bool m_prefetch; //! prefetch n-gram entries for all options of an expansion before scoring them
+
   void LoadModel(const std::string &file, util::LoadMethod load_method);
 
   lm::WordIndex TranslateID(const Word &word) const {
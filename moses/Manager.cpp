@@ -147,6 +147,9 @@ void Manager::Decode()
   m_search->Decode();
   VERBOSE(1, "Line " << m_source.GetTranslationId()
           << ": Search took " << searchTime << " seconds" << endl);
+  VERBOSE(2, "Line " << m_source.GetTranslationId()
+          << ": Hypothesis arena: " << m_hypoArena.GetNumAllocations()
+          << " allocations, " << m_hypoArena.GetNumBytes() << " bytes" << endl);
   IFVERBOSE(2) {
     GetSentenceStats().StopTimeTotal();
     TRACE_ERR(GetSentenceStats());
@@ -26,6 +26,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <list>
 #include "InputType.h"
 #include "Hypothesis.h"
+#include "HypothesisArena.h"
 #include "StaticData.h"
 #include "TranslationOption.h"
 #include "TranslationOptionCollection.h"
@@ -112,6 +113,7 @@ private:
 
 protected:
   // data
+  HypothesisArena m_hypoArena; /**< memory for this sentence's hypotheses; must outlive m_search */
   TranslationOptionCollection *m_transOptColl; /**< pre-computed list of translation options for the phrases in this sentence */
   Search *m_search;
 
@@ -166,6 +168,9 @@ public:
   void GetOutputLanguageModelOrder( std::ostream &out, const Hypothesis *hypo ) const;
   void GetWordGraph(long translationId, std::ostream &outputWordGraphStream) const;
   int GetNextHypoId();
+  HypothesisArena &GetHypothesisArena() {
+    return m_hypoArena;
+  }
 
   void OutputLatticeMBRNBest(std::ostream& out, const std::vector<LatticeMBRSolution>& solutions,long translationId) const;
   void OutputBestHypo(const std::vector<Moses::Word>&  mbrBestHypo, std::ostream& out) const;
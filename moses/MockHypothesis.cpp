@@ -49,7 +49,7 @@ MockHypothesisGuard
   m_manager->ResetSentenceStats(*m_sentence);
 
   const Bitmap &initBitmap = bitmaps.GetInitialBitmap();
-  m_hypothesis = new Hypothesis(*m_manager, *m_sentence, m_initialTransOpt,
+  m_hypothesis = new (*m_manager) Hypothesis(*m_manager, *m_sentence, m_initialTransOpt,
                                 initBitmap, m_manager->GetNextHypoId());
 
   //create the chain
@@ -64,7 +64,7 @@ MockHypothesisGuard
     m_targetPhrases.back().CreateFromString(Input, factors, *ti, NULL);
     m_toptions.push_back(new TranslationOption
                          (range,m_targetPhrases.back()));
-    m_hypothesis = new Hypothesis(*prevHypo, *m_toptions.back(), newBitmap,
+    m_hypothesis = new (*m_manager) Hypothesis(*prevHypo, *m_toptions.back(), newBitmap,
                                   m_manager->GetNextHypoId());
   }
 
@@ -108,6 +108,7 @@ Parameter::Parameter()
   AddParam(search_opts,"disable-discarding", "dd", "disable hypothesis discarding"); // ??? memory management? UG
   AddParam(search_opts,"phrase-drop-allowed", "da", "if present, allow dropping of source words"); //da = drop any (word); see -du for comparison
   AddParam(search_opts,"threads","th", "number of threads to use in decoding (defaults to single-threaded)");
+  AddParam(search_opts,"thread-scheduler", "how sentences are distributed over threads: fifo (default), work-stealing or longest-first");
 
   // distortion options
   po::options_description disto_opts("Distortion options");
@@ -121,6 +122,7 @@ Parameter::Parameter()
   AddParam(cube_opts,"cube-pruning-pop-limit", "cbp", "How many hypotheses should be popped for each stack. (default = 1000)");
   AddParam(cube_opts,"cube-pruning-diversity", "cbd", "How many hypotheses should be created for each coverage. (default = 0)");
   AddParam(cube_opts,"cube-pruning-lazy-scoring", "cbls", "Don't fully score a hypothesis until it is popped");
+  AddParam(cube_opts,"cube-pruning-lazy-requeue", "cblr", "Lazy scoring, but a popped hypothesis whose full score falls behind the estimate of another one goes back into the queue (chart decoding)");
   AddParam(cube_opts,"cube-pruning-deterministic-search", "cbds", "Break ties deterministically during search");
 
   ///////////////////////////////////////////////////////////////////////////////////////
@@ -250,6 +252,7 @@ Parameter::Parameter()
   AddParam(chart_opts,"rule-limit", "a little like table limit. But for chart decoding rules. Default is DEFAULT_MAX_TRANS_OPT_SIZE");
   AddParam(chart_opts,"source-label-overlap", "What happens if a span already has a label. 0=add more. 1=replace. 2=discard. Default is 0");
   AddParam(chart_opts,"unknown-lhs", "file containing target lhs of unknown words. 1 per line: LHS prob");
+  AddParam(chart_opts,"chart-cell-threads", "number of threads decoding the cells of the same span width of a sentence concurrently (default 1). Needs rule tables that support it, e.g. on-disk tables");
 
   po::options_description misc_opts("Miscellaneous Options");
   AddParam(misc_opts,"mira", "do mira training");
@@ -257,6 +260,7 @@ Parameter::Parameter()
   AddParam(misc_opts,"no-cache", "Disable all phrase-table caching. Default = false (ie. enable caching)");
   AddParam(misc_opts,"default-non-term-for-empty-range-only", "Don't add [X] to all ranges, just ranges where there isn't a source non-term. Default = false (ie. add [X] everywhere)");
   AddParam(misc_opts,"s2t-parsing-algorithm", "Which S2T parsing algorithm to use. 0=recursive CYK+, 1=scope-3 (default = 0)");
+  AddParam(misc_opts,"s2t-matching-threads", "number of threads matching rules for each sentence with the scope-3 S2T parser, in addition to -threads (default = 1)");
 
   //AddParam(o,"continue-partial-translation", "cpt", "start from nonempty hypothesis");
   AddParam(misc_opts,"decoding-graph-backoff", "dpb", "only use subsequent decoding paths for unknown spans of given length");
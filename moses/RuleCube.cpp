@@ -21,6 +21,7 @@
 
 #include "ChartCell.h"
 #include "ChartCellCollection.h"
+#include "ChartManager.h"
 #include "ChartTranslationOptions.h"
 #include "RuleCube.h"
 #include "RuleCubeQueue.h"
@@ -43,7 +44,7 @@ RuleCube::RuleCube(const ChartTranslationOptions &transOpt,
 {
   RuleCubeItem *item = new RuleCubeItem(transOpt, allChartCells);
   m_covered.insert(item);
-  if (StaticData::Instance().options()->cube.lazy_scoring) {
+  if (manager.options()->cube.lazy_scoring) {
     item->EstimateScore();
   } else {
     item->CreateHypothesis(transOpt, manager);
@@ -64,6 +65,18 @@ RuleCubeItem *RuleCube::Pop(ChartManager &manager)
   return item;
 }
 
+bool RuleCube::ScoreTop(ChartManager &manager)
+{
+  RuleCubeItem *item = m_queue.top();
+  if (item->HasHypothesis()) {
+    return false;
+  }
+  m_queue.pop();
+  item->CreateHypothesis(m_transOpt, manager);
+  m_queue.push(item);
+  return true;
+}
+
 // create new RuleCube for neighboring principle rules
 void RuleCube::CreateNeighbors(const RuleCubeItem &item, ChartManager &manager)
 {
@@ -91,7 +104,7 @@ void RuleCube::CreateNeighbor(const RuleCubeItem &item, int dimensionIndex,
   if (!result.second) {
     delete newItem;  // already seen it
   } else {
-    if (StaticData::Instance().options()->cube.lazy_scoring) {
+    if (manager.options()->cube.lazy_scoring) {
       newItem->EstimateScore();
     } else {
       newItem->CreateHypothesis(m_transOpt, manager);
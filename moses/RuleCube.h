@@ -99,6 +99,11 @@ public:
 
   RuleCubeItem *Pop(ChartManager &);
 
+  /** With lazy scoring: fully score the top item if it only has an
+   *  estimate. Returns false if it was already scored. The item may then no
+   *  longer be the top one. */
+  bool ScoreTop(ChartManager &);
+
   bool IsEmpty() const {
     return m_queue.empty();
   }
@@ -81,6 +81,7 @@ void RuleCubeItem::CreateHypothesis(const ChartTranslationOptions &transOpt,
   m_hypothesis = new ChartHypothesis(transOpt, *this, manager);
   m_hypothesis->EvaluateWhenApplied();
   m_score = m_hypothesis->GetFutureScore();
+  manager.GetSentenceStats().AddCreated();
 }
 
 ChartHypothesis *RuleCubeItem::ReleaseHypothesis()
@@ -133,6 +133,11 @@ public:
 
   void CreateHypothesis(const ChartTranslationOptions &, ChartManager &);
 
+  //! false while the item only has an estimated score (lazy scoring)
+  bool HasHypothesis() const {
+    return m_hypothesis != NULL;
+  }
+
   ChartHypothesis *ReleaseHypothesis();
 
   bool operator<(const RuleCubeItem &) const;
@@ -48,13 +48,27 @@ ChartHypothesis *RuleCubeQueue::Pop()
   RuleCube *cube = m_queue.top();
   m_queue.pop();
 
+  // with lazy scoring, the estimates of the items are used as bounds: score
+  // the best item fully and, if that drops it behind an item of this or
+  // another cube, queue it again and look at the new best one instead. So
+  // each item is scored at most once, and only when its estimate makes it
+  // the best candidate.
+  if (m_manager.options()->cube.lazy_requeue) {
+    while (cube->ScoreTop(m_manager)) {
+      m_queue.push(cube);
+      cube = m_queue.top();
+      m_queue.pop();
+    }
+  }
+
   // pop the most promising item from the cube and get the corresponding
   // hypothesis
   RuleCubeItem *item = cube->Pop(m_manager);
-  if (m_manager.options()->cube.lazy_scoring) {
+  if (!item->HasHypothesis()) {
     item->CreateHypothesis(cube->GetTranslationOption(), m_manager);
   }
   ChartHypothesis *hypo = item->ReleaseHypothesis();
+  m_manager.GetSentenceStats().AddPopped();
 
   // if the cube contains more items then push it back onto the queue
   if (!cube->IsEmpty()) {
@@ -2,6 +2,7 @@
 #include "Timer.h"
 #include "SearchNormal.h"
 #include "SentenceStats.h"
+#include "moses/FF/StatefulFeatureFunction.h"
 
 #include <boost/foreach.hpp>
 
@@ -32,6 +33,12 @@ SearchNormal(Manager& manager, const TranslationOptionCollection &transOptColl)
     sourceHypoColl->SetBeamWidth(this->m_options.search.beam_width);
     m_hypoStackColl[ind] = sourceHypoColl;
   }
+
+  const std::vector<const StatefulFeatureFunction*> &ffs
+  = StatefulFeatureFunction::GetStatefulFeatureFunctions();
+  for (size_t i = 0; i < ffs.size(); ++i) {
+    if (ffs[i]->UsesPrefetch()) m_prefetchFFs.push_back(i);
+  }
 }
 
 SearchNormal::~SearchNormal()
@@ -74,7 +81,7 @@ void SearchNormal::Decode()
 {
   // initial seed hypothesis: nothing translated, no words produced
   const Bitmap &initBitmap = m_bitmaps.GetInitialBitmap();
-  Hypothesis *hypo = new Hypothesis(m_manager, m_source, m_initialTransOpt, initBitmap, m_manager.GetNextHypoId());
+  Hypothesis *hypo = new (m_manager) Hypothesis(m_manager, m_source, m_initialTransOpt, initBitmap, m_manager.GetNextHypoId());
 
   m_hypoStackColl[0]->AddPrune(hypo);
 
@@ -258,6 +265,10 @@ ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos
   const Range &nextRange = transOpt.GetSourceWordsRange();
   const Bitmap &nextBitmap = m_bitmaps.GetBitmap(sourceCompleted, nextRange);
 
+  if (!m_prefetchFFs.empty()) {
+    PrefetchExpansions(hypothesis, *tol);
+  }
+
   TranslationOptionList::const_iterator iter;
   for (iter = tol->begin() ; iter != tol->end() ; ++iter) {
     const TranslationOption &transOpt = **iter;
@@ -265,6 +276,26 @@ ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos
   }
 }
 
+/**
+ * Let stateful features prefetch what they will look up for all expansions
+ * of a hypothesis with one list of translation options, so the cache misses
+ * of e.g. a large language model overlap instead of being paid one by one.
+ */
+void
+SearchNormal::
+PrefetchExpansions(const Hypothesis &hypothesis, const TranslationOptionList &tol) const
+{
+  const std::vector<const StatefulFeatureFunction*> &ffs
+  = StatefulFeatureFunction::GetStatefulFeatureFunctions();
+  TranslationOptionList::const_iterator iter;
+  for (iter = tol.begin() ; iter != tol.end() ; ++iter) {
+    const TargetPhrase &targetPhrase = (*iter)->GetTargetPhrase();
+    BOOST_FOREACH(size_t i, m_prefetchFFs) {
+      ffs[i]->PrefetchWhenApplied(hypothesis.GetFFState(i), targetPhrase);
+    }
+  }
+}
+
 /**
  * Expand one hypothesis with a translation option.
  * this involves initial creation, scoring and adding it to the proper stack
@@ -288,7 +319,7 @@ void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis,
     IFVERBOSE(2) {
       stats.StartTimeBuildHyp();
     }
-    newHypo = new Hypothesis(hypothesis, transOpt, bitmap, m_manager.GetNextHypoId());
+    newHypo = new (m_manager) Hypothesis(hypothesis, transOpt, bitmap, m_manager.GetNextHypoId());
     IFVERBOSE(2) {
       stats.StopTimeBuildHyp();
     }
@@ -318,8 +349,7 @@ void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis,
     size_t wordsTranslated = hypothesis.GetWordsBitmap().GetNumWordsCovered() + transOpt.GetSize();
     float allowedScore = m_hypoStackColl[wordsTranslated]->GetWorstScore();
     if (m_options.search.stack_diversity) {
-      WordsBitmapID id = hypothesis.GetWordsBitmap().GetIDPlus(transOpt.GetStartPos(), transOpt.GetEndPos());
-      float allowedScoreForBitmap = m_hypoStackColl[wordsTranslated]->GetWorstScoreForBitmap( id );
+      float allowedScoreForBitmap = m_hypoStackColl[wordsTranslated]->GetWorstScoreForBitmap( bitmap );
       allowedScore = std::min( allowedScore, allowedScoreForBitmap );
     }
     allowedScore += m_options.search.early_discarding_threshold;
@@ -339,7 +369,7 @@ void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis,
     IFVERBOSE(2) {
       stats.StartTimeBuildHyp();
     }
-    newHypo = new Hypothesis(hypothesis, transOpt, bitmap, m_manager.GetNextHypoId());
+    newHypo = new (m_manager) Hypothesis(hypothesis, transOpt, bitmap, m_manager.GetNextHypoId());
     if (newHypo==NULL) return;
     IFVERBOSE(2) {
       stats.StopTimeBuildHyp();
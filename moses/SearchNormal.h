@@ -30,6 +30,9 @@ protected:
   /** pre-computed list of translation options for the phrases in this sentence */
   const TranslationOptionCollection &m_transOptColl;
 
+  /** indices of the stateful features that want PrefetchWhenApplied() */
+  std::vector<size_t> m_prefetchFFs;
+
   // functions for creating hypotheses
 
   virtual bool
@@ -41,6 +44,9 @@ protected:
   virtual void
   ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos);
 
+  void
+  PrefetchExpansions(const Hypothesis &hypothesis, const TranslationOptionList &tol) const;
+
   virtual void
   ExpandHypothesis(const Hypothesis &hypothesis,
                    const TranslationOption &transOpt,
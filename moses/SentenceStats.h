@@ -164,6 +164,21 @@ public:
     m_numHyposDiscarded++;
   }
 
+  /***
+   * add the counts collected separately for part of the same sentence,
+   * e.g. by a thread decoding some of its chart cells. Timers are not added.
+   */
+  void Add(const SentenceStats &other) {
+    m_recombinationInfos.insert(m_recombinationInfos.end(),
+                                other.m_recombinationInfos.begin(), other.m_recombinationInfos.end());
+    m_numHyposCreated += other.m_numHyposCreated;
+    m_numHyposPopped += other.m_numHyposPopped;
+    m_numHyposPruned += other.m_numHyposPruned;
+    m_numHyposDiscarded += other.m_numHyposDiscarded;
+    m_numHyposEarlyDiscarded += other.m_numHyposEarlyDiscarded;
+    m_numHyposNotBuilt += other.m_numHyposNotBuilt;
+  }
+
   void StartTimeCollectOpts() {
     m_timeCollectOpts.start();
   }
@@ -0,0 +1,193 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#pragma once
+
+#include <deque>
+#include <utility>
+
+#include <boost/atomic.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
+namespace Moses
+{
+
+//! size functor for caches that only limit the number of entries
+template <typename Value>
+struct ZeroSize {
+  size_t operator()(const Value &) const {
+    return 0;
+  }
+};
+
+/** Cache shared by all decoder threads.
+ *
+ * Entries are spread over a fixed number of shards, each with its own lock,
+ * so threads looking up different keys rarely contend. Each shard evicts
+ * with the CLOCK (second chance) policy once it exceeds its share of the
+ * entry limit or of the byte budget, where SizeOf estimates the memory held
+ * by a value. An entry limit of 0 turns the cache off: Get() always misses
+ * and Put() stores nothing. Keys are compared in full, so Key must hold
+ * whatever identifies an entry, not just a hash of it.
+ */
+template <typename Key, typename Value,
+          typename SizeOf = ZeroSize<Value>,
+          typename Hash = boost::hash<Key> >
+class ShardedClockCache
+{
+public:
+  //! maxEntries of 0 disables caching, maxBytes of 0 means no byte budget
+  ShardedClockCache(size_t maxEntries, size_t maxBytes = 0,
+                    const SizeOf &sizeOf = SizeOf())
+    : m_sizeOf(sizeOf)
+    , m_hits(0), m_misses(0), m_evictions(0) {
+    SetLimits(maxEntries, maxBytes);
+  }
+
+  void SetLimits(size_t maxEntries, size_t maxBytes) {
+    // round up, so that small limits still allow one entry per shard
+    m_maxEntriesPerShard = maxEntries ? (maxEntries + kShards - 1) / kShards : 0;
+    m_maxBytesPerShard = maxBytes ? (maxBytes + kShards - 1) / kShards : 0;
+    if (!IsEnabled()) {
+      Clear();
+    }
+  }
+
+  bool IsEnabled() const {
+    return m_maxEntriesPerShard != 0;
+  }
+
+  //! look up key; returns false on a miss
+  bool Get(const Key &key, Value &out) {
+    if (!IsEnabled()) {
+      return false;
+    }
+    Shard &shard = GetShard(key);
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(shard.mutex);
+#endif
+    typename Map::iterator iter = shard.entries.find(key);
+    if (iter == shard.entries.end()) {
+      ++m_misses;
+      return false;
+    }
+    iter->second.referenced = true;
+    out = iter->second.value;
+    ++m_hits;
+    return true;
+  }
+
+  void Put(const Key &key, const Value &value) {
+    if (!IsEnabled()) {
+      return;
+    }
+    const size_t bytes = sizeof(typename Map::value_type) + 4 * sizeof(void*)
+                         + m_sizeOf(value);
+    Shard &shard = GetShard(key);
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(shard.mutex);
+#endif
+    std::pair<typename Map::iterator, bool> ins
+    = shard.entries.insert(std::make_pair(key, Entry()));
+    Entry &entry = ins.first->second;
+    if (ins.second) {
+      // nodes do not move on rehashing, so the clock can point at the keys
+      shard.clock.push_back(&ins.first->first);
+    } else {
+      // another thread got there first, or the caller refreshes the entry
+      shard.bytes -= entry.bytes;
+    }
+    entry.value = value;
+    entry.bytes = bytes;
+    entry.referenced = false;
+    shard.bytes += bytes;
+    Evict(shard, &ins.first->first);
+  }
+
+  void Clear() {
+    for (size_t i = 0; i < kShards; ++i) {
+      Shard &shard = m_shards[i];
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(shard.mutex);
+#endif
+      shard.clock.clear();
+      shard.entries.clear();
+      shard.bytes = 0;
+    }
+  }
+
+  size_t GetHits() const {
+    return m_hits;
+  }
+  size_t GetMisses() const {
+    return m_misses;
+  }
+  size_t GetEvictions() const {
+    return m_evictions;
+  }
+
+private:
+  static const size_t kShards = 64;
+
+  struct Entry {
+    Value value;
+    size_t bytes;
+    bool referenced;
+  };
+
+  typedef boost::unordered_map<Key, Entry, Hash> Map;
+
+  struct Shard {
+#ifdef WITH_THREADS
+    boost::mutex mutex;
+#endif
+    Map entries;
+    std::deque<const Key*> clock; //! keys in insertion order, the CLOCK hand is at the front
+    size_t bytes;
+
+    Shard() : bytes(0) {}
+  };
+
+  Shard &GetShard(const Key &key) {
+    // spread the hash, whose low bits the shard's own table uses as well
+    size_t h = m_hash(key);
+    return m_shards[((h * 0x9E3779B97F4A7C15ULL) >> 32) % kShards];
+  }
+
+  void Evict(Shard &shard, const Key *newest) {
+    // CLOCK: entries used since the hand last passed get a second chance.
+    // The entry just put is passed over as well, so it is only evicted if
+    // everything else has gone.
+    while (shard.entries.size() > 1
+           && (shard.entries.size() > m_maxEntriesPerShard
+               || (m_maxBytesPerShard && shard.bytes > m_maxBytesPerShard))) {
+      const Key *key = shard.clock.front();
+      shard.clock.pop_front();
+      typename Map::iterator iter = shard.entries.find(*key);
+      if (key == newest || iter->second.referenced) {
+        iter->second.referenced = false;
+        shard.clock.push_back(key);
+      } else {
+        shard.bytes -= iter->second.bytes;
+        shard.entries.erase(iter);
+        ++m_evictions;
+      }
+    }
+  }
+
+  Shard m_shards[kShards];
+  size_t m_maxEntriesPerShard;
+  size_t m_maxBytesPerShard;
+  SizeOf m_sizeOf;
+  Hash m_hash;
+
+  boost::atomic<size_t> m_hits, m_misses, m_evictions;
+
+  ShardedClockCache(const ShardedClockCache &);
+  ShardedClockCache &operator=(const ShardedClockCache &);
+};
+
+}
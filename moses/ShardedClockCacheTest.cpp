@@ -0,0 +1,118 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2016- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+#include "ShardedClockCache.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+// every key has the same hash, so all of them collide
+struct CollidingHash {
+  size_t operator()(const string &) const {
+    return 42;
+  }
+};
+
+struct StringSize {
+  size_t operator()(const string &value) const {
+    return value.size();
+  }
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(sharded_clock_cache)
+
+BOOST_AUTO_TEST_CASE(compares_full_keys)
+{
+  ShardedClockCache<string, int, ZeroSize<int>, CollidingHash> cache(1000);
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+  int out = 0;
+  BOOST_CHECK(cache.Get("a", out));
+  BOOST_CHECK_EQUAL(out, 1);
+  BOOST_CHECK(cache.Get("b", out));
+  BOOST_CHECK_EQUAL(out, 2);
+  BOOST_CHECK(!cache.Get("c", out));
+}
+
+BOOST_AUTO_TEST_CASE(second_chance)
+{
+  // all keys in one shard, which holds two entries
+  ShardedClockCache<string, int, ZeroSize<int>, CollidingHash> cache(128);
+  int out;
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+  BOOST_CHECK(cache.Get("a", out));
+  // "a" was used, so "b" goes first
+  cache.Put("c", 3);
+  BOOST_CHECK(cache.Get("a", out));
+  BOOST_CHECK(!cache.Get("b", out));
+  BOOST_CHECK(cache.Get("c", out));
+  BOOST_CHECK_EQUAL(cache.GetEvictions(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(keeps_newest_entry)
+{
+  ShardedClockCache<string, int, ZeroSize<int>, CollidingHash> cache(128);
+  int out;
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+  BOOST_CHECK(cache.Get("a", out));
+  BOOST_CHECK(cache.Get("b", out));
+  // both older entries were used, yet one of them goes rather than "c"
+  cache.Put("c", 3);
+  BOOST_CHECK(cache.Get("c", out));
+  BOOST_CHECK_EQUAL(out, 3);
+  BOOST_CHECK_EQUAL(cache.GetEvictions(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(byte_budget)
+{
+  ShardedClockCache<string, string, StringSize, CollidingHash>
+  cache(1000000, 64 * 1000);
+  string big(400, 'x');
+  for (size_t i = 0; i < 100; ++i) {
+    cache.Put(string(1, char('a' + i % 26)) + char('0' + i / 26), big);
+  }
+  // the shard has 1000 bytes; the newest entry always stays
+  BOOST_CHECK(cache.GetEvictions() >= 97);
+  string out;
+  BOOST_CHECK(cache.Get("v3", out));
+  BOOST_CHECK_EQUAL(out, big);
+}
+
+BOOST_AUTO_TEST_CASE(zero_entries_disable)
+{
+  ShardedClockCache<string, int> cache(0, 1000);
+  BOOST_CHECK(!cache.IsEnabled());
+  cache.Put("a", 1);
+  int out;
+  BOOST_CHECK(!cache.Get("a", out));
+  BOOST_CHECK_EQUAL(cache.GetMisses(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
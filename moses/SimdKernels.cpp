@@ -0,0 +1,197 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#include <algorithm>
+#include "SimdKernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MOSES_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// Every product and sum must be rounded on its own for the levels to agree,
+// so do not let the compiler fuse them into FMA instructions.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+namespace Moses
+{
+namespace simd
+{
+
+namespace
+{
+
+void PlusEqualsScalar(float *dst, const float *src, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] += src[i];
+  }
+}
+
+// InnerProduct() adds in the same order at every level: element i goes into
+// lane i % 8, each lane is summed from the front, and the lanes are combined
+// by FinishInnerProduct().  The SIMD versions fill the lanes 4 or 8 at a time
+// and leave the last n % 8 elements to FinishInnerProduct().
+const size_t kLanes = 8;
+
+float FinishInnerProduct(float *lanes, const float *a, const float *b, size_t n)
+{
+  for (size_t k = 0; k < n; ++k) {
+    lanes[k] += a[k] * b[k];
+  }
+  return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5]))
+         + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+}
+
+float InnerProductScalar(const float *a, const float *b, size_t n)
+{
+  float lanes[kLanes] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (size_t k = 0; k < kLanes; ++k) {
+      lanes[k] += a[i + k] * b[i + k];
+    }
+  }
+  return FinishInnerProduct(lanes, a + i, b + i, n - i);
+}
+
+#ifdef MOSES_SIMD_X86
+
+__attribute__((target("sse2")))
+void PlusEqualsSSE2(float *dst, const float *src, size_t n)
+{
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+  }
+  PlusEqualsScalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("sse2")))
+float InnerProductSSE2(const float *a, const float *b, size_t n)
+{
+  __m128 lo = _mm_setzero_ps();
+  __m128 hi = _mm_setzero_ps();
+  size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    lo = _mm_add_ps(lo, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    hi = _mm_add_ps(hi, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  float lanes[kLanes];
+  _mm_storeu_ps(lanes, lo);
+  _mm_storeu_ps(lanes + 4, hi);
+  return FinishInnerProduct(lanes, a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void PlusEqualsAVX2(float *dst, const float *src, size_t n)
+{
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+  }
+  PlusEqualsScalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+float InnerProductAVX2(const float *a, const float *b, size_t n)
+{
+  __m256 sum = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+  }
+  float lanes[kLanes];
+  _mm256_storeu_ps(lanes, sum);
+  return FinishInnerProduct(lanes, a + i, b + i, n - i);
+}
+
+#endif
+
+struct Kernels {
+  Level level;
+  void (*plusEquals)(float *, const float *, size_t);
+  float (*innerProduct)(const float *, const float *, size_t);
+};
+
+Level DetectLevel()
+{
+#ifdef MOSES_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return AVX2;
+  if (__builtin_cpu_supports("sse2")) return SSE2;
+#endif
+  return Scalar;
+}
+
+Kernels MakeKernels(Level level)
+{
+  Kernels ret = { Scalar, &PlusEqualsScalar, &InnerProductScalar };
+#ifdef MOSES_SIMD_X86
+  if (level >= AVX2) {
+    Kernels avx2 = { AVX2, &PlusEqualsAVX2, &InnerProductAVX2 };
+    ret = avx2;
+  } else if (level >= SSE2) {
+    Kernels sse2 = { SSE2, &PlusEqualsSSE2, &InnerProductSSE2 };
+    ret = sse2;
+  }
+#endif
+  return ret;
+}
+
+// Scalar until the dynamic initializer below has run, so static
+// initializers elsewhere can safely add up scores
+Level s_supported = Scalar;
+Kernels s_kernels = { Scalar, &PlusEqualsScalar, &InnerProductScalar };
+
+bool Init()
+{
+  s_supported = DetectLevel();
+  s_kernels = MakeKernels(s_supported);
+  return true;
+}
+const bool s_initialized = Init();
+
+}
+
+void PlusEquals(float *dst, const float *src, size_t n)
+{
+  s_kernels.plusEquals(dst, src, n);
+}
+
+float InnerProduct(const float *a, const float *b, size_t n)
+{
+  return s_kernels.innerProduct(a, b, n);
+}
+
+Level GetSupportedLevel()
+{
+  return s_supported;
+}
+
+Level GetLevel()
+{
+  return s_kernels.level;
+}
+
+void SetLevel(Level level)
+{
+  s_kernels = MakeKernels(std::min(level, s_supported));
+}
+
+const char *GetLevelName(Level level)
+{
+  switch (level) {
+  case AVX2:
+    return "avx2";
+  case SSE2:
+    return "sse2";
+  default:
+    return "scalar";
+  }
+}
+
+}
+}
@@ -0,0 +1,47 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#pragma once
+
+#include <cstddef>
+
+namespace Moses
+{
+
+/** Vectorized loops for dense feature scores.
+ *
+ * On x86 the AVX2 or SSE2 version of each kernel is chosen when the library
+ * is loaded, depending on what the CPU supports; elsewhere, and with
+ * compilers other than gcc/clang, the scalar versions are used. All
+ * versions of InnerProduct() add in the same fixed order (in 8 interleaved
+ * lanes), so scores are the same on every CPU, bit for bit. That order is
+ * not the plain left-to-right sum, so it can differ from a naive loop in
+ * the last bits.
+ */
+namespace simd
+{
+
+enum Level {
+  Scalar = 0,
+  SSE2 = 1,
+  AVX2 = 2
+};
+
+//! dst[i] += src[i] for i < n
+void PlusEquals(float *dst, const float *src, size_t n);
+
+//! sum of a[i] * b[i] for i < n
+float InnerProduct(const float *a, const float *b, size_t n);
+
+//! best level the CPU supports
+Level GetSupportedLevel();
+
+//! level in use
+Level GetLevel();
+
+/** use the kernels of the given level, at most GetSupportedLevel().
+ *  For tests and benchmarks; not thread-safe */
+void SetLevel(Level level);
+
+const char *GetLevelName(Level level);
+
+}
+}
@@ -0,0 +1,111 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+// Dense score kernels at each SIMD level the CPU supports. The future cost
+// estimate does not use them and is timed as a reference point.
+// Usage: simd_kernels_benchmark [num_dense_features] [sentence_length] [iterations]
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "moses/Bitmap.h"
+#include "moses/FeatureVector.h"
+#include "moses/SimdKernels.h"
+#include "moses/SquareMatrix.h"
+#include "util/usage.hh"
+
+using namespace Moses;
+
+namespace
+{
+
+// keeps the compiler from dropping the loops
+float g_sink = 0;
+
+double PlusEquals(size_t numFeatures, size_t iterations)
+{
+  FVector hypo(numFeatures), option(numFeatures);
+  for (size_t i = 0; i < numFeatures; ++i) option[i] = 0.001f * i;
+  double start = util::CPUTime();
+  for (size_t i = 0; i < iterations; ++i) {
+    hypo += option;
+  }
+  g_sink += hypo[0];
+  return util::CPUTime() - start;
+}
+
+double InnerProduct(size_t numFeatures, size_t iterations)
+{
+  FVector scores(numFeatures), weights(numFeatures);
+  for (size_t i = 0; i < numFeatures; ++i) {
+    scores[i] = -0.5f * i;
+    weights[i] = 0.1f;
+  }
+  double start = util::CPUTime();
+  for (size_t i = 0; i < iterations; ++i) {
+    g_sink += scores.inner_product(weights);
+  }
+  return util::CPUTime() - start;
+}
+
+double EstimatedScore(size_t length, size_t iterations)
+{
+  SquareMatrix matrix(length);
+  for (size_t start = 0; start < length; ++start)
+    for (size_t end = start; end < length; ++end)
+      matrix.SetScore(start, end, -1.0f * (end - start + 1));
+
+  // a spread of coverages, as seen in the middle of decoding
+  std::vector<Bitmap*> bitmaps;
+  for (size_t b = 0; b < 64; ++b) {
+    std::vector<bool> covered(length);
+    for (size_t i = 0; i < length; ++i) covered[i] = (i * 7 + b * 13) % 5 < 2;
+    bitmaps.push_back(new Bitmap(length, covered));
+  }
+  double start = util::CPUTime();
+  for (size_t i = 0; i < iterations; ++i) {
+    g_sink += matrix.CalcEstimatedScore(*bitmaps[i % bitmaps.size()]);
+  }
+  double ret = util::CPUTime() - start;
+  for (size_t b = 0; b < bitmaps.size(); ++b) delete bitmaps[b];
+  return ret;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  size_t numFeatures = argc > 1 ? std::atoi(argv[1]) : 32;
+  size_t length = argc > 2 ? std::atoi(argv[2]) : 40;
+  size_t iterations = argc > 3 ? std::atoi(argv[3]) : 10000000;
+
+  std::cout << "level\tplus-equals\tinner-product\testimated-score (seconds)" << std::endl;
+  for (int level = simd::Scalar; level <= simd::GetSupportedLevel(); ++level) {
+    simd::SetLevel(simd::Level(level));
+    std::cout << simd::GetLevelName(simd::GetLevel())
+              << "\t" << PlusEquals(numFeatures, iterations)
+              << "\t" << InnerProduct(numFeatures, iterations)
+              << "\t" << EstimatedScore(length, iterations)
+              << std::endl;
+  }
+  std::cerr << "(" << g_sink << ")" << std::endl;
+  return 0;
+}
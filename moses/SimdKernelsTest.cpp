@@ -0,0 +1,83 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include "SimdKernels.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+const simd::Level kLevels[] = { simd::Scalar, simd::SSE2, simd::AVX2 };
+
+}
+
+BOOST_AUTO_TEST_SUITE(simd_kernels)
+
+BOOST_AUTO_TEST_CASE(float_kernels)
+{
+  for (size_t l = 0; l < 3; ++l) {
+    simd::SetLevel(kLevels[l]);
+    for (size_t n = 0; n < 40; ++n) {
+      vector<float> a(n + 1), b(n + 1), sum(n + 1);
+      float product = 0;
+      for (size_t i = 0; i < n; ++i) {
+        a[i] = 0.25f * i - 3;
+        b[i] = 1.5f - 0.5f * i;
+        sum[i] = a[i] + b[i];
+        product += a[i] * b[i];
+      }
+      BOOST_CHECK_CLOSE(simd::InnerProduct(&a[0], &b[0], n) + 1, product + 1, 0.001);
+      simd::PlusEquals(&a[0], &b[0], n);
+      for (size_t i = 0; i < n; ++i) {
+        BOOST_CHECK_EQUAL(a[i], sum[i]);
+      }
+    }
+  }
+  simd::SetLevel(simd::GetSupportedLevel());
+}
+
+// every level must give the same bits, or scores depend on the CPU
+BOOST_AUTO_TEST_CASE(inner_product_same_on_all_levels)
+{
+  for (size_t n = 0; n < 100; ++n) {
+    vector<float> a(n + 1), b(n + 1);
+    unsigned seed = 12345;
+    for (size_t i = 0; i < n; ++i) {
+      seed = seed * 1103515245 + 12345;
+      a[i] = float(seed % 20000) / 7 - 1000;
+      seed = seed * 1103515245 + 12345;
+      b[i] = float(seed % 20000) / 3000 - 3;
+    }
+    simd::SetLevel(simd::Scalar);
+    float expected = simd::InnerProduct(&a[0], &b[0], n);
+    for (size_t l = 1; l < 3; ++l) {
+      simd::SetLevel(kLevels[l]);
+      BOOST_CHECK_EQUAL(simd::InnerProduct(&a[0], &b[0], n), expected);
+    }
+  }
+  simd::SetLevel(simd::GetSupportedLevel());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+#include "util/pool.hh"
+
+namespace Moses
+{
+namespace Syntax
+{
+
+// Memory region for the cells of a chart and their contents.  Everything is
+// carved out of one util::Pool, so a chart needs a handful of mallocs rather
+// than several per cell, and all of its memory is returned at once when the
+// chart is destroyed.  Objects placed in the arena must still be destroyed
+// explicitly if they own other resources.
+class ChartArena
+{
+public:
+  void *Allocate(std::size_t size) {
+    // keep every block pointer-aligned
+    return m_pool.Allocate((size + sizeof(void*) - 1) & ~(sizeof(void*) - 1));
+  }
+
+private:
+  util::Pool m_pool;
+};
+
+}  // namespace Syntax
+}  // namespace Moses
@@ -66,11 +66,7 @@ bool HyperTreeLoader::Load(AllOptions const& opts,
   HyperPathLoader hyperPathLoader;
 
   Phrase dummySourcePhrase;
-  {
-    Word *lhs = NULL;
-    dummySourcePhrase.CreateFromString(Input, input, "hello", &lhs);
-    delete lhs;
-  }
+  CreateDummySourcePhrase(input, dummySourcePhrase);
 
   while(true) {
     try {
@@ -105,36 +101,22 @@ bool HyperTreeLoader::Load(AllOptions const& opts,
                   << numScoreComponents << ") of score components on line " << count);
     }
 
-    // Source-side
-    HyperPath sourceFragment;
-    hyperPathLoader.Load(sourceString, sourceFragment);
-    ExtractSourceTerminalSetFromHyperPath(sourceFragment, sourceTermSet);
-
-    // Target-side
-    TargetPhrase *targetPhrase = new TargetPhrase(&ff);
-    Word *targetLHS = NULL;
-    targetPhrase->CreateFromString(Output, output, targetString, &targetLHS);
-    targetPhrase->SetTargetLHS(targetLHS);
-    targetPhrase->SetAlignmentInfo(alignString);
+    RuleTableEntry entry;
+    entry.source = sourceString;
+    entry.target = targetString;
+    entry.alignment = alignString;
+    entry.scores = scoreVector.empty() ? NULL : &scoreVector[0];
 
     if (++pipes) {
-      StringPiece sparseString(*pipes);
-      targetPhrase->SetSparseScore(&ff, sparseString);
+      entry.sparse = *pipes;
     }
 
     if (++pipes) {
-      StringPiece propertiesString(*pipes);
-      targetPhrase->SetProperties(propertiesString);
+      entry.properties = *pipes;
     }
 
-    targetPhrase->GetScoreBreakdown().Assign(&ff, scoreVector);
-    targetPhrase->EvaluateInIsolation(dummySourcePhrase,
-                                      ff.GetFeaturesToApply());
-
-    // Add rule to trie.
-    TargetPhraseCollection::shared_ptr phraseColl
-    = GetOrCreateTargetPhraseCollection(trie, sourceFragment);
-    phraseColl->Add(targetPhrase);
+    AddRule(entry, output, dummySourcePhrase, hyperPathLoader, ff, trie,
+            &sourceTermSet);
 
     count++;
   }
@@ -147,6 +129,86 @@ bool HyperTreeLoader::Load(AllOptions const& opts,
   return true;
 }
 
+bool HyperTreeLoader::Load(AllOptions const& opts,
+                           const std::vector<FactorType> &input,
+                           const std::vector<FactorType> &output,
+                           const RuleTrieImage &image,
+                           const std::vector<const RuleTrieImage::Node *> &nodes,
+                           const RuleTableFF &ff,
+                           HyperTree &trie)
+{
+  HyperPathLoader hyperPathLoader;
+
+  Phrase dummySourcePhrase;
+  CreateDummySourcePhrase(input, dummySourcePhrase);
+
+  for (std::vector<const RuleTrieImage::Node *>::const_iterator p =
+         nodes.begin(); p != nodes.end(); ++p) {
+    const RuleTrieImage::Node &node = **p;
+    for (std::size_t i = 0; i < node.numRules; ++i) {
+      AddRule(image.GetRule(node, i), output, dummySourcePhrase,
+              hyperPathLoader, ff, trie, NULL);
+    }
+  }
+
+  // sort and prune each target phrase collection
+  if (ff.GetTableLimit()) {
+    SortAndPrune(trie, ff.GetTableLimit());
+  }
+
+  return true;
+}
+
+void HyperTreeLoader::AddRule(const RuleTableEntry &entry,
+                              const std::vector<FactorType> &output,
+                              const Phrase &dummySourcePhrase,
+                              HyperPathLoader &hyperPathLoader,
+                              const RuleTableFF &ff,
+                              HyperTree &trie,
+                              boost::unordered_set<std::size_t> *sourceTermSet)
+{
+  // Source-side
+  HyperPath sourceFragment;
+  hyperPathLoader.Load(entry.source, sourceFragment);
+  if (sourceTermSet) {
+    ExtractSourceTerminalSetFromHyperPath(sourceFragment, *sourceTermSet);
+  }
+
+  // Target-side
+  TargetPhrase *targetPhrase = new TargetPhrase(&ff);
+  Word *targetLHS = NULL;
+  targetPhrase->CreateFromString(Output, output, entry.target, &targetLHS);
+  targetPhrase->SetTargetLHS(targetLHS);
+  targetPhrase->SetAlignmentInfo(entry.alignment);
+
+  if (!entry.sparse.empty()) {
+    targetPhrase->SetSparseScore(&ff, entry.sparse);
+  }
+
+  if (!entry.properties.empty()) {
+    targetPhrase->SetProperties(entry.properties);
+  }
+
+  std::vector<float> scoreVector(entry.scores,
+                                 entry.scores + ff.GetNumScoreComponents());
+  targetPhrase->GetScoreBreakdown().Assign(&ff, scoreVector);
+  targetPhrase->EvaluateInIsolation(dummySourcePhrase,
+                                    ff.GetFeaturesToApply());
+
+  // Add rule to trie.
+  TargetPhraseCollection::shared_ptr phraseColl
+  = GetOrCreateTargetPhraseCollection(trie, sourceFragment);
+  phraseColl->Add(targetPhrase);
+}
+
+void HyperTreeLoader::CreateDummySourcePhrase(
+  const std::vector<FactorType> &input, Phrase &phrase)
+{
+  Word *lhs = NULL;
+  phrase.CreateFromString(Input, input, "hello", &lhs);
+  delete lhs;
+}
+
 void HyperTreeLoader::ExtractSourceTerminalSetFromHyperPath(
   const HyperPath &hp, boost::unordered_set<std::size_t> &sourceTerminalSet)
 {
@@ -7,8 +7,10 @@
 
 #include "moses/TypeDef.h"
 #include "moses/Syntax/RuleTableFF.h"
+#include "moses/Syntax/RuleTrieImage.h"
 
 #include "HyperPath.h"
+#include "HyperPathLoader.h"
 #include "HyperTree.h"
 #include "HyperTreeCreator.h"
 
@@ -31,7 +33,26 @@ public:
             HyperTree &,
             boost::unordered_set<std::size_t> &);
 
+  // Loads the rules at the given nodes of a compiled image.
+  bool Load(AllOptions const& opts,
+            const std::vector<FactorType> &input,
+            const std::vector<FactorType> &output,
+            const RuleTrieImage &,
+            const std::vector<const RuleTrieImage::Node *> &,
+            const RuleTableFF &,
+            HyperTree &);
+
 private:
+  void AddRule(const RuleTableEntry &,
+               const std::vector<FactorType> &output,
+               const Phrase &,
+               HyperPathLoader &,
+               const RuleTableFF &,
+               HyperTree &,
+               boost::unordered_set<std::size_t> *);
+
+  void CreateDummySourcePhrase(const std::vector<FactorType> &, Phrase &);
+
   void ExtractSourceTerminalSetFromHyperPath(
     const HyperPath &, boost::unordered_set<std::size_t> &);
 };
@@ -163,6 +163,17 @@ void Manager<RuleMatcher>::InitializeRuleMatchers()
     assert(trie);
     boost::shared_ptr<RuleMatcher> p(new RuleMatcher(*trie));
     m_mainRuleMatchers.push_back(p);
+
+    // The rules of a compiled image that are specific to this input (see
+    // RuleTableFF::CreateInputTable).
+    RuleTable *inputTable = ff->CreateInputTable(m_source);
+    if (inputTable) {
+      trie = dynamic_cast<HyperTree*>(inputTable);
+      assert(trie);
+      m_inputRuleTries.push_back(boost::shared_ptr<HyperTree>(trie));
+      p.reset(new RuleMatcher(*trie));
+      m_mainRuleMatchers.push_back(p);
+    }
   }
 
   // Create an additional rule trie + matcher for glue rules (which are
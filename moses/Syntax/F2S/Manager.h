@@ -59,6 +59,7 @@ private:
   std::size_t m_sentenceLength;  // Includes <s> and </s>
   PVertexToStackMap m_stackMap;
   boost::shared_ptr<HyperTree> m_glueRuleTrie;
+  std::vector<boost::shared_ptr<HyperTree> > m_inputRuleTries;
   std::vector<boost::shared_ptr<RuleMatcher> > m_mainRuleMatchers;
   boost::shared_ptr<RuleMatcher> m_glueRuleMatcher;
 };
@@ -1,84 +1,175 @@
 #pragma once
 
-#include <vector>
-
-#include <boost/unordered_map.hpp>
+#include <algorithm>
+#include <new>
+#include <utility>
 
 #include "moses/FactorCollection.h"
 #include "moses/Word.h"
 
-#include "SymbolEqualityPred.h"
-#include "SymbolHasher.h"
+#include "ChartArena.h"
 
 namespace Moses
 {
 namespace Syntax
 {
 
-// Hybrid map/vector-based container for key-value pairs where the key is a
+// Hybrid list/vector-based container for key-value pairs where the key is a
 // non-terminal Word.  The interface is like a (stripped-down) map type, with
 // the main differences being that:
-//   1. Find() is implemented using vector indexing to make it fast.
+//   1. Find() is implemented using vector indexing to make it fast.  Most
+//      chart cells only hold a few labels, so up to kSmallSize entries are
+//      found by scanning a small inline array of label IDs instead, and the
+//      vector (one slot per non-terminal) is only allocated for bigger maps.
 //   2. Once a value has been inserted it can be modified but can't be removed.
+//   3. Entries and the vector live in the ChartArena of the chart that owns
+//      the map.  Iteration is in insertion order.
 template<typename T>
 class NonTerminalMap
 {
 private:
-  typedef boost::unordered_map<Word, T, SymbolHasher, SymbolEqualityPred> Map;
-  typedef std::vector<T*> Vec;
+  struct Entry {
+    Entry(const Word &w, const T &v) : first(w), second(v), next(0) {}
+    Word first;
+    T second;
+    Entry *next;
+  };
+
+  template<typename E>
+  class IteratorBase
+  {
+  public:
+    IteratorBase(E *e = 0) : m_entry(e) {}
+    E &operator*() const {
+      return *m_entry;
+    }
+    E *operator->() const {
+      return m_entry;
+    }
+    IteratorBase &operator++() {
+      m_entry = m_entry->next;
+      return *this;
+    }
+    bool operator==(const IteratorBase &other) const {
+      return m_entry == other.m_entry;
+    }
+    bool operator!=(const IteratorBase &other) const {
+      return m_entry != other.m_entry;
+    }
+  private:
+    E *m_entry;
+  };
 
 public:
-  typedef typename Map::iterator Iterator;
-  typedef typename Map::const_iterator ConstIterator;
-
-  NonTerminalMap()
-    : m_vec(FactorCollection::Instance().GetNumNonTerminals(), NULL) {}
+  typedef IteratorBase<Entry> Iterator;
+  typedef IteratorBase<const Entry> ConstIterator;
+
+  NonTerminalMap(ChartArena &arena)
+    : m_arena(arena)
+    , m_slots(0)
+    , m_first(0)
+    , m_last(0)
+    , m_size(0) {}
+
+  ~NonTerminalMap() {
+    // The memory belongs to the arena; only the values need destroying.
+    for (Entry *e = m_first; e != 0; ) {
+      Entry *next = e->next;
+      e->~Entry();
+      e = next;
+    }
+  }
 
   Iterator Begin() {
-    return m_map.begin();
+    return Iterator(m_first);
   }
   Iterator End() {
-    return m_map.end();
+    return Iterator();
   }
 
   ConstIterator Begin() const {
-    return m_map.begin();
+    return ConstIterator(m_first);
   }
   ConstIterator End() const {
-    return m_map.end();
+    return ConstIterator();
   }
 
   std::size_t Size() const {
-    return m_map.size();
+    return m_size;
   }
 
   bool IsEmpty() const {
-    return m_map.empty();
+    return m_size == 0;
   }
 
   std::pair<Iterator, bool> Insert(const Word &, const T &);
 
   T *Find(const Word &w) const {
-    return m_vec[w[0]->GetId()];
+    Entry *e = FindEntry(w[0]->GetId());
+    return e ? &e->second : 0;
   }
 
 private:
-  Map m_map;
-  Vec m_vec;
+  static const std::size_t kSmallSize = 8;
+
+  Entry *FindEntry(std::size_t id) const {
+    if (m_slots) {
+      return m_slots[id];
+    }
+    for (std::size_t i = 0; i < m_size; ++i) {
+      if (m_smallIds[i] == id) {
+        return m_small[i];
+      }
+    }
+    return 0;
+  }
+
+  NonTerminalMap(const NonTerminalMap &);  // Not implemented
+  NonTerminalMap &operator=(const NonTerminalMap &);  // Not implemented
+
+  ChartArena &m_arena;
+  Entry **m_slots;
+  std::size_t m_smallIds[kSmallSize];
+  Entry *m_small[kSmallSize];
+  Entry *m_first;
+  Entry *m_last;
+  std::size_t m_size;
 };
 
 template<typename T>
 std::pair<typename NonTerminalMap<T>::Iterator, bool> NonTerminalMap<T>::Insert(
   const Word &key, const T &value)
 {
-  std::pair<typename Map::iterator, bool> result =
-    m_map.insert(typename Map::value_type(key, value));
-  if (result.second) {
-    T *p = &(result.first->second);
-    std::size_t i = key[0]->GetId();
-    m_vec[i] = p;
+  const std::size_t id = key[0]->GetId();
+  if (Entry *e = FindEntry(id)) {
+    return std::make_pair(Iterator(e), false);
+  }
+
+  Entry *e = new (m_arena.Allocate(sizeof(Entry))) Entry(key, value);
+  if (m_slots) {
+    m_slots[id] = e;
+  } else if (m_size < kSmallSize) {
+    m_smallIds[m_size] = id;
+    m_small[m_size] = e;
+  } else {
+    // switch to vector indexing
+    const std::size_t n = FactorCollection::Instance().GetNumNonTerminals();
+    m_slots = static_cast<Entry **>(m_arena.Allocate(n * sizeof(Entry *)));
+    std::fill(m_slots, m_slots + n, static_cast<Entry *>(0));
+    for (std::size_t i = 0; i < m_size; ++i) {
+      m_slots[m_smallIds[i]] = m_small[i];
+    }
+    m_slots[id] = e;
+  }
+
+  if (m_last) {
+    m_last->next = e;
+  } else {
+    m_first = e;
   }
-  return result;
+  m_last = e;
+  ++m_size;
+  return std::make_pair(Iterator(e), true);
 }
 
 }  // namespace Syntax
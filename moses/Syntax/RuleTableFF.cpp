@@ -1,8 +1,16 @@
 #include "RuleTableFF.h"
+
+#include <algorithm>
+
+#include "moses/FactorCollection.h"
+#include "moses/InputType.h"
+#include "moses/Timer.h"
+#include "moses/Util.h"
 #include "moses/parameters/AllOptions.h"
 #include "moses/Syntax/F2S/HyperTree.h"
 #include "moses/Syntax/F2S/HyperTreeLoader.h"
 #include "moses/Syntax/S2T/RuleTrieCYKPlus.h"
+#include "moses/Syntax/S2T/RuleTrieCYKPlusImage.h"
 #include "moses/Syntax/S2T/RuleTrieLoader.h"
 #include "moses/Syntax/S2T/RuleTrieScope3.h"
 #include "moses/Syntax/T2S/RuleTrie.h"
@@ -29,6 +37,48 @@ void RuleTableFF::Load(Moses::AllOptions::ptr const& opts)
   m_options = opts;
   SetFeaturesToApply();
 
+  if (RuleTrieImage::IsImage(m_filePath)) {
+    PrintUserTime(std::string("Start loading rule trie image"));
+    m_image.reset(new RuleTrieImage());
+    m_image->Open(m_filePath, false);
+    UTIL_THROW_IF2(m_image->GetNumScores() != GetNumScoreComponents(),
+                   "Rule trie image " << m_filePath << " has "
+                   << m_image->GetNumScores() << " scores per rule, but "
+                   << GetNumScoreComponents() << " are expected");
+    const bool treeSource = (opts->search.algo == SyntaxF2S ||
+                             opts->search.algo == SyntaxT2S);
+    UTIL_THROW_IF2(treeSource != (m_image->GetSourceFormat() ==
+                                  RuleTrieImageFormat::TreeSource),
+                   "Rule trie image " << m_filePath << " was compiled for "
+                   << (treeSource ? "string" : "tree fragment")
+                   << " source sides, which this search algorithm can't use");
+    if (treeSource) {
+      // Unknown words are found by their factor ids (see F2S::Manager).
+      m_sourceTerminalSet.clear();
+      FactorCollection &factors = FactorCollection::Instance();
+      for (std::size_t i = 0; i < m_image->GetVocabSize(); ++i) {
+        m_sourceTerminalSet.insert(
+          factors.AddFactor(m_image->GetTerminal(i), false)->GetId());
+      }
+    }
+    if (MatchesImageInPlace()) {
+      // Every rule is read from the symbol trie for each input, so there is
+      // nothing to load.
+      m_imageLabels.clear();
+      for (std::size_t i = 0; i < m_image->GetNumLabels(); ++i) {
+        Word label(true);
+        label.CreateFromString(Output, m_output,
+                               m_image->GetLabel(i).as_string(), true);
+        m_imageLabels.push_back(label);
+      }
+      m_table = NULL;
+      return;
+    }
+    std::vector<const RuleTrieImage::Node *> nodes(1, &m_image->GetRoot());
+    m_table = LoadImageRules(nodes);
+    return;
+  }
+
   if (opts->search.algo == SyntaxF2S || opts->search.algo == SyntaxT2S) {
     F2S::HyperTree *trie = new F2S::HyperTree(this);
     F2S::HyperTreeLoader loader;
@@ -60,5 +110,73 @@ void RuleTableFF::Load(Moses::AllOptions::ptr const& opts)
   }
 }
 
+RuleTable *RuleTableFF::CreateInputTable(const InputType &input) const
+{
+  if (!m_image) {
+    return NULL;
+  }
+  if (MatchesImageInPlace()) {
+    return new S2T::RuleTrieCYKPlusImage(this, *m_image, m_imageLabels, input);
+  }
+
+  std::vector<uint32_t> terminals;
+  terminals.reserve(input.GetSize());
+  for (std::size_t i = 0; i < input.GetSize(); ++i) {
+    uint32_t id = m_image->FindTerminal(
+                    input.GetWord(i).GetString(m_input, false));
+    if (id != RuleTrieImageFormat::kNone) {
+      terminals.push_back(id);
+    }
+  }
+  std::sort(terminals.begin(), terminals.end());
+  terminals.erase(std::unique(terminals.begin(), terminals.end()),
+                  terminals.end());
+
+  std::vector<const RuleTrieImage::Node *> nodes;
+  m_image->FindNodes(terminals, nodes);
+  return LoadImageRules(nodes);
+}
+
+bool RuleTableFF::MatchesImageInPlace() const
+{
+  return m_options->search.algo == SyntaxS2T &&
+         m_options->syntax.s2t_parsing_algo == RecursiveCYKPlus &&
+         m_image->HasSymbolTrie();
+}
+
+RuleTable *RuleTableFF::LoadImageRules(
+  const std::vector<const RuleTrieImage::Node *> &nodes) const
+{
+  const AllOptions &opts = *m_options;
+  if (opts.search.algo == SyntaxF2S || opts.search.algo == SyntaxT2S) {
+    F2S::HyperTree *trie = new F2S::HyperTree(this);
+    F2S::HyperTreeLoader loader;
+    loader.Load(opts, m_input, m_output, *m_image, nodes, *this, *trie);
+    return trie;
+  } else if (opts.search.algo == SyntaxS2T) {
+    S2TParsingAlgorithm algorithm = opts.syntax.s2t_parsing_algo;
+    if (algorithm == RecursiveCYKPlus) {
+      S2T::RuleTrieCYKPlus *trie = new S2T::RuleTrieCYKPlus(this);
+      S2T::RuleTrieLoader loader;
+      loader.Load(opts, m_input, m_output, *m_image, nodes, *this, *trie);
+      return trie;
+    } else if (algorithm == Scope3) {
+      S2T::RuleTrieScope3 *trie = new S2T::RuleTrieScope3(this);
+      S2T::RuleTrieLoader loader;
+      loader.Load(opts, m_input, m_output, *m_image, nodes, *this, *trie);
+      return trie;
+    } else {
+      UTIL_THROW2("ERROR: unhandled S2T parsing algorithm");
+    }
+  } else if (opts.search.algo == SyntaxT2S_SCFG) {
+    T2S::RuleTrie *trie = new T2S::RuleTrie(this);
+    T2S::RuleTrieLoader loader;
+    loader.Load(opts, m_input, m_output, *m_image, nodes, *this, *trie);
+    return trie;
+  }
+  UTIL_THROW2(
+    "ERROR: RuleTableFF currently only supports the S2T, T2S, T2S_SCFG, and F2S search algorithms");
+}
+
 }  // Syntax
 }  // Moses
@@ -1,15 +1,21 @@
 #pragma once
 
 #include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
 
 #include "moses/TranslationModel/PhraseDictionary.h"
 
+#include "RuleTrieImage.h"
+
 namespace Moses
 {
 
 class ChartParser;
 class ChartCellCollectionBase;
 class AllOptions;
+class InputType;
 namespace Syntax
 {
 
@@ -19,6 +25,16 @@ class RuleTable;
 // rule table).  The scores themselves are stored on TargetPhrase objects
 // and the decoder accesses them directly, so this object doesn't really do
 // anything except provide somewhere to store the weights and parameter values.
+//
+// The rule table is either a text file, which is loaded into a RuleTable in
+// full, or a compiled RuleTrieImage (see misc/CreateRuleTrieImage), which is
+// mapped.  With an image, the S2T CYK+ parser matches against the image
+// itself: GetTable() is NULL and CreateInputTable() returns a
+// S2T::RuleTrieCYKPlusImage, which builds the TargetPhrases of a rule only
+// when the parser reaches it.  The other parsers and rule matchers still need
+// a trie of their own, so for them GetTable() holds the rules without source
+// terminals, and CreateInputTable() copies the lexical rules that can apply
+// to an input out of the image into a new trie for each input.
 class RuleTableFF : public PhraseDictionary
 {
 public:
@@ -33,6 +49,14 @@ public:
     return m_table;
   }
 
+  // Creates a table holding the rules from the image that can apply to the
+  // input: a S2T::RuleTrieCYKPlusImage, which refers to the image, for the
+  // S2T CYK+ parser, and otherwise a table of the same type as GetTable()
+  // into which the rules whose source terminals all occur in the input are
+  // copied.  Returns NULL if the rule table was loaded from a text file.  The
+  // caller owns the table.
+  RuleTable *CreateInputTable(const InputType &) const;
+
   static const std::vector<RuleTableFF*> &Instances() {
     return s_instances;
   }
@@ -52,7 +76,14 @@ public:
 private:
   static std::vector<RuleTableFF*> s_instances;
 
+  bool MatchesImageInPlace() const;
+
+  RuleTable *LoadImageRules(
+    const std::vector<const RuleTrieImage::Node *> &) const;
+
   const RuleTable *m_table;
+  boost::scoped_ptr<RuleTrieImage> m_image;
+  std::vector<Word> m_imageLabels;
   boost::unordered_set<std::size_t> m_sourceTerminalSet;
 };
 
@@ -0,0 +1,164 @@
+#include "RuleTrieImage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "util/exception.hh"
+#include "util/file.hh"
+
+namespace Moses
+{
+namespace Syntax
+{
+
+using namespace RuleTrieImageFormat;
+
+namespace
+{
+
+bool EdgeLess(const Edge &edge, uint32_t word)
+{
+  return edge.word < word;
+}
+
+const Edge *FindEdge(const Edge *begin, const Edge *end, uint32_t word)
+{
+  const Edge *edge = std::lower_bound(begin, end, word, EdgeLess);
+  return (edge != end && edge->word == word) ? edge : NULL;
+}
+
+}  // namespace
+
+bool RuleTrieImage::IsImage(const std::string &path)
+{
+  char magic[sizeof(kMagic)];
+  std::ifstream in(path.c_str(), std::ios::binary);
+  return in.read(magic, sizeof(magic)) && !std::memcmp(magic, kMagic,
+         sizeof(kMagic));
+}
+
+void RuleTrieImage::Open(const std::string &path, bool populate)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(path.c_str()));
+  const uint64_t size = util::SizeOrThrow(file.get());
+  UTIL_THROW_IF2(size < sizeof(Header),
+                 path << " is too small to be a rule trie image");
+
+  util::MapRead(populate ? util::POPULATE_OR_READ : util::LAZY, file.get(), 0,
+                size, m_memory);
+  m_header = reinterpret_cast<const Header*>(m_memory.begin());
+
+  UTIL_THROW_IF2(std::memcmp(m_header->magic, kMagic, sizeof(kMagic)),
+                 path << " is not a rule trie image");
+  UTIL_THROW_IF2(m_header->byteOrder != kByteOrderMark,
+                 path << " was written on a machine with a different byte order");
+  UTIL_THROW_IF2(m_header->version != kVersion,
+                 "Rule trie image " << path << " is version " << m_header->version
+                 << ". This decoder reads version " << kVersion
+                 << ", please rebuild it");
+  for (std::size_t i = 0; i < NumSections; ++i) {
+    UTIL_THROW_IF2(m_header->offset[i] % 8 || m_header->offset[i] > size
+                   || m_header->size[i] > size - m_header->offset[i],
+                   "Rule trie image " << path << " is truncated or corrupt");
+  }
+
+  m_vocab = reinterpret_cast<const uint64_t*>(Section(Vocab));
+  m_nodes = reinterpret_cast<const Node*>(Section(Nodes));
+  m_edges = reinterpret_cast<const Edge*>(Section(Edges));
+  m_ruleIndex = reinterpret_cast<const uint64_t*>(Section(RuleIndex));
+  m_labels = reinterpret_cast<const uint64_t*>(Section(Labels));
+  m_symbolNodes = reinterpret_cast<const Node*>(Section(SymbolNodes));
+  m_symbolEdges = reinterpret_cast<const Edge*>(Section(SymbolEdges));
+  m_symbolRuleIndex = reinterpret_cast<const uint64_t*>(
+                        Section(SymbolRuleIndex));
+  UTIL_THROW_IF2(SectionSize<Node>(Nodes) == 0,
+                 "Rule trie image " << path << " has no root node");
+}
+
+uint32_t RuleTrieImage::FindTerminal(const StringPiece &word) const
+{
+  // binary search of the sorted vocabulary
+  uint32_t lo = 0;
+  uint32_t hi = GetVocabSize();
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    int cmp = GetTerminal(mid).compare(word);
+    if (cmp == 0) {
+      return mid;
+    } else if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return kNone;
+}
+
+void RuleTrieImage::FindNodes(const std::vector<uint32_t> &terminals,
+                              std::vector<const Node *> &nodes) const
+{
+  nodes.clear();
+  FindNodes(GetRoot(), terminals.begin(), terminals.end(), nodes);
+}
+
+void RuleTrieImage::FindNodes(const Node &node,
+                              std::vector<uint32_t>::const_iterator p,
+                              std::vector<uint32_t>::const_iterator end,
+                              std::vector<const Node *> &nodes) const
+{
+  // The edges below a node carry larger ids than the one leading to it, so
+  // each of the remaining terminals is looked up at most once per node.
+  const Edge *edge = m_edges + node.firstEdge;
+  const Edge *edgeEnd = edge + node.numEdges;
+  for (; p != end && edge != edgeEnd; ++p) {
+    edge = std::lower_bound(edge, edgeEnd, *p, EdgeLess);
+    if (edge != edgeEnd && edge->word == *p) {
+      const Node &child = m_nodes[edge->node];
+      if (child.numRules) {
+        nodes.push_back(&child);
+      }
+      FindNodes(child, p+1, end, nodes);
+      ++edge;
+    }
+  }
+}
+
+const RuleTrieImage::Node *RuleTrieImage::GetSymbolChild(
+  const Node &node, uint32_t terminal) const
+{
+  const Edge *begin = BeginSymbolEdges(node);
+  const Edge *edge = FindEdge(begin, begin + node.numEdges, terminal);
+  return edge ? &m_symbolNodes[edge->node] : NULL;
+}
+
+const RuleTrieImage::Edge *RuleTrieImage::BeginLabelEdges(
+  const Node &node) const
+{
+  const Edge *begin = BeginSymbolEdges(node);
+  return std::lower_bound(begin, begin + node.numEdges, kLabelBit, EdgeLess);
+}
+
+RuleTableEntry RuleTrieImage::GetRuleAt(uint64_t offset) const
+{
+  const char *data = Section(Rules) + offset;
+  const RuleHeader &header = *reinterpret_cast<const RuleHeader*>(data);
+  data += sizeof(RuleHeader);
+
+  RuleTableEntry entry;
+  entry.scores = reinterpret_cast<const float*>(data);
+  data += m_header->numScores * sizeof(float);
+  entry.source = StringPiece(data, header.sourceSize);
+  data += header.sourceSize;
+  entry.target = StringPiece(data, header.targetSize);
+  data += header.targetSize;
+  entry.alignment = StringPiece(data, header.alignmentSize);
+  data += header.alignmentSize;
+  entry.sparse = StringPiece(data, header.sparseSize);
+  data += header.sparseSize;
+  entry.properties = StringPiece(data, header.propertiesSize);
+  return entry;
+}
+
+}  // namespace Syntax
+}  // namespace Moses
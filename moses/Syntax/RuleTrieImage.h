@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "util/mmap.hh"
+#include "util/string_piece.hh"
+
+namespace Moses
+{
+namespace Syntax
+{
+
+// Binary image of a syntax rule table, written by RuleTrieImageWriter
+// (misc/CreateRuleTrieImage) and read by RuleTableFF instead of the text
+// table.
+//
+// Rules are indexed by the terminals of their source side: a rule is stored
+// at the trie node reached by following its distinct terminal ids in
+// increasing order.  The rules that can apply to an input are therefore found
+// by walking down from the root along the input's words only (FindNodes).
+// The root holds the rules with no source terminals at all.  Terminal ids are
+// positions in a sorted vocabulary, which is searched in place.  A rule record
+// keeps the fields of the text table apart from the counts, with the scores
+// already transformed and floored.  All references are array indices or byte
+// offsets from the start of the file, so the image is mapped rather than
+// parsed.
+//
+// For string source sides the image also holds a symbol trie (SymbolNodes
+// and SymbolEdges), in which a rule is stored at the node reached by
+// following its source side symbol by symbol, the way the CYK+ parser walks
+// its RuleTrieCYKPlus.  A terminal is keyed by its id, a non-terminal by the
+// id of the label of the target non-terminal it is aligned to, with kLabelBit
+// set; so the terminal edges of a node come before its non-terminal edges.
+// S2T::RuleTrieCYKPlusImage lets the CYK+ parser match against it in place.
+// The other parsers and rule matchers only work on their own in-memory
+// tries, into which the rules FindNodes selects are read out of the image,
+// once at start-up for the root's rules and once per input for the rest (see
+// RuleTableFF::CreateInputTable).
+//
+// Integers are in the byte order of the machine that wrote the image.
+namespace RuleTrieImageFormat
+{
+
+const char kMagic[8] = { 'm', 'o', 's', 'e', 's', 's', 't', 'i' };
+const uint32_t kVersion = 2;
+const uint32_t kByteOrderMark = 0x01020304;
+// terminal id of a word that is not in the vocabulary
+const uint32_t kNone = 0xFFFFFFFF;
+// marks the edges of the symbol trie that are labelled with a non-terminal
+const uint32_t kLabelBit = 0x80000000;
+
+// How the terminals are found in a rule's source side.
+enum SourceFormat {
+  StringSource = 0,  // SCFG rules, as read by S2T and T2S::RuleTrieLoader
+  TreeSource = 1     // tree fragments, as read by F2S::HyperTreeLoader
+};
+
+enum Section {
+  Strings = 0,      // NUL-terminated terminal and label strings
+  Vocab,            // uint64_t[], offset in Strings of each terminal, sorted
+  Nodes,            // Node[], the root is node 0
+  Edges,            // Edge[]
+  RuleIndex,        // uint64_t[], offset in Rules of each rule
+  Rules,            // rule records
+  Labels,           // uint64_t[], offset in Strings of each label, sorted
+  SymbolNodes,      // Node[] of the symbol trie, empty for tree sources
+  SymbolEdges,      // Edge[] of the symbol trie
+  SymbolRuleIndex,  // uint64_t[], offset in Rules of each rule in the symbol trie
+  NumSections
+};
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t sourceFormat;
+  uint32_t numScores;
+  uint64_t offset[NumSections];  // from the start of the file, 8-byte aligned
+  uint64_t size[NumSections];    // in bytes
+};
+
+struct Node {
+  uint64_t firstRule;  // in RuleIndex
+  uint32_t numRules;
+  uint32_t firstEdge;
+  uint32_t numEdges;
+  uint32_t reserved;
+};
+
+// Edges leaving a node are sorted by word.  The nodes and edges of the symbol
+// trie refer to SymbolEdges, SymbolNodes and SymbolRuleIndex instead.
+struct Edge {
+  uint32_t word;
+  uint32_t node;
+};
+
+// Fixed part of a rule record.  It is followed by
+//   float scores[numScores]
+//   char source[sourceSize], target[targetSize], alignment[alignmentSize],
+//        sparse[sparseSize], properties[propertiesSize]
+// and padding up to a multiple of 4 bytes.
+struct RuleHeader {
+  uint32_t sourceSize;
+  uint32_t targetSize;
+  uint32_t alignmentSize;
+  uint32_t sparseSize;
+  uint32_t propertiesSize;
+};
+
+}  // namespace RuleTrieImageFormat
+
+// One rule as it appears in a text rule table, without the counts.  The
+// scores have been transformed and floored.  The loaders fill it from a line
+// of the text table or take it from a RuleTrieImage.
+struct RuleTableEntry {
+  StringPiece source;
+  StringPiece target;
+  StringPiece alignment;
+  StringPiece sparse;
+  StringPiece properties;
+  const float *scores;
+};
+
+// Read-only view of a mapped RuleTrieImage.
+class RuleTrieImage
+{
+public:
+  typedef RuleTrieImageFormat::Node Node;
+  typedef RuleTrieImageFormat::Edge Edge;
+
+  // Checks whether the file starts like an image rather than a text table.
+  static bool IsImage(const std::string &path);
+
+  RuleTrieImage() : m_header(NULL) {}
+
+  // Map the image; with populate, read it all in up front.
+  void Open(const std::string &path, bool populate);
+
+  RuleTrieImageFormat::SourceFormat GetSourceFormat() const {
+    return RuleTrieImageFormat::SourceFormat(m_header->sourceFormat);
+  }
+
+  std::size_t GetNumScores() const {
+    return m_header->numScores;
+  }
+
+  std::size_t GetVocabSize() const {
+    return SectionSize<uint64_t>(RuleTrieImageFormat::Vocab);
+  }
+
+  StringPiece GetTerminal(uint32_t id) const {
+    return StringPiece(Section(RuleTrieImageFormat::Strings) + m_vocab[id]);
+  }
+
+  // Returns the id of a terminal, or kNone if no rule uses it.
+  uint32_t FindTerminal(const StringPiece &) const;
+
+  const Node &GetRoot() const {
+    return m_nodes[0];
+  }
+
+  // Collects the nodes below the root whose rules use only the given
+  // terminals, which must be sorted and distinct.
+  void FindNodes(const std::vector<uint32_t> &terminals,
+                 std::vector<const Node *> &nodes) const;
+
+  RuleTableEntry GetRule(const Node &node, std::size_t i) const {
+    return GetRuleAt(m_ruleIndex[node.firstRule + i]);
+  }
+
+  // Non-terminal labels, as they appear on the target side.
+  std::size_t GetNumLabels() const {
+    return SectionSize<uint64_t>(RuleTrieImageFormat::Labels);
+  }
+
+  StringPiece GetLabel(uint32_t id) const {
+    return StringPiece(Section(RuleTrieImageFormat::Strings) + m_labels[id]);
+  }
+
+  // The symbol trie; only images of string source sides have one.
+  bool HasSymbolTrie() const {
+    return SectionSize<Node>(RuleTrieImageFormat::SymbolNodes) != 0;
+  }
+
+  const Node &GetSymbolRoot() const {
+    return m_symbolNodes[0];
+  }
+
+  // Returns the child of a symbol trie node along a terminal, or NULL.
+  const Node *GetSymbolChild(const Node &, uint32_t terminal) const;
+
+  // The edges of a symbol trie node, terminal edges first.
+  const Edge *BeginSymbolEdges(const Node &node) const {
+    return m_symbolEdges + node.firstEdge;
+  }
+
+  // The non-terminal edges of a symbol trie node.
+  const Edge *BeginLabelEdges(const Node &) const;
+
+  const Edge *EndLabelEdges(const Node &node) const {
+    return m_symbolEdges + node.firstEdge + node.numEdges;
+  }
+
+  const Node &GetSymbolNode(const Edge &edge) const {
+    return m_symbolNodes[edge.node];
+  }
+
+  RuleTableEntry GetSymbolRule(const Node &node, std::size_t i) const {
+    return GetRuleAt(m_symbolRuleIndex[node.firstRule + i]);
+  }
+
+private:
+  RuleTableEntry GetRuleAt(uint64_t offset) const;
+
+  void FindNodes(const Node &, std::vector<uint32_t>::const_iterator,
+                 std::vector<uint32_t>::const_iterator,
+                 std::vector<const Node *> &) const;
+
+  const char *Section(RuleTrieImageFormat::Section section) const {
+    return m_memory.begin() + m_header->offset[section];
+  }
+
+  template <class T>
+  std::size_t SectionSize(RuleTrieImageFormat::Section section) const {
+    return m_header->size[section] / sizeof(T);
+  }
+
+  util::scoped_memory m_memory;
+  const RuleTrieImageFormat::Header *m_header;
+  const uint64_t *m_vocab;
+  const Node *m_nodes;
+  const Edge *m_edges;
+  const uint64_t *m_ruleIndex;
+  const uint64_t *m_labels;
+  const Node *m_symbolNodes;
+  const Edge *m_symbolEdges;
+  const uint64_t *m_symbolRuleIndex;
+};
+
+}  // namespace Syntax
+}  // namespace Moses
@@ -0,0 +1,227 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2016- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "RuleTrieImage.h"
+#include "RuleTrieImageWriter.h"
+#include "util/exception.hh"
+
+using namespace Moses::Syntax;
+using namespace std;
+using RuleTrieImageFormat::kNone;
+
+namespace
+{
+
+struct ImageFixture {
+  ImageFixture() : path(boost::filesystem::unique_path(
+                            boost::filesystem::temp_directory_path() / "rule-trie-image-%%%%%%%%").string()) {}
+  ~ImageFixture() {
+    boost::filesystem::remove(path);
+  }
+
+  // the source sides of the rules that apply to a sentence
+  vector<string> Match(const RuleTrieImage &image, const string &sentence) {
+    vector<uint32_t> terminals;
+    for (size_t pos = 0, end; pos < sentence.size(); pos = end + 1) {
+      end = min(sentence.find(' ', pos), sentence.size());
+      uint32_t id = image.FindTerminal(sentence.substr(pos, end - pos));
+      if (id != kNone) terminals.push_back(id);
+    }
+    sort(terminals.begin(), terminals.end());
+    terminals.erase(unique(terminals.begin(), terminals.end()), terminals.end());
+
+    vector<const RuleTrieImage::Node *> nodes;
+    image.FindNodes(terminals, nodes);
+    vector<string> ret;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      for (size_t j = 0; j < nodes[i]->numRules; ++j) {
+        ret.push_back(image.GetRule(*nodes[i], j).source.as_string());
+      }
+    }
+    sort(ret.begin(), ret.end());
+    return ret;
+  }
+
+  string path;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(rule_trie_image)
+
+BOOST_FIXTURE_TEST_CASE(string_source, ImageFixture)
+{
+  RuleTrieImageWriter writer(2, RuleTrieImageFormat::StringSource);
+  writer.AddRule("das Haus [X] ||| the house [X] ||| 0.5 0.25 ||| 0-1 1-1 ||| 1 1 1");
+  writer.AddRule("[X][NP] [X][VP] [S] ||| [X][NP] [X][VP] [S] ||| 1 0.5 ||| 0-0 1-1");
+  writer.AddRule("das [X][NN] [NP] ||| the [X][NN] [NP] ||| 1 1 ||| 1-1 ||| 1 1 1 ||| sp=1 ||| {{Tree [NP]}}");
+  writer.AddRule("Haus das [X] ||| house of the [X] ||| 0.1 0.2 ||| ");
+  writer.AddRule("Haus [X] ||| home [X] ||| 0.1 0.2");
+  BOOST_CHECK_EQUAL(writer.GetNumRules(), 5);
+  writer.Write(path);
+
+  BOOST_CHECK(RuleTrieImage::IsImage(path));
+  RuleTrieImage image;
+  image.Open(path, false);
+  BOOST_CHECK_EQUAL(image.GetSourceFormat(), RuleTrieImageFormat::StringSource);
+  BOOST_CHECK_EQUAL(image.GetNumScores(), 2);
+  BOOST_REQUIRE_EQUAL(image.GetVocabSize(), 2);
+  BOOST_CHECK_EQUAL(image.GetTerminal(0), "Haus");
+  BOOST_CHECK_EQUAL(image.GetTerminal(1), "das");
+  BOOST_CHECK_EQUAL(image.FindTerminal("das"), 1);
+  BOOST_CHECK_EQUAL(image.FindTerminal("Hau"), kNone);
+  BOOST_CHECK_EQUAL(image.FindTerminal("[X]"), kNone);
+
+  // unlexicalized rules are at the root
+  const RuleTrieImage::Node &root = image.GetRoot();
+  BOOST_REQUIRE_EQUAL(root.numRules, 1);
+  RuleTableEntry entry = image.GetRule(root, 0);
+  BOOST_CHECK_EQUAL(entry.source, "[X][NP] [X][VP] [S] ");
+  BOOST_CHECK_EQUAL(entry.target, " [X][NP] [X][VP] [S] ");
+  BOOST_CHECK_CLOSE(entry.scores[0], 0.0f, 0.001);
+  BOOST_CHECK_CLOSE(entry.scores[1], log(0.5f), 0.001);
+  BOOST_CHECK_EQUAL(entry.alignment, " 0-0 1-1");
+  BOOST_CHECK(entry.sparse.empty());
+
+  // rules are found by the set of their terminals, whatever the order
+  vector<string> matched = Match(image, "ein Haus");
+  BOOST_REQUIRE_EQUAL(matched.size(), 1);
+  BOOST_CHECK_EQUAL(matched[0], "Haus [X] ");
+  matched = Match(image, "das");
+  BOOST_REQUIRE_EQUAL(matched.size(), 1);
+  BOOST_CHECK_EQUAL(matched[0], "das [X][NN] [NP] ");
+  matched = Match(image, "Haus das Haus");
+  BOOST_REQUIRE_EQUAL(matched.size(), 4);
+  BOOST_CHECK_EQUAL(matched[0], "Haus [X] ");
+  BOOST_CHECK_EQUAL(matched[1], "Haus das [X] ");
+  BOOST_CHECK_EQUAL(matched[2], "das Haus [X] ");
+  BOOST_CHECK_EQUAL(matched[3], "das [X][NN] [NP] ");
+  BOOST_CHECK(Match(image, "ein Hund").empty());
+
+  // the other fields are kept as they are
+  vector<uint32_t> das(1, image.FindTerminal("das"));
+  vector<const RuleTrieImage::Node *> nodes;
+  image.FindNodes(das, nodes);
+  BOOST_REQUIRE_EQUAL(nodes.size(), 1);
+  entry = image.GetRule(*nodes[0], 0);
+  BOOST_CHECK_EQUAL(entry.sparse, " sp=1 ");
+  BOOST_CHECK_EQUAL(entry.properties, " {{Tree [NP]}}");
+
+  // the symbol trie is keyed by the target labels of the non-terminals
+  BOOST_REQUIRE(image.HasSymbolTrie());
+  BOOST_REQUIRE_EQUAL(image.GetNumLabels(), 3);
+  BOOST_CHECK_EQUAL(image.GetLabel(0), "NN");
+  BOOST_CHECK_EQUAL(image.GetLabel(1), "NP");
+  BOOST_CHECK_EQUAL(image.GetLabel(2), "VP");
+  const RuleTrieImage::Node &symbolRoot = image.GetSymbolRoot();
+  BOOST_CHECK_EQUAL(symbolRoot.numRules, 0);
+  const RuleTrieImage::Node *node = image.GetSymbolChild(symbolRoot, 1);
+  BOOST_REQUIRE(node);
+  BOOST_CHECK_EQUAL(node->numRules, 0);
+  const RuleTrieImage::Node *house = image.GetSymbolChild(*node, 0);
+  BOOST_REQUIRE(house);
+  BOOST_REQUIRE_EQUAL(house->numRules, 1);
+  BOOST_CHECK_EQUAL(image.GetSymbolRule(*house, 0).source, "das Haus [X] ");
+  const RuleTrieImage::Edge *edge = image.BeginLabelEdges(*node);
+  BOOST_REQUIRE(edge != image.EndLabelEdges(*node));
+  BOOST_CHECK_EQUAL(edge->word, RuleTrieImageFormat::kLabelBit | 0);
+  const RuleTrieImage::Node &nn = image.GetSymbolNode(*edge);
+  BOOST_REQUIRE_EQUAL(nn.numRules, 1);
+  BOOST_CHECK_EQUAL(image.GetSymbolRule(nn, 0).source, "das [X][NN] [NP] ");
+  BOOST_CHECK(++edge == image.EndLabelEdges(*node));
+  BOOST_CHECK(!image.GetSymbolChild(*house, 1));
+
+  edge = image.BeginLabelEdges(symbolRoot);
+  BOOST_REQUIRE_EQUAL(image.EndLabelEdges(symbolRoot) - edge, 1);
+  BOOST_CHECK_EQUAL(edge->word, RuleTrieImageFormat::kLabelBit | 1);
+  node = &image.GetSymbolNode(*edge);
+  edge = image.BeginLabelEdges(*node);
+  BOOST_REQUIRE_EQUAL(image.EndLabelEdges(*node) - edge, 1);
+  BOOST_CHECK_EQUAL(edge->word, RuleTrieImageFormat::kLabelBit | 2);
+  BOOST_REQUIRE_EQUAL(image.GetSymbolNode(*edge).numRules, 1);
+  BOOST_CHECK_EQUAL(image.GetSymbolRule(image.GetSymbolNode(*edge), 0).source,
+                    "[X][NP] [X][VP] [S] ");
+}
+
+BOOST_FIXTURE_TEST_CASE(symbol_trie_skips_unaligned_non_terminals,
+                        ImageFixture)
+{
+  RuleTrieImageWriter writer(1, RuleTrieImageFormat::StringSource);
+  writer.AddRule("das [X][NN] [NP] ||| the [X][NN] [NP] ||| 1 ||| ");
+  writer.AddRule("das [X] ||| the [X] ||| 1 ||| 0-0");
+  writer.Write(path);
+
+  RuleTrieImage image;
+  image.Open(path, false);
+  BOOST_REQUIRE(image.HasSymbolTrie());
+  BOOST_CHECK_EQUAL(image.GetNumLabels(), 0);
+  const RuleTrieImage::Node *node =
+    image.GetSymbolChild(image.GetSymbolRoot(), image.FindTerminal("das"));
+  BOOST_REQUIRE(node);
+  BOOST_REQUIRE_EQUAL(node->numRules, 1);
+  BOOST_CHECK_EQUAL(image.GetSymbolRule(*node, 0).source, "das [X] ");
+  BOOST_CHECK(image.BeginLabelEdges(*node) == image.EndLabelEdges(*node));
+  // it is still in the terminal index
+  vector<string> matched = Match(image, "das");
+  BOOST_CHECK_EQUAL(matched.size(), 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(tree_source, ImageFixture)
+{
+  RuleTrieImageWriter writer(1, RuleTrieImageFormat::TreeSource);
+  writer.AddRule("[NP [DT the] [NN]] ||| [X][NN] [X] ||| 0.5 ||| 1-0");
+  writer.AddRule("[S [NP] [VP]] ||| [X][NP] [X][VP] [X] ||| 0.5 ||| 0-0 1-1");
+  writer.AddRule("[NN house] ||| maison [X] ||| 0.5 ||| ");
+  writer.Write(path);
+
+  RuleTrieImage image;
+  image.Open(path, true);
+  BOOST_CHECK_EQUAL(image.GetSourceFormat(), RuleTrieImageFormat::TreeSource);
+  // labels aren't terminals
+  BOOST_REQUIRE_EQUAL(image.GetVocabSize(), 2);
+  BOOST_CHECK_EQUAL(image.GetTerminal(0), "house");
+  BOOST_CHECK_EQUAL(image.GetTerminal(1), "the");
+  BOOST_CHECK_EQUAL(image.GetRoot().numRules, 1);
+
+  vector<string> matched = Match(image, "the DT NN");
+  BOOST_REQUIRE_EQUAL(matched.size(), 1);
+  BOOST_CHECK_EQUAL(matched[0], "[NP [DT the] [NN]] ");
+  BOOST_CHECK(!image.HasSymbolTrie());
+}
+
+BOOST_FIXTURE_TEST_CASE(rejects_other_files, ImageFixture)
+{
+  FILE *file = fopen(path.c_str(), "w");
+  fputs("das Haus [X] ||| the house [X] ||| 0.5 ||| 0-1 1-1\n", file);
+  fclose(file);
+  BOOST_CHECK(!RuleTrieImage::IsImage(path));
+  RuleTrieImage image;
+  BOOST_CHECK_THROW(image.Open(path, false), util::Exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
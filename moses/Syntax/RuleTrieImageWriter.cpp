@@ -0,0 +1,452 @@
+#include "RuleTrieImageWriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "moses/Syntax/F2S/TreeFragmentTokenizer.h"
+#include "moses/Util.h"
+#include "util/double-conversion/double-conversion.h"
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/tokenize_piece.hh"
+
+namespace Moses
+{
+namespace Syntax
+{
+
+using namespace RuleTrieImageFormat;
+
+namespace
+{
+
+bool IsNonTerminal(const StringPiece &word)
+{
+  return word.size() > 1 && word.data()[0] == '['
+         && word.data()[word.size()-1] == ']';
+}
+
+// The words of one side of a rule, without its left-hand side.
+void SplitWords(const StringPiece &side, std::vector<StringPiece> &words)
+{
+  words.clear();
+  for (util::TokenIter<util::AnyCharacter, true> p(side, " \t"); p; ++p) {
+    words.push_back(*p);
+  }
+  if (!words.empty() && IsNonTerminal(words.back())) {
+    words.pop_back();
+  }
+}
+
+// The label that Phrase::CreateFromString gives a target non-terminal such
+// as [X][NP], or an empty string if it is malformed.
+StringPiece TargetLabel(const StringPiece &word)
+{
+  std::size_t next = word.find('[', 1);
+  if (next == StringPiece::npos) {
+    return StringPiece();
+  }
+  return word.substr(next + 1, word.size() - next - 2);
+}
+
+template<typename T>
+void Append(std::string &out, const T *data, std::size_t count)
+{
+  out.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+
+void Pad(std::string &out, std::size_t alignment)
+{
+  out.resize((out.size() + alignment - 1) / alignment * alignment, '\0');
+}
+
+struct EdgeRef {
+  uint32_t parent;
+  Edge edge;
+};
+
+bool EdgeRefLess(const EdgeRef &a, const EdgeRef &b)
+{
+  return a.parent < b.parent;
+}
+
+// Appends the words to strings in sorted order, recording the offset of each
+// in offsets and its new id in newIds.
+void SortVocab(const std::vector<std::string> &words, std::string &strings,
+               std::vector<uint32_t> &newIds, std::vector<uint64_t> &offsets)
+{
+  std::vector<std::pair<std::string, uint32_t> > sorted;
+  sorted.reserve(words.size());
+  for (std::size_t i = 0; i < words.size(); ++i) {
+    sorted.push_back(std::make_pair(words[i], uint32_t(i)));
+  }
+  std::sort(sorted.begin(), sorted.end());
+  newIds.resize(words.size());
+  offsets.resize(sorted.size());
+  for (std::size_t i = 0; i < sorted.size(); ++i) {
+    newIds[sorted[i].second] = i;
+    offsets[i] = strings.size();
+    strings.append(sorted[i].first);
+    strings += '\0';
+  }
+}
+
+}  // namespace
+
+// Orders rules by their keys, lexicographically.
+struct RuleTrieImageWriter::KeyOrder {
+  KeyOrder(const std::vector<uint32_t> &k, const std::vector<uint64_t> &o)
+    : keys(k), offsets(o) {}
+
+  bool operator()(std::size_t a, std::size_t b) const {
+    return std::lexicographical_compare(
+             keys.begin() + offsets[a], keys.begin() + offsets[a+1],
+             keys.begin() + offsets[b], keys.begin() + offsets[b+1]);
+  }
+
+  const std::vector<uint32_t> &keys;
+  const std::vector<uint64_t> &offsets;
+};
+
+RuleTrieImageWriter::RuleTrieImageWriter(std::size_t numScores,
+    SourceFormat sourceFormat)
+  : m_numScores(numScores)
+  , m_sourceFormat(sourceFormat)
+{
+  m_terminalOffsets.push_back(0);
+  m_symbolOffsets.push_back(0);
+}
+
+void RuleTrieImageWriter::AddRule(const StringPiece &line)
+{
+  util::TokenIter<util::MultiCharacter> pipes(line, "|||");
+  StringPiece sourceString(*pipes);
+  StringPiece targetString(*++pipes);
+  StringPiece scoreString(*++pipes);
+  StringPiece alignString, sparseString, propertiesString;
+  if (++pipes) alignString = *pipes;
+  ++pipes;  // skip over counts field
+  if (++pipes) sparseString = *pipes;
+  if (++pipes) propertiesString = *pipes;
+
+  double_conversion::StringToDoubleConverter converter(
+    double_conversion::StringToDoubleConverter::NO_FLAGS, NAN, NAN, "inf",
+    "nan");
+  m_scores.clear();
+  for (util::TokenIter<util::AnyCharacter, true> s(scoreString, " \t"); s;
+       ++s) {
+    int processed;
+    float score = converter.StringToFloat(s->data(), s->length(), &processed);
+    UTIL_THROW_IF2(std::isnan(score), "Bad score " << *s << " in rule " << line);
+    m_scores.push_back(FloorScore(TransformScore(score)));
+  }
+  UTIL_THROW_IF2(m_scores.size() != m_numScores,
+                 "Size of scoreVector != number (" << m_scores.size() << "!="
+                 << m_numScores << ") of score components in rule " << line);
+
+  ExtractTerminals(sourceString);
+  m_terminalOffsets.push_back(m_terminals.size());
+  if (m_sourceFormat == StringSource) {
+    if (ExtractSymbols(sourceString, targetString, alignString)) {
+      m_symbolRules.push_back(m_ruleOffsets.size());
+      m_symbolOffsets.push_back(m_symbols.size());
+    }
+  }
+
+  m_ruleOffsets.push_back(m_rules.size());
+  RuleHeader header;
+  header.sourceSize = sourceString.size();
+  header.targetSize = targetString.size();
+  header.alignmentSize = alignString.size();
+  header.sparseSize = sparseString.size();
+  header.propertiesSize = propertiesString.size();
+  Append(m_rules, &header, 1);
+  if (!m_scores.empty()) {
+    Append(m_rules, &m_scores[0], m_scores.size());
+  }
+  m_rules.append(sourceString.data(), sourceString.size());
+  m_rules.append(targetString.data(), targetString.size());
+  m_rules.append(alignString.data(), alignString.size());
+  m_rules.append(sparseString.data(), sparseString.size());
+  m_rules.append(propertiesString.data(), propertiesString.size());
+  Pad(m_rules, 4);
+}
+
+void RuleTrieImageWriter::ExtractTerminals(const StringPiece &source)
+{
+  if (m_sourceFormat == StringSource) {
+    // Every word that isn't a non-terminal (including the LHS) is a terminal.
+    for (util::TokenIter<util::AnyCharacter, true> p(source, " \t"); p; ++p) {
+      if (!IsNonTerminal(*p)) {
+        m_terminals.push_back(GetVocabId(*p));
+      }
+    }
+    return;
+  }
+
+  // In a tree fragment, every word that doesn't follow an opening bracket is
+  // a terminal (see HyperPathLoader).
+  F2S::TreeFragmentTokenizer p(source);
+  F2S::TreeFragmentTokenizer end;
+  bool isLabel = false;
+  for (; p != end; ++p) {
+    if (p->type == F2S::TreeFragmentToken_WORD && !isLabel) {
+      m_terminals.push_back(GetVocabId(p->value));
+    }
+    isLabel = (p->type == F2S::TreeFragmentToken_LSB);
+  }
+}
+
+bool RuleTrieImageWriter::ExtractSymbols(const StringPiece &source,
+    const StringPiece &target,
+    const StringPiece &alignment)
+{
+  // Like RuleTrieCYKPlus::GetOrCreateNode, take the source non-terminals in
+  // order along the alignments to target non-terminals, sorted.
+  std::vector<StringPiece> targetWords;
+  SplitWords(target, targetWords);
+  std::vector<std::pair<std::size_t, std::size_t> > alignNonTerm;
+  for (util::TokenIter<util::AnyCharacter, true> p(alignment, " \t"); p;
+       ++p) {
+    std::size_t dash = p->find('-');
+    if (dash == StringPiece::npos) {
+      return false;
+    }
+    std::size_t s = std::strtoul(p->data(), NULL, 10);
+    std::size_t t = std::strtoul(p->data() + dash + 1, NULL, 10);
+    if (t < targetWords.size() && IsNonTerminal(targetWords[t])) {
+      alignNonTerm.push_back(std::make_pair(s, t));
+    }
+  }
+  std::sort(alignNonTerm.begin(), alignNonTerm.end());
+  alignNonTerm.erase(std::unique(alignNonTerm.begin(), alignNonTerm.end()),
+                     alignNonTerm.end());
+
+  std::vector<StringPiece> sourceWords;
+  SplitWords(source, sourceWords);
+  const std::size_t begin = m_symbols.size();
+  std::size_t next = 0;
+  for (std::size_t pos = 0; pos < sourceWords.size(); ++pos) {
+    if (!IsNonTerminal(sourceWords[pos])) {
+      m_symbols.push_back(GetVocabId(sourceWords[pos]));
+      continue;
+    }
+    StringPiece label;
+    if (next < alignNonTerm.size() && alignNonTerm[next].first == pos) {
+      label = TargetLabel(targetWords[alignNonTerm[next++].second]);
+    }
+    if (label.empty()) {
+      m_symbols.resize(begin);
+      return false;
+    }
+    m_symbols.push_back(kLabelBit | GetLabelId(label));
+  }
+  return true;
+}
+
+uint32_t RuleTrieImageWriter::GetVocabId(const StringPiece &word)
+{
+  std::pair<VocabIds::iterator, bool> ins = m_vocabIds.insert(
+        std::make_pair(word.as_string(), uint32_t(m_vocab.size())));
+  if (ins.second) {
+    UTIL_THROW_IF2(m_vocab.size() == kLabelBit,
+                   "Vocabulary too large for a rule trie image");
+    m_vocab.push_back(ins.first->first);
+  }
+  return ins.first->second;
+}
+
+uint32_t RuleTrieImageWriter::GetLabelId(const StringPiece &label)
+{
+  std::pair<VocabIds::iterator, bool> ins = m_labelIds.insert(
+        std::make_pair(label.as_string(), uint32_t(m_labels.size())));
+  if (ins.second) {
+    UTIL_THROW_IF2(m_labels.size() == kLabelBit,
+                   "Too many labels for a rule trie image");
+    m_labels.push_back(ins.first->first);
+  }
+  return ins.first->second;
+}
+
+// Builds a trie over the keys of the given rules: keys[keyOffsets[i],
+// keyOffsets[i+1]) is the key of rules[i].  Each rule is stored at the node
+// its key leads to, and rules with equal keys stay in table order.
+void RuleTrieImageWriter::BuildTrie(const std::vector<uint32_t> &keys,
+                                    const std::vector<uint64_t> &keyOffsets,
+                                    const std::vector<std::size_t> &rules,
+                                    std::vector<Node> &nodes,
+                                    std::vector<Edge> &edges,
+                                    std::vector<uint64_t> &ruleIndex) const
+{
+  // Sort the rules by key and build the trie in a single pass over them.
+  std::vector<std::size_t> order(rules.size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), KeyOrder(keys, keyOffsets));
+
+  const uint32_t *allKeys = keys.empty() ? NULL : &keys[0];
+  nodes.assign(1, Node());
+  std::memset(&nodes[0], 0, sizeof(Node));
+  std::vector<EdgeRef> edgeRefs;
+  ruleIndex.resize(order.size());
+  std::vector<uint32_t> stack(1, 0);  // nodes from the root to the last key
+  std::size_t prev = 0;
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    const std::size_t r = order[i];
+    const uint32_t *key = allKeys + keyOffsets[r];
+    const std::size_t keySize = keyOffsets[r+1] - keyOffsets[r];
+    // Keep the part of the path shared with the previous rule's key.
+    std::size_t shared = 0;
+    if (i > 0) {
+      const uint32_t *prevKey = allKeys + keyOffsets[prev];
+      const std::size_t prevSize = keyOffsets[prev+1] - keyOffsets[prev];
+      while (shared < keySize && shared < prevSize &&
+             key[shared] == prevKey[shared]) {
+        ++shared;
+      }
+    }
+    stack.resize(shared + 1);
+    for (std::size_t j = shared; j < keySize; ++j) {
+      UTIL_THROW_IF2(nodes.size() == kNone,
+                     "Too many nodes for a rule trie image");
+      EdgeRef ref;
+      ref.parent = stack.back();
+      ref.edge.word = key[j];
+      ref.edge.node = nodes.size();
+      edgeRefs.push_back(ref);
+      nodes.push_back(Node());
+      std::memset(&nodes.back(), 0, sizeof(Node));
+      stack.push_back(ref.edge.node);
+    }
+    Node &node = nodes[stack.back()];
+    if (node.numRules == 0) {
+      node.firstRule = i;
+    }
+    ++node.numRules;
+    ruleIndex[i] = m_ruleOffsets[rules[r]];
+    prev = r;
+  }
+
+  // Group the edges by parent.  Each parent's edges were created in order of
+  // word, which the stable sort keeps.
+  std::stable_sort(edgeRefs.begin(), edgeRefs.end(), EdgeRefLess);
+  edges.resize(edgeRefs.size());
+  for (std::size_t i = 0; i < edgeRefs.size(); ++i) {
+    Node &parent = nodes[edgeRefs[i].parent];
+    if (parent.numEdges == 0) {
+      parent.firstEdge = i;
+    }
+    ++parent.numEdges;
+    edges[i] = edgeRefs[i].edge;
+  }
+}
+
+void RuleTrieImageWriter::Write(const std::string &path) const
+{
+  // Number the terminals and then the labels in string order and write them
+  // out.
+  std::string strings;
+  std::vector<uint32_t> newIds;
+  std::vector<uint64_t> vocab;
+  std::vector<uint32_t> newLabelIds;
+  std::vector<uint64_t> labels;
+  SortVocab(m_vocab, strings, newIds, vocab);
+  SortVocab(m_labels, strings, newLabelIds, labels);
+
+  // The key of a rule in the terminal index is its set of terminal ids, in
+  // increasing order.
+  std::vector<uint32_t> keys;
+  std::vector<uint64_t> keyOffsets(1, 0);
+  std::vector<std::size_t> rules(m_ruleOffsets.size());
+  keys.reserve(m_terminals.size());
+  keyOffsets.reserve(m_ruleOffsets.size() + 1);
+  for (std::size_t i = 0; i < m_ruleOffsets.size(); ++i) {
+    std::size_t begin = keys.size();
+    for (uint64_t j = m_terminalOffsets[i]; j < m_terminalOffsets[i+1]; ++j) {
+      keys.push_back(newIds[m_terminals[j]]);
+    }
+    std::sort(keys.begin() + begin, keys.end());
+    keys.erase(std::unique(keys.begin() + begin, keys.end()), keys.end());
+    keyOffsets.push_back(keys.size());
+    rules[i] = i;
+  }
+  std::vector<Node> nodes;
+  std::vector<Edge> edges;
+  std::vector<uint64_t> ruleIndex;
+  BuildTrie(keys, keyOffsets, rules, nodes, edges, ruleIndex);
+
+  // The key of a rule in the symbol trie is its source side.
+  std::vector<Node> symbolNodes;
+  std::vector<Edge> symbolEdges;
+  std::vector<uint64_t> symbolRuleIndex;
+  if (m_sourceFormat == StringSource) {
+    keys.resize(m_symbols.size());
+    for (std::size_t i = 0; i < m_symbols.size(); ++i) {
+      const uint32_t symbol = m_symbols[i];
+      keys[i] = (symbol & kLabelBit)
+                ? kLabelBit | newLabelIds[symbol & ~kLabelBit]
+                : newIds[symbol];
+    }
+    BuildTrie(keys, m_symbolOffsets, m_symbolRules, symbolNodes, symbolEdges, symbolRuleIndex);
+  }
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byteOrder = kByteOrderMark;
+  header.sourceFormat = m_sourceFormat;
+  header.numScores = m_numScores;
+
+  const char *data[NumSections];
+  data[Strings] = strings.data();
+  header.size[Strings] = strings.size();
+  data[Vocab] = reinterpret_cast<const char*>(vocab.empty() ? NULL : &vocab[0]);
+  header.size[Vocab] = vocab.size() * sizeof(uint64_t);
+  data[Nodes] = reinterpret_cast<const char*>(&nodes[0]);
+  header.size[Nodes] = nodes.size() * sizeof(Node);
+  data[Edges] = reinterpret_cast<const char*>(edges.empty() ? NULL : &edges[0]);
+  header.size[Edges] = edges.size() * sizeof(Edge);
+  data[RuleIndex] = reinterpret_cast<const char*>(
+                      ruleIndex.empty() ? NULL : &ruleIndex[0]);
+  header.size[RuleIndex] = ruleIndex.size() * sizeof(uint64_t);
+  data[Rules] = m_rules.data();
+  header.size[Rules] = m_rules.size();
+  data[Labels] = reinterpret_cast<const char*>(
+                   labels.empty() ? NULL : &labels[0]);
+  header.size[Labels] = labels.size() * sizeof(uint64_t);
+  data[SymbolNodes] = reinterpret_cast<const char*>(
+                        symbolNodes.empty() ? NULL : &symbolNodes[0]);
+  header.size[SymbolNodes] = symbolNodes.size() * sizeof(Node);
+  data[SymbolEdges] = reinterpret_cast<const char*>(
+                        symbolEdges.empty() ? NULL : &symbolEdges[0]);
+  header.size[SymbolEdges] = symbolEdges.size() * sizeof(Edge);
+  data[SymbolRuleIndex] = reinterpret_cast<const char*>(
+                            symbolRuleIndex.empty() ? NULL : &symbolRuleIndex[0]);
+  header.size[SymbolRuleIndex] = symbolRuleIndex.size() * sizeof(uint64_t);
+
+  uint64_t offset = sizeof(Header);
+  for (std::size_t i = 0; i < NumSections; ++i) {
+    offset = (offset + 7) / 8 * 8;
+    header.offset[i] = offset;
+    offset += header.size[i];
+  }
+
+  util::scoped_fd file(util::CreateOrThrow(path.c_str()));
+  util::WriteOrThrow(file.get(), &header, sizeof(header));
+  uint64_t written = sizeof(Header);
+  const char padding[8] = { 0 };
+  for (std::size_t i = 0; i < NumSections; ++i) {
+    util::WriteOrThrow(file.get(), padding, header.offset[i] - written);
+    if (header.size[i]) {
+      util::WriteOrThrow(file.get(), data[i], header.size[i]);
+    }
+    written = header.offset[i] + header.size[i];
+  }
+}
+
+}  // namespace Syntax
+}  // namespace Moses
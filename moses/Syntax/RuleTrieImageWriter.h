@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/unordered_map.hpp>
+
+#include "util/string_piece.hh"
+
+#include "RuleTrieImage.h"
+
+namespace Moses
+{
+namespace Syntax
+{
+
+// Builds a RuleTrieImage from the lines of a text rule table in the format
+// given by sourceFormat.
+//
+// Scores are transformed here, but rules are neither sorted nor pruned, as
+// both depend on the weights.  Rules with an empty source side are kept, the
+// decoder decides whether to use them.  A rule whose source non-terminals
+// are not all aligned to target non-terminals can't be put in the symbol
+// trie, as RuleTrieCYKPlus couldn't hold it either, and is only in the
+// terminal index.  Everything is held in memory until Write() is called.
+class RuleTrieImageWriter
+{
+public:
+  RuleTrieImageWriter(std::size_t numScores,
+                      RuleTrieImageFormat::SourceFormat sourceFormat);
+
+  void AddRule(const StringPiece &line);
+
+  void Write(const std::string &path) const;
+
+  std::size_t GetNumRules() const {
+    return m_ruleOffsets.size();
+  }
+
+private:
+  typedef boost::unordered_map<std::string, uint32_t> VocabIds;
+
+  struct KeyOrder;
+
+  void ExtractTerminals(const StringPiece &source);
+  bool ExtractSymbols(const StringPiece &source, const StringPiece &target,
+                      const StringPiece &alignment);
+  uint32_t GetVocabId(const StringPiece &);
+  uint32_t GetLabelId(const StringPiece &);
+
+  void BuildTrie(const std::vector<uint32_t> &keys,
+                 const std::vector<uint64_t> &keyOffsets,
+                 const std::vector<std::size_t> &rules,
+                 std::vector<RuleTrieImageFormat::Node> &nodes,
+                 std::vector<RuleTrieImageFormat::Edge> &edges,
+                 std::vector<uint64_t> &ruleIndex) const;
+
+  std::size_t m_numScores;
+  RuleTrieImageFormat::SourceFormat m_sourceFormat;
+
+  // terminals and labels, numbered in order of appearance until Write()
+  // sorts them
+  VocabIds m_vocabIds;
+  std::vector<std::string> m_vocab;
+  VocabIds m_labelIds;
+  std::vector<std::string> m_labels;
+
+  // rule records and the terminal ids of each rule, both in table order
+  std::string m_rules;
+  std::vector<uint64_t> m_ruleOffsets;
+  std::vector<uint32_t> m_terminals;
+  std::vector<uint64_t> m_terminalOffsets;
+
+  // symbol trie keys, with kLabelBit set on label ids, of the rules in
+  // m_symbolRules
+  std::vector<std::size_t> m_symbolRules;
+  std::vector<uint32_t> m_symbols;
+  std::vector<uint64_t> m_symbolOffsets;
+
+  // reused buffer
+  std::vector<float> m_scores;
+};
+
+}  // namespace Syntax
+}  // namespace Moses
@@ -72,22 +72,48 @@ void Manager<Parser>::InitializeParsers(PChart &pchart,
   UTIL_THROW_IF2(ffs.size() != graphs.size(),
                  "number of RuleTables does not match number of decode graphs");
 
+  // The parsers of the main rule tables share one pool of matching threads.
+  // The input and OOV tables are small, so their parsers match on their own.
+  ThreadPool *matchingPool = NULL;
+#ifdef WITH_THREADS
+  const std::size_t matchingThreads = options()->syntax.s2t_matching_threads;
+  if (Parser::UsesMatchingThreads() && matchingThreads > 1) {
+    m_matchingPool.reset(new ThreadPool(matchingThreads));
+    matchingPool = m_matchingPool.get();
+  }
+#endif
+
   for (std::size_t i = 0; i < ffs.size(); ++i) {
     RuleTableFF *ff = ffs[i];
     std::size_t maxChartSpan = graphs[i]->GetMaxChartSpan();
     // This may change in the future, but currently we assume that every
     // RuleTableFF is associated with a static, file-based rule table of
     // some sort and that the table should have been loaded into a RuleTable
-    // by this point.
+    // by this point.  The exception is a rule trie image that the parser
+    // matches in place, which only has an input table (below).
     const RuleTable *table = ff->GetTable();
-    assert(table);
-    RuleTable *nonConstTable = const_cast<RuleTable*>(table);
-    boost::shared_ptr<Parser> parser;
-    typename Parser::RuleTrie *trie =
-      dynamic_cast<typename Parser::RuleTrie*>(nonConstTable);
-    assert(trie);
-    parser.reset(new Parser(pchart, *trie, maxChartSpan));
-    m_parsers.push_back(parser);
+    if (table) {
+      RuleTable *nonConstTable = const_cast<RuleTable*>(table);
+      typename Parser::RuleTrie *trie =
+        dynamic_cast<typename Parser::RuleTrie*>(nonConstTable);
+      assert(trie);
+      boost::shared_ptr<ParserBase> parser(
+        new Parser(pchart, *trie, maxChartSpan, matchingPool));
+      m_parsers.push_back(parser);
+    }
+
+    // The rules of an image that can apply to this input.
+    RuleTable *inputTable = ff->CreateInputTable(m_source);
+    if (inputTable) {
+      typedef typename Parser::InputParser InputParser;
+      typename InputParser::RuleTrie *trie =
+        dynamic_cast<typename InputParser::RuleTrie*>(inputTable);
+      assert(trie);
+      m_inputRuleTries.push_back(boost::shared_ptr<RuleTrie>(trie));
+      boost::shared_ptr<ParserBase> parser(
+        new InputParser(pchart, *trie, maxChartSpan));
+      m_parsers.push_back(parser);
+    }
   }
 
   // Check for OOVs and synthesize an additional rule trie + parser if
@@ -100,7 +126,7 @@ void Manager<Parser>::InitializeParsers(PChart &pchart,
     OovHandler<typename Parser::RuleTrie> oovHandler(*ffs[0]);
     m_oovRuleTrie = oovHandler.SynthesizeRuleTrie(m_oovs.begin(), m_oovs.end());
     // Create a parser for the OOV rule trie.
-    boost::shared_ptr<Parser> parser(
+    boost::shared_ptr<ParserBase> parser(
       new Parser(pchart, *m_oovRuleTrie, maxOovWidth));
     m_parsers.push_back(parser);
   }
@@ -123,6 +149,9 @@ void Manager<Parser>::FindOovs(const PChart &pchart, boost::unordered_set<Word>
       tries.push_back(trie);
     }
   }
+  for (std::size_t i = 0; i < m_inputRuleTries.size(); ++i) {
+    tries.push_back(m_inputRuleTries[i].get());
+  }
 
   // For every sink vertex in pchart (except for <s> and </s>), check whether
   // the word has a preterminal rule in any of the rule tables.  If not then
@@ -189,7 +218,7 @@ void Manager<Parser>::Decode()
       // each one to a SHyperedgeBundle (via the callback).  The callback
       // prunes the SHyperedgeBundles and keeps the best ones (up to ruleLimit).
       callback.InitForRange(range);
-      for (typename std::vector<boost::shared_ptr<Parser> >::iterator
+      for (typename std::vector<boost::shared_ptr<ParserBase> >::iterator
            p = m_parsers.begin(); p != m_parsers.end(); ++p) {
         (*p)->EnumerateHyperedges(range, callback);
       }
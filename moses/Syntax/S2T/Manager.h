@@ -5,15 +5,22 @@
 
 #include <boost/shared_ptr.hpp>
 
+#ifdef WITH_THREADS
+#include <boost/scoped_ptr.hpp>
+#endif
+
 #include "moses/InputType.h"
 #include "moses/Syntax/KBestExtractor.h"
 #include "moses/Syntax/Manager.h"
 #include "moses/Syntax/SVertexStack.h"
+#include "moses/ThreadPool.h"
 #include "moses/Word.h"
 
 #include "OovHandler.h"
 #include "ParserCallback.h"
+#include "Parsers/Parser.h"
 #include "PChart.h"
+#include "RuleTrie.h"
 #include "SChart.h"
 
 namespace Moses
@@ -45,6 +52,10 @@ public:
   void OutputDetailedTranslationReport(OutputCollector *collector) const;
 
 private:
+  // The parsers of the input tables may be of another type (see
+  // RuleTableFF::CreateInputTable).
+  typedef S2T::Parser<typename Parser::CallbackType> ParserBase;
+
   void FindOovs(const PChart &, boost::unordered_set<Word> &, std::size_t);
 
   void InitializeCharts();
@@ -58,7 +69,11 @@ private:
   PChart m_pchart;
   SChart m_schart;
   boost::shared_ptr<typename Parser::RuleTrie> m_oovRuleTrie;
-  std::vector<boost::shared_ptr<Parser> > m_parsers;
+  std::vector<boost::shared_ptr<RuleTrie> > m_inputRuleTries;
+#ifdef WITH_THREADS
+  boost::scoped_ptr<ThreadPool> m_matchingPool;
+#endif
+  std::vector<boost::shared_ptr<ParserBase> > m_parsers;
 };
 
 }  // S2T
@@ -1,5 +1,7 @@
 #include "PChart.h"
 
+#include <new>
+
 #include "moses/FactorCollection.h"
 
 namespace Moses
@@ -10,10 +12,13 @@ namespace S2T
 {
 
 PChart::PChart(std::size_t width, bool maintainCompressedChart)
+  : m_width(width)
+  , m_compressedChart(0)
 {
-  m_cells.resize(width);
-  for (std::size_t i = 0; i < width; ++i) {
-    m_cells[i].resize(width);
+  const std::size_t numCells = width * (width + 1) / 2;
+  m_cells = static_cast<Cell *>(m_arena.Allocate(numCells * sizeof(Cell)));
+  for (std::size_t i = 0; i < numCells; ++i) {
+    new (&m_cells[i]) Cell(m_arena);
   }
   if (maintainCompressedChart) {
     m_compressedChart = new CompressedChart(width);
@@ -26,6 +31,10 @@ PChart::PChart(std::size_t width, bool maintainCompressedChart)
 
 PChart::~PChart()
 {
+  const std::size_t numCells = m_width * (m_width + 1) / 2;
+  for (std::size_t i = 0; i < numCells; ++i) {
+    m_cells[i].~Cell();
+  }
   delete m_compressedChart;
 }
 
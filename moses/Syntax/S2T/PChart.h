@@ -4,6 +4,7 @@
 
 #include <boost/unordered_map.hpp>
 
+#include "moses/Syntax/ChartArena.h"
 #include "moses/Syntax/NonTerminalMap.h"
 #include "moses/Syntax/PVertex.h"
 #include "moses/Syntax/SymbolEqualityPred.h"
@@ -24,6 +25,8 @@ public:
     typedef boost::unordered_map<Word, PVertex, SymbolHasher,
             SymbolEqualityPred> TMap;
     typedef NonTerminalMap<PVertex> NMap;
+
+    Cell(ChartArena &arena) : nonTerminalVertices(arena) {}
     // Collection of terminal vertices (keyed by terminal symbol).
     TMap terminalVertices;
     // Collection of non-terminal vertices (keyed by non-terminal symbol).
@@ -42,18 +45,18 @@ public:
   ~PChart();
 
   std::size_t GetWidth() const {
-    return m_cells.size();
+    return m_width;
   }
 
   const Cell &GetCell(std::size_t start, std::size_t end) const {
-    return m_cells[start][end];
+    return m_cells[CellIndex(start, end)];
   }
 
   // Insert the given PVertex and return a reference to the inserted object.
   PVertex &AddVertex(const PVertex &v) {
     const std::size_t start = v.span.GetStartPos();
     const std::size_t end = v.span.GetEndPos();
-    Cell &cell = m_cells[start][end];
+    Cell &cell = m_cells[CellIndex(start, end)];
     // If v is a terminal vertex add it to the cell's terminalVertices map.
     if (!v.symbol.IsNonTerminal()) {
       Cell::TMap::value_type x(v.symbol, v);
@@ -81,7 +84,17 @@ public:
 private:
   typedef std::vector<CompressedMatrix> CompressedChart;
 
-  std::vector<std::vector<Cell> > m_cells;
+  PChart(const PChart &);  // Not implemented
+  PChart &operator=(const PChart &);  // Not implemented
+
+  // Cells are stored row by row for start <= end only.
+  std::size_t CellIndex(std::size_t start, std::size_t end) const {
+    return start * (2 * m_width - start + 1) / 2 + (end - start);
+  }
+
+  ChartArena m_arena;  // must outlive m_cells
+  std::size_t m_width;
+  Cell *m_cells;
   CompressedChart *m_compressedChart;
 };
 
@@ -9,11 +9,12 @@ namespace Syntax
 namespace S2T
 {
 
-template<typename Callback>
-RecursiveCYKPlusParser<Callback>::RecursiveCYKPlusParser(
+template<typename Callback, typename Trie>
+RecursiveCYKPlusParser<Callback, Trie>::RecursiveCYKPlusParser(
   PChart &chart,
   const RuleTrie &trie,
-  std::size_t maxChartSpan)
+  std::size_t maxChartSpan,
+  ThreadPool *)
   : Parser<Callback>(chart)
   , m_ruleTable(trie)
   , m_maxChartSpan(maxChartSpan)
@@ -22,15 +23,15 @@ RecursiveCYKPlusParser<Callback>::RecursiveCYKPlusParser(
   m_hyperedge.head = 0;
 }
 
-template<typename Callback>
-void RecursiveCYKPlusParser<Callback>::EnumerateHyperedges(
+template<typename Callback, typename Trie>
+void RecursiveCYKPlusParser<Callback, Trie>::EnumerateHyperedges(
   const Range &range,
   Callback &callback)
 {
   const std::size_t start = range.GetStartPos();
   const std::size_t end = range.GetEndPos();
   m_callback = &callback;
-  const RuleTrie::Node &rootNode = m_ruleTable.GetRootNode();
+  const Node &rootNode = m_ruleTable.GetRootNode();
   m_maxEnd = std::min(Base::m_chart.GetWidth()-1, start+m_maxChartSpan-1);
   m_hyperedge.tail.clear();
 
@@ -47,31 +48,30 @@ void RecursiveCYKPlusParser<Callback>::EnumerateHyperedges(
 
 // Search for all extensions of a partial rule (pointed at by node) that begin
 // with a non-terminal over a span between [start,minEnd] and [start,maxEnd].
-template<typename Callback>
-void RecursiveCYKPlusParser<Callback>::GetNonTerminalExtensions(
-  const RuleTrie::Node &node,
+template<typename Callback, typename Trie>
+void RecursiveCYKPlusParser<Callback, Trie>::GetNonTerminalExtensions(
+  const Node &node,
   std::size_t start,
   std::size_t minEnd,
   std::size_t maxEnd)
 {
-  // Non-terminal labels in node's outgoing edge set.
-  const RuleTrie::Node::SymbolMap &nonTermMap = node.GetNonTerminalMap();
-
   // Compressed matrix from PChart.
   const PChart::CompressedMatrix &matrix =
     Base::m_chart.GetCompressedMatrix(start);
 
-  // Loop over possible expansions of the rule.
-  RuleTrie::Node::SymbolMap::const_iterator p;
-  RuleTrie::Node::SymbolMap::const_iterator p_end = nonTermMap.end();
-  for (p = nonTermMap.begin(); p != p_end; ++p) {
-    const Word &nonTerm = p->first;
+  // Loop over possible expansions of the rule (the non-terminal labels in
+  // node's outgoing edge set).
+  typename RuleTrie::NonTerminalIterator p;
+  typename RuleTrie::NonTerminalIterator p_end =
+    m_ruleTable.EndNonTerminals(node);
+  for (p = m_ruleTable.BeginNonTerminals(node); p != p_end; ++p) {
+    const Word &nonTerm = m_ruleTable.GetNonTerminal(p);
     const std::vector<PChart::CompressedItem> &items =
       matrix[nonTerm[0]->GetId()];
     for (std::vector<PChart::CompressedItem>::const_iterator q = items.begin();
          q != items.end(); ++q) {
       if (q->end >= minEnd && q->end <= maxEnd) {
-        const RuleTrie::Node &child = p->second;
+        const Node &child = m_ruleTable.GetNonTerminalChild(p);
         AddAndExtend(child, q->end, *(q->vertex));
       }
     }
@@ -80,9 +80,9 @@ void RecursiveCYKPlusParser<Callback>::GetNonTerminalExtensions(
 
 // Search for all extensions of a partial rule (pointed at by node) that begin
 // with a terminal over span [start,end].
-template<typename Callback>
-void RecursiveCYKPlusParser<Callback>::GetTerminalExtension(
-  const RuleTrie::Node &node,
+template<typename Callback, typename Trie>
+void RecursiveCYKPlusParser<Callback, Trie>::GetTerminalExtension(
+  const Node &node,
   std::size_t start,
   std::size_t end)
 {
@@ -93,60 +93,50 @@ void RecursiveCYKPlusParser<Callback>::GetTerminalExtension(
     return;
   }
 
-  const RuleTrie::Node::SymbolMap &terminals = node.GetTerminalMap();
-
   for (PChart::Cell::TMap::const_iterator p = vertexMap.begin();
        p != vertexMap.end(); ++p) {
     const Word &terminal = p->first;
     const PVertex &vertex = p->second;
 
-    // if node has small number of terminal edges, test word equality for each.
-    if (terminals.size() < 5) {
-      for (RuleTrie::Node::SymbolMap::const_iterator iter = terminals.begin();
-           iter != terminals.end(); ++iter) {
-        const Word &word = iter->first;
-        if (word == terminal) {
-          const RuleTrie::Node *child = & iter->second;
-          AddAndExtend(*child, end, vertex);
-          break;
-        }
-      }
-    } else { // else, do hash lookup
-      const RuleTrie::Node *child = node.GetChild(terminal);
-      if (child != NULL) {
-        AddAndExtend(*child, end, vertex);
-      }
+    const Node *child = m_ruleTable.GetChild(node, terminal);
+    if (child != NULL) {
+      AddAndExtend(*child, end, vertex);
     }
   }
 }
 
 // If a (partial) rule matches, pass it to the callback (if non-unary and
 // non-empty), and try to find expansions that have this partial rule as prefix.
-template<typename Callback>
-void RecursiveCYKPlusParser<Callback>::AddAndExtend(
-  const RuleTrie::Node &node,
+template<typename Callback, typename Trie>
+void RecursiveCYKPlusParser<Callback, Trie>::AddAndExtend(
+  const Node &node,
   std::size_t end,
   const PVertex &vertex)
 {
   // FIXME Sort out const-ness.
   m_hyperedge.tail.push_back(const_cast<PVertex *>(&vertex));
 
-  // Add target phrase collection (except if rule is empty or unary).
-  TargetPhraseCollection::shared_ptr tpc = node.GetTargetPhraseCollection();
-  if (!tpc->IsEmpty() && !IsNonLexicalUnary(m_hyperedge)) {
-    m_hyperedge.label.translations = tpc;
-    (*m_callback)(m_hyperedge, end);
+  // Add target phrase collection (except if rule is empty or unary).  Check
+  // for unary rules first: a RuleTrieCYKPlusImage builds the collection on
+  // demand.
+  if (!IsNonLexicalUnary(m_hyperedge)) {
+    TargetPhraseCollection::shared_ptr tpc =
+      m_ruleTable.GetTargetPhraseCollection(node);
+    if (!tpc->IsEmpty()) {
+      m_hyperedge.label.translations = tpc;
+      (*m_callback)(m_hyperedge, end);
+    }
   }
 
   // Get all further extensions of rule (until reaching end of sentence or
   // max-chart-span).
   if (end < m_maxEnd) {
-    if (!node.GetTerminalMap().empty()) {
+    if (m_ruleTable.HasTerminalChildren(node)) {
       for (std::size_t newEndPos = end+1; newEndPos <= m_maxEnd; newEndPos++) {
         GetTerminalExtension(node, end+1, newEndPos);
       }
     }
-    if (!node.GetNonTerminalMap().empty()) {
+    if (m_ruleTable.HasNonTerminalChildren(node)) {
       GetNonTerminalExtensions(node, end+1, end+1, m_maxEnd);
     }
   }
@@ -154,8 +144,8 @@ void RecursiveCYKPlusParser<Callback>::AddAndExtend(
   m_hyperedge.tail.pop_back();
 }
 
-template<typename Callback>
-bool RecursiveCYKPlusParser<Callback>::IsNonLexicalUnary(
+template<typename Callback, typename Trie>
+bool RecursiveCYKPlusParser<Callback, Trie>::IsNonLexicalUnary(
   const PHyperedge &hyperedge) const
 {
   return hyperedge.tail.size() == 1 &&
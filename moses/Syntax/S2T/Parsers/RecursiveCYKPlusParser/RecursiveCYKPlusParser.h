@@ -4,10 +4,14 @@
 #include "moses/Syntax/PVertex.h"
 #include "moses/Syntax/S2T/Parsers/Parser.h"
 #include "moses/Syntax/S2T/RuleTrieCYKPlus.h"
+#include "moses/Syntax/S2T/RuleTrieCYKPlusImage.h"
 #include "moses/Range.h"
 
 namespace Moses
 {
+
+class ThreadPool;
+
 namespace Syntax
 {
 namespace S2T
@@ -19,19 +23,28 @@ namespace S2T
 //  "A CYK+ Variant for SCFG Decoding Without a Dot Chart"
 //  In proceedings of SSST-8 2014
 //
-template<typename Callback>
+// Trie is RuleTrieCYKPlus or RuleTrieCYKPlusImage, which the parser walks
+// through the same set of member functions.
+template<typename Callback, typename Trie = RuleTrieCYKPlus>
 class RecursiveCYKPlusParser : public Parser<Callback>
 {
 public:
   typedef Parser<Callback> Base;
-  typedef RuleTrieCYKPlus RuleTrie;
+  typedef Trie RuleTrie;
+  // Parser for the rules of a rule trie image that apply to an input.
+  typedef RecursiveCYKPlusParser<Callback, RuleTrieCYKPlusImage> InputParser;
 
   // TODO Make this configurable?
   static bool RequiresCompressedChart() {
     return true;
   }
 
-  RecursiveCYKPlusParser(PChart &, const RuleTrie &, std::size_t);
+  static bool UsesMatchingThreads() {
+    return false;
+  }
+
+  RecursiveCYKPlusParser(PChart &, const RuleTrie &, std::size_t,
+                         ThreadPool * = NULL);
 
   ~RecursiveCYKPlusParser() {}
 
@@ -39,12 +52,14 @@ public:
 
 private:
 
-  void GetTerminalExtension(const RuleTrie::Node &, std::size_t, std::size_t);
+  typedef typename RuleTrie::Node Node;
+
+  void GetTerminalExtension(const Node &, std::size_t, std::size_t);
 
-  void GetNonTerminalExtensions(const RuleTrie::Node &, std::size_t,
-                                std::size_t, std::size_t);
+  void GetNonTerminalExtensions(const Node &, std::size_t, std::size_t,
+                                std::size_t);
 
-  void AddAndExtend(const RuleTrie::Node &, std::size_t, const PVertex &);
+  void AddAndExtend(const Node &, std::size_t, const PVertex &);
 
   bool IsNonLexicalUnary(const PHyperedge &) const;
 
@@ -7,7 +7,6 @@
 #include "moses/ChartTranslationOptionList.h"
 #include "moses/InputType.h"
 #include "moses/NonTerminal.h"
-#include "moses/StaticData.h"
 #include "moses/Syntax/S2T/Parsers/Parser.h"
 #include "moses/Syntax/S2T/PChart.h"
 
@@ -22,13 +21,28 @@ namespace S2T
 
 template<typename Callback>
 Scope3Parser<Callback>::Scope3Parser(PChart &chart, const RuleTrie &trie,
-                                     std::size_t maxChartSpan)
+                                     std::size_t maxChartSpan,
+                                     ThreadPool *threadPool)
   : Parser<Callback>(chart)
   , m_ruleTable(trie)
   , m_maxChartSpan(maxChartSpan)
-  , m_latticeBuilder(chart)
+  , m_matcher(chart)
 {
   Init();
+
+#ifdef WITH_THREADS
+  m_pendingChunks = 0;
+  m_threadPool = threadPool;
+  if (m_threadPool) {
+    // A few chunks per thread, since the cost of matching varies a lot
+    // between PAT nodes.
+    const std::size_t numChunks = m_threadPool->GetNumThreads() * 4;
+    for (std::size_t i = 0; i < numChunks; ++i) {
+      m_chunkMatchers.push_back(boost::shared_ptr<Matcher>(new Matcher(chart)));
+    }
+    m_chunkBuffers.resize(numChunks);
+  }
+#endif
 }
 
 template<typename Callback>
@@ -44,23 +58,44 @@ EnumerateHyperedges(const Range &range, Callback &callback)
   const std::size_t start = range.GetStartPos();
   const std::size_t end = range.GetEndPos();
 
-  const std::vector<const PatternApplicationTrie *> &patNodes =
-    m_patSpans[start][end-start+1];
+  const PatNodeVec &patNodes = m_patSpans[start][end-start+1];
+
+#ifdef WITH_THREADS
+  if (m_threadPool && patNodes.size() >= kMinParallelPatNodes) {
+    EnumerateHyperedgesInParallel(patNodes, start, end, callback);
+    return;
+  }
+#endif
+
+  Match(patNodes.begin(), patNodes.end(), start, end, m_matcher, callback);
+}
 
-  for (std::vector<const PatternApplicationTrie *>::const_iterator
-       p = patNodes.begin(); p != patNodes.end(); ++p) {
+// Search for the PHyperedges of the span [start,end] that can be generated
+// from the PAT nodes in [begin,end) and pass them to callback.
+template<typename Callback>
+template<typename MatchCallback>
+void Scope3Parser<Callback>::Match(PatNodeVec::const_iterator begin,
+                                   PatNodeVec::const_iterator end,
+                                   std::size_t start, std::size_t spanEnd,
+                                   Matcher &matcher, MatchCallback &callback)
+{
+  PatternApplicationKey &patKey = matcher.patKey;
+  std::vector<std::vector<bool> > &quickCheckTable = matcher.quickCheckTable;
+
+  for (PatNodeVec::const_iterator p = begin; p != end; ++p) {
     const PatternApplicationTrie *patNode = *p;
 
     // Read off the sequence of PAT nodes ending at patNode.
-    patNode->ReadOffPatternApplicationKey(m_patKey);
+    patNode->ReadOffPatternApplicationKey(patKey);
 
     // Calculate the start and end ranges for each symbol in the PAT key.
-    m_symbolRangeCalculator.Calc(m_patKey, start, end, m_symbolRanges);
+    matcher.symbolRangeCalculator.Calc(patKey, start, spanEnd,
+                                       matcher.symbolRanges);
 
     // Build a lattice that encodes the set of PHyperedge tails that can be
     // generated from this pattern + span.
-    m_latticeBuilder.Build(m_patKey, m_symbolRanges, m_lattice,
-                           m_quickCheckTable);
+    matcher.latticeBuilder.Build(patKey, matcher.symbolRanges, matcher.lattice,
+                                 quickCheckTable);
 
     // Ask the grammar for the mapping from label sequences to target phrase
     // collections for this pattern.
@@ -68,21 +103,22 @@ EnumerateHyperedges(const Range &range, Callback &callback)
 
     // For each label sequence, search the lattice for the set of PHyperedge
     // tails.
-    TailLatticeSearcher<Callback> searcher(m_lattice, m_patKey, m_symbolRanges);
+    TailLatticeSearcher<MatchCallback> searcher(matcher.lattice, patKey,
+        matcher.symbolRanges);
     RuleTrie::Node::LabelMap::const_iterator q = labelMap.begin();
     for (; q != labelMap.end(); ++q) {
       const std::vector<int> &labelSeq = q->first;
       TargetPhraseCollection::shared_ptr tpc = q->second;
       // For many label sequences there won't be any corresponding paths through
-      // the lattice.  As an optimisation, we use m_quickCheckTable to test
+      // the lattice.  As an optimisation, we use quickCheckTable to test
       // for this and we don't begin a search if there are no paths to find.
       bool failCheck = false;
       std::size_t nonTermIndex = 0;
-      for (std::size_t i = 0; i < m_patKey.size(); ++i) {
-        if (m_patKey[i]->IsTerminalNode()) {
+      for (std::size_t i = 0; i < patKey.size(); ++i) {
+        if (patKey[i]->IsTerminalNode()) {
           continue;
         }
-        if (!m_quickCheckTable[nonTermIndex][labelSeq[nonTermIndex]]) {
+        if (!quickCheckTable[nonTermIndex][labelSeq[nonTermIndex]]) {
           failCheck = true;
           break;
         }
@@ -96,6 +132,86 @@ EnumerateHyperedges(const Range &range, Callback &callback)
   }
 }
 
+#ifdef WITH_THREADS
+
+// Matches one chunk of a span's PAT nodes into the chunk's buffer.
+template<typename Callback>
+class Scope3Parser<Callback>::MatchTask : public Task
+{
+public:
+  MatchTask(Scope3Parser &parser, std::size_t chunk,
+            PatNodeVec::const_iterator begin, PatNodeVec::const_iterator end,
+            std::size_t start, std::size_t spanEnd)
+    : m_parser(parser)
+    , m_chunk(chunk)
+    , m_begin(begin)
+    , m_end(end)
+    , m_start(start)
+    , m_spanEnd(spanEnd) {}
+
+  void Run() {
+    m_parser.Match(m_begin, m_end, m_start, m_spanEnd,
+                   *m_parser.m_chunkMatchers[m_chunk],
+                   m_parser.m_chunkBuffers[m_chunk]);
+    boost::mutex::scoped_lock lock(m_parser.m_mutex);
+    if (--m_parser.m_pendingChunks == 0) {
+      m_parser.m_chunksDone.notify_one();
+    }
+  }
+
+private:
+  Scope3Parser &m_parser;
+  std::size_t m_chunk;
+  PatNodeVec::const_iterator m_begin;
+  PatNodeVec::const_iterator m_end;
+  std::size_t m_start;
+  std::size_t m_spanEnd;
+};
+
+// The PAT nodes of the span [start,end] are matched independently of each
+// other, so the list is cut into numChunks contiguous chunks of about equal
+// length, without regard to the PAT's structure (a chunk may begin or end
+// in the middle of a subtree).  Each chunk is matched into its own buffer by
+// the thread pool and the buffers are then passed to the callback in order,
+// so the callback sees the same PHyperedges in the same order as with a
+// single thread.
+template<typename Callback>
+void Scope3Parser<Callback>::EnumerateHyperedgesInParallel(
+  const PatNodeVec &patNodes, std::size_t start, std::size_t end,
+  Callback &callback)
+{
+  const std::size_t numChunks = m_chunkMatchers.size();
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_pendingChunks = numChunks;
+  }
+  for (std::size_t i = 0; i < numChunks; ++i) {
+    PatNodeVec::const_iterator chunkBegin =
+      patNodes.begin() + patNodes.size() * i / numChunks;
+    PatNodeVec::const_iterator chunkEnd =
+      patNodes.begin() + patNodes.size() * (i+1) / numChunks;
+    m_chunkBuffers[i].hyperedges.clear();
+    m_threadPool->Submit(boost::shared_ptr<Task>(
+                           new MatchTask(*this, i, chunkBegin, chunkEnd, start, end)));
+  }
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_pendingChunks > 0) {
+      m_chunksDone.wait(lock);
+    }
+  }
+
+  for (std::size_t i = 0; i < numChunks; ++i) {
+    const std::vector<PHyperedge> &hyperedges = m_chunkBuffers[i].hyperedges;
+    for (std::vector<PHyperedge>::const_iterator p = hyperedges.begin();
+         p != hyperedges.end(); ++p) {
+      callback(*p);
+    }
+  }
+}
+
+#endif
+
 template<typename Callback>
 void Scope3Parser<Callback>::Init()
 {
@@ -3,9 +3,18 @@
 #include <memory>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#endif
+
+#include "moses/Syntax/PHyperedge.h"
 #include "moses/Syntax/S2T/Parsers/Parser.h"
 #include "moses/Syntax/S2T/RuleTrieScope3.h"
 #include "moses/Range.h"
+#include "moses/ThreadPool.h"
 
 #include "PatternApplicationTrie.h"
 #include "SymbolRangeCalculator.h"
@@ -14,6 +23,9 @@
 
 namespace Moses
 {
+
+class ThreadPool;
+
 namespace Syntax
 {
 namespace S2T
@@ -25,44 +37,90 @@ namespace S2T
 //  "GHKM Rule Extraction and Scope-3 Parsing in Moses"
 //  In proceedings of WMT 2012
 //
+// Given a thread pool, the PAT nodes of a span are matched by its threads
+// (see EnumerateHyperedgesInParallel).  The manager shares one pool between
+// the parsers of a sentence's main rule tables.
+//
 template<typename Callback>
 class Scope3Parser : public Parser<Callback>
 {
 public:
   typedef Parser<Callback> Base;
   typedef RuleTrieScope3 RuleTrie;
+  // A RuleTableFF::CreateInputTable() table is a RuleTrieScope3 as well.
+  typedef Scope3Parser InputParser;
 
   // TODO Make this configurable?
   static bool RequiresCompressedChart() {
     return false;
   }
 
-  Scope3Parser(PChart &, const RuleTrie &, std::size_t);
+  static bool UsesMatchingThreads() {
+    return true;
+  }
+
+  Scope3Parser(PChart &, const RuleTrie &, std::size_t, ThreadPool * = NULL);
 
   ~Scope3Parser();
 
   void EnumerateHyperedges(const Range &, Callback &);
 
 private:
+  typedef std::vector<const PatternApplicationTrie *> PatNodeVec;
+
+  // Working storage for matching PAT nodes against a span.
+  struct Matcher {
+    Matcher(PChart &chart) : latticeBuilder(chart) {}
+    std::vector<std::vector<bool> > quickCheckTable;
+    TailLattice lattice;
+    TailLatticeBuilder latticeBuilder;
+    SymbolRangeCalculator symbolRangeCalculator;
+    std::vector<SymbolRange> symbolRanges;
+    PatternApplicationKey patKey;
+  };
+
+  // Callback that stores the PHyperedges found by a worker thread.
+  struct HyperedgeBuffer {
+    void operator()(const PHyperedge &hyperedge) {
+      hyperedges.push_back(hyperedge);
+    }
+    std::vector<PHyperedge> hyperedges;
+  };
+
   void Init();
   void InitRuleApplicationVector();
   void FillSentenceMap(SentenceMap &);
   void RecordPatternApplicationSpans(const PatternApplicationTrie &);
 
+  template<typename MatchCallback>
+  void Match(PatNodeVec::const_iterator, PatNodeVec::const_iterator,
+             std::size_t, std::size_t, Matcher &, MatchCallback &);
+
   PatternApplicationTrie *m_patRoot;
-  std::vector<std::vector<bool> > m_quickCheckTable;
   const RuleTrie &m_ruleTable;
   const std::size_t m_maxChartSpan;
-  TailLattice m_lattice;
-  TailLatticeBuilder m_latticeBuilder;
-  SymbolRangeCalculator m_symbolRangeCalculator;
-  std::vector<SymbolRange> m_symbolRanges;
-  PatternApplicationKey m_patKey;
+  Matcher m_matcher;
 
   /* m_patSpans[i][j] records the set of all PAT nodes for span [i,i+j]
      i.e. j is the width of the span */
-  std::vector<std::vector<
-  std::vector<const PatternApplicationTrie *> > > m_patSpans;
+  std::vector<std::vector<PatNodeVec> > m_patSpans;
+
+#ifdef WITH_THREADS
+  class MatchTask;
+
+  void EnumerateHyperedgesInParallel(const PatNodeVec &, std::size_t,
+                                     std::size_t, Callback &);
+
+  // Spans with fewer PAT nodes are matched on the calling thread.
+  static const std::size_t kMinParallelPatNodes = 16;
+
+  std::vector<boost::shared_ptr<Matcher> > m_chunkMatchers;
+  std::vector<HyperedgeBuffer> m_chunkBuffers;
+  boost::mutex m_mutex;
+  boost::condition_variable m_chunksDone;
+  std::size_t m_pendingChunks;
+  ThreadPool *m_threadPool;
+#endif
 };
 
 }  // namespace S2T
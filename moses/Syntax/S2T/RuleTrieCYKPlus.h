@@ -82,6 +82,55 @@ public:
     return m_root;
   }
 
+  // The interface through which RecursiveCYKPlusParser walks the trie (it
+  // walks a RuleTrieCYKPlusImage through the same one).
+  typedef Node::SymbolMap::const_iterator NonTerminalIterator;
+
+  const Node *GetChild(const Node &node, const Word &terminal) const {
+    const Node::SymbolMap &terminals = node.GetTerminalMap();
+    // if node has small number of terminal edges, test word equality for each.
+    if (terminals.size() < 5) {
+      for (Node::SymbolMap::const_iterator p = terminals.begin();
+           p != terminals.end(); ++p) {
+        if (p->first == terminal) {
+          return &p->second;
+        }
+      }
+      return NULL;
+    }
+    // else, do hash lookup
+    return node.GetChild(terminal);
+  }
+
+  bool HasTerminalChildren(const Node &node) const {
+    return !node.GetTerminalMap().empty();
+  }
+
+  bool HasNonTerminalChildren(const Node &node) const {
+    return !node.GetNonTerminalMap().empty();
+  }
+
+  NonTerminalIterator BeginNonTerminals(const Node &node) const {
+    return node.GetNonTerminalMap().begin();
+  }
+
+  NonTerminalIterator EndNonTerminals(const Node &node) const {
+    return node.GetNonTerminalMap().end();
+  }
+
+  const Word &GetNonTerminal(NonTerminalIterator p) const {
+    return p->first;
+  }
+
+  const Node &GetNonTerminalChild(NonTerminalIterator p) const {
+    return p->second;
+  }
+
+  TargetPhraseCollection::shared_ptr
+  GetTargetPhraseCollection(const Node &node) const {
+    return node.GetTargetPhraseCollection();
+  }
+
   bool HasPreterminalRule(const Word &) const;
 
 private:
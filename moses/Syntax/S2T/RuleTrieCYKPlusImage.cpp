@@ -0,0 +1,98 @@
+#include "RuleTrieCYKPlusImage.h"
+
+#include <string>
+
+#include "moses/InputType.h"
+#include "moses/Phrase.h"
+#include "moses/TargetPhrase.h"
+#include "moses/Syntax/RuleTableFF.h"
+#include "moses/parameters/AllOptions.h"
+#include "util/exception.hh"
+
+#include "RuleTrieLoader.h"
+
+namespace Moses
+{
+namespace Syntax
+{
+namespace S2T
+{
+
+RuleTrieCYKPlusImage::RuleTrieCYKPlusImage(const RuleTableFF *ff,
+    const RuleTrieImage &image,
+    const std::vector<Word> &labels,
+    const InputType &input)
+  : RuleTrie(ff)
+  , m_image(image)
+  , m_labels(labels)
+  , m_emptyCollection(new TargetPhraseCollection)
+{
+  for (std::size_t i = 0; i < input.GetSize(); ++i) {
+    const Word &word = input.GetWord(i);
+    if (m_terminals.find(word) != m_terminals.end()) {
+      continue;
+    }
+    uint32_t id = m_image.FindTerminal(word.GetString(ff->GetInput(), false));
+    if (id != RuleTrieImageFormat::kNone) {
+      m_terminals[word] = id;
+    }
+  }
+}
+
+TargetPhraseCollection::shared_ptr
+RuleTrieCYKPlusImage::GetTargetPhraseCollection(const Node &node) const
+{
+  if (node.numRules == 0) {
+    return m_emptyCollection;
+  }
+  TargetPhraseCollection::shared_ptr &tpc = m_collections[&node];
+  if (tpc) {
+    return tpc;
+  }
+
+  // Build the rules as RuleTrieLoader would, with the same sort and prune.
+  tpc.reset(new TargetPhraseCollection);
+  const bool wordDeletion = m_ff->options()->unk.word_deletion_enabled;
+  for (std::size_t i = 0; i < node.numRules; ++i) {
+    RuleTableEntry entry = m_image.GetSymbolRule(node, i);
+    bool isLHSEmpty =
+      (entry.source.find_first_not_of(" \t", 0) == std::string::npos);
+    if (isLHSEmpty && !wordDeletion) {
+      continue;
+    }
+    Phrase sourcePhrase;
+    Word *sourceLHS = NULL;
+    TargetPhrase *targetPhrase = RuleTrieLoader::CreateTargetPhrase(
+                                   entry, m_ff->GetInput(), m_ff->GetOutput(),
+                                   *m_ff, sourcePhrase, sourceLHS);
+    delete sourceLHS;
+    tpc->Add(targetPhrase);
+  }
+  if (m_ff->GetTableLimit()) {
+    tpc->Sort(true, m_ff->GetTableLimit());
+  }
+  return tpc;
+}
+
+bool RuleTrieCYKPlusImage::HasPreterminalRule(const Word &w) const
+{
+  const Node *child = GetChild(GetRootNode(), w);
+  return child != NULL && child->numRules != 0;
+}
+
+TargetPhraseCollection::shared_ptr
+RuleTrieCYKPlusImage::GetOrCreateTargetPhraseCollection(const Phrase &,
+    const TargetPhrase &,
+    const Word *)
+{
+  UTIL_THROW2("A RuleTrieCYKPlusImage is read-only");
+}
+
+void RuleTrieCYKPlusImage::SortAndPrune(std::size_t)
+{
+  UTIL_THROW2("A RuleTrieCYKPlusImage is read-only");
+}
+
+}  // namespace S2T
+}  // namespace Syntax
+}  // namespace Moses
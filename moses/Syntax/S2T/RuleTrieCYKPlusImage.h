@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include "moses/Syntax/RuleTrieImage.h"
+#include "moses/Syntax/SymbolEqualityPred.h"
+#include "moses/Syntax/SymbolHasher.h"
+#include "moses/TargetPhraseCollection.h"
+#include "moses/Word.h"
+
+#include "RuleTrie.h"
+
+namespace Moses
+{
+
+class InputType;
+
+namespace Syntax
+{
+
+class RuleTableFF;
+
+namespace S2T
+{
+
+// The rules of a RuleTrieImage that apply to one input, for the CYK+ parser.
+// The parser walks the image's symbol trie in place, through the same
+// member functions as it walks a RuleTrieCYKPlus.  Only the input's own
+// terminals are looked up in the image's vocabulary, once, and the
+// TargetPhraseCollection of a node is built the first time the parser asks
+// for it.  The collections are kept until the object is destroyed, which is
+// at the end of the input.  The object is used by a single thread.
+class RuleTrieCYKPlusImage : public RuleTrie
+{
+public:
+  typedef RuleTrieImage::Node Node;
+  typedef const RuleTrieImage::Edge *NonTerminalIterator;
+
+  // labels holds the Word for each of the image's label ids.
+  RuleTrieCYKPlusImage(const RuleTableFF *, const RuleTrieImage &,
+                       const std::vector<Word> &labels, const InputType &);
+
+  const Node &GetRootNode() const {
+    return m_image.GetSymbolRoot();
+  }
+
+  const Node *GetChild(const Node &node, const Word &terminal) const {
+    TerminalMap::const_iterator p = m_terminals.find(terminal);
+    return p == m_terminals.end() ? NULL
+           : m_image.GetSymbolChild(node, p->second);
+  }
+
+  bool HasTerminalChildren(const Node &node) const {
+    return node.numEdges != 0 && !(m_image.BeginSymbolEdges(node)->word &
+                                   RuleTrieImageFormat::kLabelBit);
+  }
+
+  bool HasNonTerminalChildren(const Node &node) const {
+    return node.numEdges != 0 && (m_image.EndLabelEdges(node)[-1].word &
+                                  RuleTrieImageFormat::kLabelBit);
+  }
+
+  NonTerminalIterator BeginNonTerminals(const Node &node) const {
+    return m_image.BeginLabelEdges(node);
+  }
+
+  NonTerminalIterator EndNonTerminals(const Node &node) const {
+    return m_image.EndLabelEdges(node);
+  }
+
+  const Word &GetNonTerminal(NonTerminalIterator p) const {
+    return m_labels[p->word & ~RuleTrieImageFormat::kLabelBit];
+  }
+
+  const Node &GetNonTerminalChild(NonTerminalIterator p) const {
+    return m_image.GetSymbolNode(*p);
+  }
+
+  TargetPhraseCollection::shared_ptr
+  GetTargetPhraseCollection(const Node &) const;
+
+  bool HasPreterminalRule(const Word &) const;
+
+private:
+  typedef boost::unordered_map<Word, uint32_t, SymbolHasher,
+          SymbolEqualityPred> TerminalMap;
+
+  typedef boost::unordered_map<const Node *,
+          TargetPhraseCollection::shared_ptr> CollectionMap;
+
+  TargetPhraseCollection::shared_ptr
+  GetOrCreateTargetPhraseCollection(const Phrase &, const TargetPhrase &,
+                                    const Word *);
+
+  void SortAndPrune(std::size_t);
+
+  const RuleTrieImage &m_image;
+  const std::vector<Word> &m_labels;
+  TerminalMap m_terminals;
+  mutable CollectionMap m_collections;
+  TargetPhraseCollection::shared_ptr m_emptyCollection;
+};
+
+}  // namespace S2T
+}  // namespace Syntax
+}  // namespace Moses
@@ -96,47 +96,54 @@ bool RuleTrieLoader::Load(Moses::AllOptions const& opts,
                   << numScoreComponents << ") of score components on line " << count);
     }
 
-    // parse source & find pt node
-
-    // constituent labels
-    Word *sourceLHS = NULL;
-    Word *targetLHS;
-
-    // create target phrase obj
-    TargetPhrase *targetPhrase = new TargetPhrase(&ff);
-    targetPhrase->CreateFromString(Output, output, targetPhraseString, &targetLHS);
-    // source
-    Phrase sourcePhrase;
-    sourcePhrase.CreateFromString(Input, input, sourcePhraseString, &sourceLHS);
-
-    // rest of target phrase
-    targetPhrase->SetAlignmentInfo(alignString);
-    targetPhrase->SetTargetLHS(targetLHS);
+    RuleTableEntry entry;
+    entry.source = sourcePhraseString;
+    entry.target = targetPhraseString;
+    entry.alignment = alignString;
+    entry.scores = scoreVector.empty() ? NULL : &scoreVector[0];
 
     ++pipes;  // skip over counts field.
 
     if (++pipes) {
-      StringPiece sparseString(*pipes);
-      targetPhrase->SetSparseScore(&ff, sparseString);
+      entry.sparse = *pipes;
     }
 
     if (++pipes) {
-      StringPiece propertiesString(*pipes);
-      targetPhrase->SetProperties(propertiesString);
+      entry.properties = *pipes;
     }
 
-    targetPhrase->GetScoreBreakdown().Assign(&ff, scoreVector);
-    targetPhrase->EvaluateInIsolation(sourcePhrase, ff.GetFeaturesToApply());
+    AddRule(entry, input, output, ff, trie);
 
-    TargetPhraseCollection::shared_ptr phraseColl
-    = GetOrCreateTargetPhraseCollection(trie, sourcePhrase,
-                                        *targetPhrase, sourceLHS);
-    phraseColl->Add(targetPhrase);
+    count++;
+  }
 
-    // not implemented correctly in memory pt. just delete it for now
-    delete sourceLHS;
+  // sort and prune each target phrase collection
+  if (ff.GetTableLimit()) {
+    SortAndPrune(trie, ff.GetTableLimit());
+  }
 
-    count++;
+  return true;
+}
+
+bool RuleTrieLoader::Load(Moses::AllOptions const& opts,
+                          const std::vector<FactorType> &input,
+                          const std::vector<FactorType> &output,
+                          const RuleTrieImage &image,
+                          const std::vector<const RuleTrieImage::Node *> &nodes,
+                          const RuleTableFF &ff,
+                          RuleTrie &trie)
+{
+  for (std::vector<const RuleTrieImage::Node *>::const_iterator p =
+         nodes.begin(); p != nodes.end(); ++p) {
+    const RuleTrieImage::Node &node = **p;
+    for (std::size_t i = 0; i < node.numRules; ++i) {
+      RuleTableEntry entry = image.GetRule(node, i);
+      bool isLHSEmpty = (entry.source.find_first_not_of(" \t", 0) == std::string::npos);
+      if (isLHSEmpty && !opts.unk.word_deletion_enabled) {
+        continue;
+      }
+      AddRule(entry, input, output, ff, trie);
+    }
   }
 
   // sort and prune each target phrase collection
@@ -147,6 +154,65 @@ bool RuleTrieLoader::Load(Moses::AllOptions const& opts,
   return true;
 }
 
+void RuleTrieLoader::AddRule(const RuleTableEntry &entry,
+                             const std::vector<FactorType> &input,
+                             const std::vector<FactorType> &output,
+                             const RuleTableFF &ff,
+                             RuleTrie &trie)
+{
+  // parse source & find pt node
+
+  // constituent labels
+  Word *sourceLHS = NULL;
+
+  // create target phrase obj
+  Phrase sourcePhrase;
+  TargetPhrase *targetPhrase = CreateTargetPhrase(entry, input, output, ff,
+                               sourcePhrase, sourceLHS);
+
+  TargetPhraseCollection::shared_ptr phraseColl
+  = GetOrCreateTargetPhraseCollection(trie, sourcePhrase,
+                                      *targetPhrase, sourceLHS);
+  phraseColl->Add(targetPhrase);
+
+  // not implemented correctly in memory pt. just delete it for now
+  delete sourceLHS;
+}
+
+TargetPhrase *RuleTrieLoader::CreateTargetPhrase(
+  const RuleTableEntry &entry,
+  const std::vector<FactorType> &input,
+  const std::vector<FactorType> &output,
+  const RuleTableFF &ff,
+  Phrase &sourcePhrase,
+  Word *&sourceLHS)
+{
+  Word *targetLHS;
+
+  TargetPhrase *targetPhrase = new TargetPhrase(&ff);
+  targetPhrase->CreateFromString(Output, output, entry.target, &targetLHS);
+  // source
+  sourcePhrase.CreateFromString(Input, input, entry.source, &sourceLHS);
+
+  // rest of target phrase
+  targetPhrase->SetAlignmentInfo(entry.alignment);
+  targetPhrase->SetTargetLHS(targetLHS);
+
+  if (!entry.sparse.empty()) {
+    targetPhrase->SetSparseScore(&ff, entry.sparse);
+  }
+
+  if (!entry.properties.empty()) {
+    targetPhrase->SetProperties(entry.properties);
+  }
+
+  std::vector<float> scoreVector(entry.scores,
+                                 entry.scores + ff.GetNumScoreComponents());
+  targetPhrase->GetScoreBreakdown().Assign(&ff, scoreVector);
+  targetPhrase->EvaluateInIsolation(sourcePhrase, ff.GetFeaturesToApply());
+  return targetPhrase;
+}
+
 }  // namespace S2T
 }  // namespace Syntax
 }  // namespace Moses
@@ -5,6 +5,7 @@
 
 #include "moses/TypeDef.h"
 #include "moses/Syntax/RuleTableFF.h"
+#include "moses/Syntax/RuleTrieImage.h"
 
 #include "RuleTrie.h"
 #include "RuleTrieCreator.h"
@@ -27,6 +28,31 @@ public:
             const std::string &inFile,
             const RuleTableFF &,
             RuleTrie &);
+
+  // Loads the rules at the given nodes of a compiled image.
+  bool Load(Moses::AllOptions const& opts,
+            const std::vector<FactorType> &input,
+            const std::vector<FactorType> &output,
+            const RuleTrieImage &,
+            const std::vector<const RuleTrieImage::Node *> &,
+            const RuleTableFF &,
+            RuleTrie &);
+
+  // Creates the TargetPhrase of a rule, setting sourcePhrase to its source
+  // side and sourceLHS to the source LHS (if any), which the caller owns.
+  static TargetPhrase *CreateTargetPhrase(const RuleTableEntry &,
+                                          const std::vector<FactorType> &input,
+                                          const std::vector<FactorType> &output,
+                                          const RuleTableFF &,
+                                          Phrase &sourcePhrase,
+                                          Word *&sourceLHS);
+
+private:
+  void AddRule(const RuleTableEntry &,
+               const std::vector<FactorType> &input,
+               const std::vector<FactorType> &output,
+               const RuleTableFF &,
+               RuleTrie &);
 };
 
 }  // namespace S2T
@@ -1,5 +1,7 @@
 #include "SChart.h"
 
+#include <new>
+
 namespace Moses
 {
 namespace Syntax
@@ -8,10 +10,20 @@ namespace S2T
 {
 
 SChart::SChart(std::size_t width)
+  : m_width(width)
+{
+  const std::size_t numCells = width * (width + 1) / 2;
+  m_cells = static_cast<Cell *>(m_arena.Allocate(numCells * sizeof(Cell)));
+  for (std::size_t i = 0; i < numCells; ++i) {
+    new (&m_cells[i]) Cell(m_arena);
+  }
+}
+
+SChart::~SChart()
 {
-  m_cells.resize(width);
-  for (std::size_t i = 0; i < width; ++i) {
-    m_cells[i].resize(width);
+  const std::size_t numCells = m_width * (m_width + 1) / 2;
+  for (std::size_t i = 0; i < numCells; ++i) {
+    m_cells[i].~Cell();
   }
 }
 
@@ -4,6 +4,7 @@
 
 #include <boost/unordered_map.hpp>
 
+#include "moses/Syntax/ChartArena.h"
 #include "moses/Syntax/NonTerminalMap.h"
 #include "moses/Syntax/SVertexStack.h"
 #include "moses/Syntax/SymbolEqualityPred.h"
@@ -24,26 +25,40 @@ public:
     typedef boost::unordered_map<Word, SVertexStack, SymbolHasher,
             SymbolEqualityPred> TMap;
     typedef NonTerminalMap<SVertexStack> NMap;
+
+    Cell(ChartArena &arena) : nonTerminalStacks(arena) {}
     TMap terminalStacks;
     NMap nonTerminalStacks;
   };
 
   SChart(std::size_t width);
 
+  ~SChart();
+
   std::size_t GetWidth() const {
-    return m_cells.size();
+    return m_width;
   }
 
   const Cell &GetCell(std::size_t start, std::size_t end) const {
-    return m_cells[start][end];
+    return m_cells[CellIndex(start, end)];
   }
 
   Cell &GetCell(std::size_t start, std::size_t end) {
-    return m_cells[start][end];
+    return m_cells[CellIndex(start, end)];
   }
 
 private:
-  std::vector<std::vector<Cell> > m_cells;
+  SChart(const SChart &);  // Not implemented
+  SChart &operator=(const SChart &);  // Not implemented
+
+  // Cells are stored row by row for start <= end only (see PChart).
+  std::size_t CellIndex(std::size_t start, std::size_t end) const {
+    return start * (2 * m_width - start + 1) / 2 + (end - start);
+  }
+
+  ChartArena m_arena;  // must outlive m_cells
+  std::size_t m_width;
+  Cell *m_cells;
 };
 
 }  // S2T
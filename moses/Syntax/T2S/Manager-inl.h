@@ -57,6 +57,17 @@ void Manager<RuleMatcher>::InitializeRuleMatchers()
     assert(trie);
     boost::shared_ptr<RuleMatcher> p(new RuleMatcher(m_inputTree, *trie));
     m_ruleMatchers.push_back(p);
+
+    // The rules of a compiled image that are specific to this input (see
+    // RuleTableFF::CreateInputTable).
+    RuleTable *inputTable = ff->CreateInputTable(m_source);
+    if (inputTable) {
+      trie = dynamic_cast<RuleTrie*>(inputTable);
+      assert(trie);
+      m_inputRuleTries.push_back(boost::shared_ptr<RuleTrie>(trie));
+      p.reset(new RuleMatcher(m_inputTree, *trie));
+      m_ruleMatchers.push_back(p);
+    }
   }
 
   // Create an additional rule trie + matcher for glue rules (which are
@@ -54,6 +54,7 @@ private:
   InputTree m_inputTree;
   F2S::PVertexToStackMap m_stackMap;
   boost::shared_ptr<RuleTrie> m_glueRuleTrie;
+  std::vector<boost::shared_ptr<RuleTrie> > m_inputRuleTries;
   std::vector<boost::shared_ptr<RuleMatcher> > m_ruleMatchers;
   RuleMatcher *m_glueRuleMatcher;
 };
@@ -22,6 +22,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "ThreadPool.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 #ifdef WITH_THREADS
 
 using namespace std;
@@ -99,6 +102,198 @@ void ThreadPool::Stop(bool processRemainingJobs)
   m_threads.join_all();
 }
 
+namespace
+{
+//! orders a deque by decreasing cost
+bool CostlierThan(const boost::shared_ptr<Task> &a, const boost::shared_ptr<Task> &b)
+{
+  return a->GetCost() > b->GetCost();
+}
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(size_t numThreads, bool longestFirst)
+  : m_numQueued(0), m_nextWorker(0), m_longestFirst(longestFirst)
+  , m_stopped(false), m_stopping(false), m_queueLimit(0)
+{
+  if (numThreads == 0) numThreads = 1;
+  for (size_t i = 0; i < numThreads; ++i) {
+    m_workers.push_back(new Worker);
+  }
+  for (size_t i = 0; i < numThreads; ++i) {
+    m_threads.create_thread(boost::bind(&WorkStealingThreadPool::Execute,this,i));
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+  Stop();
+  for (size_t i = 0; i < m_workers.size(); ++i) {
+    delete m_workers[i];
+  }
+}
+
+boost::shared_ptr<Task> WorkStealingThreadPool::Pop(size_t id)
+{
+  boost::shared_ptr<Task> task;
+  if (m_longestFirst) {
+    task = TakeCostliest(id);
+  } else {
+    {
+      // own deque: oldest task first
+      Worker &self = *m_workers[id];
+      boost::mutex::scoped_lock lock(self.m_mutex);
+      if (!self.m_tasks.empty()) {
+        task = self.m_tasks.front();
+        self.m_tasks.pop_front();
+      }
+    }
+    if (!task) {
+      task = Steal(id);
+    }
+  }
+  if (task) {
+    --m_numQueued;
+    NotifyAvailable();
+  }
+  return task;
+}
+
+boost::shared_ptr<Task> WorkStealingThreadPool::Steal(size_t id)
+{
+  boost::shared_ptr<Task> task;
+  const size_t n = m_workers.size();
+  // take from the back, away from the victim's own end of the deque
+  for (size_t i = 1; i < n && !task; ++i) {
+    Worker &victim = *m_workers[(id + i) % n];
+    boost::mutex::scoped_lock lock(victim.m_mutex);
+    if (!victim.m_tasks.empty()) {
+      task = victim.m_tasks.back();
+      victim.m_tasks.pop_back();
+    }
+  }
+  return task;
+}
+
+boost::shared_ptr<Task> WorkStealingThreadPool::TakeCostliest(size_t id)
+{
+  // Each deque is sorted, so the most expensive queued task is at the front
+  // of one of them.  Look at all fronts, starting with our own deque so that
+  // it wins ties.
+  boost::shared_ptr<Task> task;
+  const size_t n = m_workers.size();
+  size_t bestCost = 0;
+  size_t best = n;
+  for (size_t i = 0; i < n; ++i) {
+    Worker &worker = *m_workers[(id + i) % n];
+    boost::mutex::scoped_lock lock(worker.m_mutex);
+    if (!worker.m_tasks.empty()
+        && (best == n || worker.m_tasks.front()->GetCost() > bestCost)) {
+      best = (id + i) % n;
+      bestCost = worker.m_tasks.front()->GetCost();
+    }
+  }
+  if (best != n) {
+    // the front may have changed since we looked; take whatever is there
+    // now, or come back through Execute() if the deque has been emptied
+    Worker &worker = *m_workers[best];
+    boost::mutex::scoped_lock lock(worker.m_mutex);
+    if (!worker.m_tasks.empty()) {
+      task = worker.m_tasks.front();
+      worker.m_tasks.pop_front();
+    }
+  }
+  return task;
+}
+
+void WorkStealingThreadPool::NotifyAvailable()
+{
+  // only Submit() with a queue limit and Stop() ever wait for this
+  if (m_queueLimit == 0 && !m_stopping) return;
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+  }
+  m_threadAvailable.notify_all();
+}
+
+void WorkStealingThreadPool::Execute(size_t id)
+{
+  while (!m_stopped) {
+    boost::shared_ptr<Task> task = Pop(id);
+    if (task) {
+      task->Run();
+      continue;
+    }
+    // nothing to do anywhere: sleep until a task is submitted
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_numQueued == 0 && !m_stopped) {
+      m_threadNeeded.wait(lock);
+    }
+  }
+}
+
+void WorkStealingThreadPool::Submit(boost::shared_ptr<Task> task)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  if (m_stopping) {
+    throw runtime_error("ThreadPool stopping - unable to accept new jobs");
+  }
+  while (m_queueLimit > 0 && m_numQueued >= m_queueLimit) {
+    m_threadAvailable.wait(lock);
+  }
+  // count the task before it becomes visible, so the counter never wraps
+  ++m_numQueued;
+  Worker &worker = *m_workers[m_nextWorker];
+  m_nextWorker = (m_nextWorker + 1) % m_workers.size();
+  {
+    boost::mutex::scoped_lock workerLock(worker.m_mutex);
+    if (m_longestFirst) {
+      worker.m_tasks.insert(std::upper_bound(worker.m_tasks.begin(),
+                                             worker.m_tasks.end(),
+                                             task, CostlierThan), task);
+    } else {
+      worker.m_tasks.push_back(task);
+    }
+  }
+  m_threadNeeded.notify_one();
+}
+
+void WorkStealingThreadPool::Stop(bool processRemainingJobs)
+{
+  {
+    //prevent more jobs from being added to the queue
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (m_stopped) return;
+    m_stopping = true;
+  }
+  if (processRemainingJobs) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    //wait for all deques to drain.
+    while (m_numQueued > 0 && !m_stopped) {
+      m_threadAvailable.wait(lock);
+    }
+  }
+  //tell all threads to stop
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_stopped = true;
+  }
+  m_threadNeeded.notify_all();
+
+  m_threads.join_all();
+}
+
+TaskScheduler *CreateTaskScheduler(const std::string &name, size_t numThreads)
+{
+  if (name == "fifo") {
+    return new ThreadPool(numThreads);
+  } else if (name == "work-stealing") {
+    return new WorkStealingThreadPool(numThreads, false);
+  } else if (name == "longest-first") {
+    return new WorkStealingThreadPool(numThreads, true);
+  }
+  throw runtime_error("Unknown thread scheduler: " + name);
+}
+
 }
 #endif //WITH_THREADS
 
@@ -23,12 +23,15 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #define moses_ThreadPool_h
 
 #include <iostream>
+#include <deque>
 #include <queue>
+#include <string>
 #include <vector>
 
 #include <boost/shared_ptr.hpp>
 
 #ifdef WITH_THREADS
+#include <boost/atomic.hpp>
 #include <boost/bind.hpp>
 #include <boost/thread.hpp>
 #endif
@@ -54,11 +57,33 @@ class Task
 public:
   virtual void Run() = 0;
   virtual ~Task() {}
+
+  /** Rough estimate of the work involved (e.g. input length), used by
+   *  schedulers that start the most expensive tasks first */
+  virtual size_t GetCost() const {
+    return 0;
+  }
 };
 
 #ifdef WITH_THREADS
 
-class ThreadPool
+/** Interface shared by the thread pool implementations below
+ */
+class TaskScheduler
+{
+public:
+  virtual ~TaskScheduler() {}
+  virtual void Submit(boost::shared_ptr<Task> task) = 0;
+  virtual void Stop(bool processRemainingJobs = false) = 0;
+  virtual void SetQueueLimit(size_t limit) = 0;
+};
+
+/** Create a scheduler by name: "fifo" (ThreadPool), "work-stealing" or
+ *  "longest-first" (WorkStealingThreadPool)
+ */
+TaskScheduler *CreateTaskScheduler(const std::string &name, size_t numThreads);
+
+class ThreadPool : public TaskScheduler
 {
 public:
   /**
@@ -88,6 +113,10 @@ public:
     m_queueLimit = limit;
   }
 
+  size_t GetNumThreads() const {
+    return m_threads.size();
+  }
+
 private:
   /**
    * The main loop executed by each thread.
@@ -104,6 +133,66 @@ private:
   size_t m_queueLimit;
 };
 
+/** Thread pool with one task deque per worker.
+ *
+ * Submitted tasks are dealt round-robin to the workers' deques. A worker
+ * takes tasks from its own deque and, once that is empty, steals from the
+ * other workers, so the shared lock is only taken to submit tasks and to
+ * put idle workers to sleep.
+ *
+ * With longestFirst, each deque is kept ordered by Task::GetCost(), and a
+ * worker compares the fronts of all deques and takes the most expensive
+ * task queued anywhere, preferring its own deque on ties. Long inputs
+ * therefore start first and do not end up as stragglers at the end of a
+ * batch. Tasks submitted while a worker is looking may be missed by that
+ * look, so the order is only exact when submission and execution do not
+ * overlap.
+ */
+class WorkStealingThreadPool : public TaskScheduler
+{
+public:
+  WorkStealingThreadPool(size_t numThreads, bool longestFirst = false);
+
+  ~WorkStealingThreadPool();
+
+  void Submit(boost::shared_ptr<Task> task);
+
+  void Stop(bool processRemainingJobs = false);
+
+  void SetQueueLimit( size_t limit ) {
+    m_queueLimit = limit;
+  }
+
+private:
+  struct Worker {
+    boost::mutex m_mutex;
+    std::deque<boost::shared_ptr<Task> > m_tasks;
+  };
+
+  void Execute(size_t id);
+
+  //! take a task from worker id's own deque, or steal one from another
+  boost::shared_ptr<Task> Pop(size_t id);
+  boost::shared_ptr<Task> Steal(size_t id);
+  //! longest-first: take the most expensive task in any deque
+  boost::shared_ptr<Task> TakeCostliest(size_t id);
+
+  //! wake up threads blocked in Submit() or Stop()
+  void NotifyAvailable();
+
+  std::vector<Worker*> m_workers;
+  boost::thread_group m_threads;
+  boost::mutex m_mutex;
+  boost::condition_variable m_threadNeeded;
+  boost::condition_variable m_threadAvailable;
+  boost::atomic<size_t> m_numQueued;
+  size_t m_nextWorker;
+  bool m_longestFirst;
+  boost::atomic<bool> m_stopped;
+  boost::atomic<bool> m_stopping;
+  size_t m_queueLimit;
+};
+
 class TestTask : public Task
 {
 public:
@@ -0,0 +1,110 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2011 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "ChartRuleLookupManagerCYKPlus.h"
+#include "CompletedRuleCollection.h"
+#include "moses/NonTerminal.h"
+#include <boost/unordered_map.hpp>
+
+#include "moses/TranslationModel/RuleTable/PhraseDictionaryMemoryImage.h"
+#include "moses/StackVec.h"
+
+namespace Moses
+{
+
+class ChartParserCallback;
+class Range;
+
+/** Implementation of ChartRuleLookupManager for mapped rule table images.
+ *  The same search as ChartRuleLookupManagerMemory, over image nodes. */
+class ChartRuleLookupManagerMemoryImage : public ChartRuleLookupManagerCYKPlus
+{
+public:
+  typedef std::vector<ChartCellCache> CompressedColumn;
+  typedef std::vector<CompressedColumn> CompressedMatrix;
+
+
+  ChartRuleLookupManagerMemoryImage(const ChartParser &parser,
+                                    const ChartCellCollectionBase &cellColl,
+                                    const PhraseDictionaryMemoryImage &ruleTable);
+
+  ~ChartRuleLookupManagerMemoryImage() {};
+
+  virtual void GetChartRuleCollection(
+    const InputPath &inputPath,
+    size_t lastPos, // last position to consider if using lookahead
+    ChartParserCallback &outColl);
+
+private:
+
+  void GetTerminalExtension(
+    const PhraseDictionaryMemoryImage::Node *node,
+    size_t pos);
+
+  void GetNonTerminalExtension(
+    const PhraseDictionaryMemoryImage::Node *node,
+    size_t startPos);
+
+  void AddAndExtend(
+    const PhraseDictionaryMemoryImage::Node *node,
+    size_t endPos);
+
+  void UpdateCompressedMatrix(size_t startPos,
+                              size_t endPos,
+                              size_t lastPos);
+
+  //! source vocab id of the input word at pos, or kNone
+  uint32_t GetSourceId(size_t pos);
+
+  const PhraseDictionaryMemoryImage &m_ruleTable;
+  const RuleTableImage &m_image;
+
+  std::vector<uint32_t> m_sourceIds;
+  std::vector<bool> m_sourceIdKnown;
+
+  // collections in use by this sentence, so that the shared cache cannot
+  // free them while the chart still points to them
+  boost::unordered_map<uint32_t, TargetPhraseCollection::shared_ptr> m_collections;
+
+  // permissible soft nonterminal matches (target side)
+  bool m_isSoftMatching;
+  const std::vector<std::vector<Word> >& m_softMatchingMap;
+
+  // temporary storage of completed rules (one collection per end position; all rules collected consecutively start from the same position)
+  std::vector<CompletedRuleCollection> m_completedRules;
+
+  size_t m_lastPos;
+  size_t m_unaryPos;
+
+  StackVec m_stackVec;
+  std::vector<float> m_stackScores;
+  std::vector<const Word*> m_sourceWords;
+  ChartParserCallback* m_outColl;
+
+  std::vector<CompressedMatrix> m_compressedMatrixVec;
+
+
+};
+
+}  // namespace Moses
+
@@ -49,6 +49,11 @@ public:
                                       size_t last,
                                       ChartParserCallback &outColl);
 
+  //! dotted rules of a span only extend those of the span one word shorter
+  bool SupportsWidthOrder() const {
+    return true;
+  }
+
 private:
   const PhraseDictionaryOnDisk &m_dictionary;
   OnDiskPt::OnDiskWrapper &m_dbWrapper;
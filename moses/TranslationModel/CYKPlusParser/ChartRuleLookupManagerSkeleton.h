@@ -45,6 +45,10 @@ public:
     size_t last,
     ChartParserCallback &outColl);
 
+  bool SupportsWidthOrder() const {
+    return true;
+  }
+
 private:
   TargetPhrase *CreateTargetPhrase(const Word &sourceWord) const;
 
@@ -19,6 +19,8 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <algorithm>
+
 #include "ThrowingFwrite.h"
 #include "BlockHashIndex.h"
 #include "CmphStringVectorAdapter.h"
@@ -37,7 +39,7 @@ BlockHashIndex::BlockHashIndex(size_t orderBits, size_t fingerPrintBits,
   : m_orderBits(orderBits), m_fingerPrintBits(fingerPrintBits),
     m_fileHandle(0), m_fileHandleStart(0), m_landmarks(true), m_size(0),
     m_lastSaved(-1), m_lastDropped(-1), m_numLoadedRanges(0),
-    m_threadPool(threadsNum)
+    m_mappedStart(0), m_indexPos(0), m_threadPool(threadsNum)
 {
 #ifndef HAVE_CMPH
   std::cerr << "minphr: CMPH support not compiled in." << std::endl;
@@ -48,7 +50,8 @@ BlockHashIndex::BlockHashIndex(size_t orderBits, size_t fingerPrintBits,
 BlockHashIndex::BlockHashIndex(size_t orderBits, size_t fingerPrintBits)
   : m_orderBits(orderBits), m_fingerPrintBits(fingerPrintBits),
     m_fileHandle(0), m_fileHandleStart(0), m_size(0),
-    m_lastSaved(-1), m_lastDropped(-1), m_numLoadedRanges(0)
+    m_lastSaved(-1), m_lastDropped(-1), m_numLoadedRanges(0),
+    m_mappedStart(0), m_indexPos(0)
 {
 #ifndef HAVE_CMPH
   std::cerr << "minphr: CMPH support not compiled in." << std::endl;
@@ -70,14 +73,23 @@ BlockHashIndex::~BlockHashIndex()
     if(*it != 0)
       delete *it;
 #endif
+
+  if(m_mappedRanges)
+    for(size_t i = 0; i < m_seekIndex.size(); i++)
+      DeleteMappedRange(m_mappedRanges[i].load());
 }
 
-size_t BlockHashIndex::GetHash(const char* key)
+size_t BlockHashIndex::GetRange(const char* key) const
 {
   std::string keyStr(key);
-  size_t i = std::distance(m_landmarks.begin(),
-                           std::upper_bound(m_landmarks.begin(),
-                               m_landmarks.end(), keyStr)) - 1;
+  return std::distance(m_landmarks.begin(),
+                       std::upper_bound(m_landmarks.begin(),
+                                        m_landmarks.end(), keyStr)) - 1;
+}
+
+size_t BlockHashIndex::GetHash(const char* key)
+{
+  size_t i = GetRange(key);
 
   if(i == 0ul-1)
     return GetSize();
@@ -104,15 +116,28 @@ size_t BlockHashIndex::GetHash(size_t i, const char* key)
 //#endif
   //if(m_hashes[i] == 0)
   //LoadRange(i);
+  void* hash;
+  PairedPackedArray<>* array;
+  if(m_mappedRanges) {
+    MappedRange* range = m_mappedRanges[i].load(boost::memory_order_acquire);
+    if(range == 0)
+      range = LoadMappedRange(i);
+    hash = range->hash;
+    array = range->array;
+  } else {
+    hash = m_hashes[i];
+    array = m_arrays[i];
+    m_clocks[i] = clock();
+  }
+
 #ifdef HAVE_CMPH
-  size_t idx = cmph_search((cmph_t*)m_hashes[i], key, (cmph_uint32) strlen(key));
+  size_t idx = cmph_search((cmph_t*)hash, key, (cmph_uint32) strlen(key));
 #else
   assert(0);
   size_t idx = 0;
 #endif
 
-  std::pair<size_t, size_t> orderPrint = m_arrays[i]->Get(idx, m_orderBits, m_fingerPrintBits);
-  m_clocks[i] = clock();
+  std::pair<size_t, size_t> orderPrint = array->Get(idx, m_orderBits, m_fingerPrintBits);
 
   if(GetFprint(key) == orderPrint.second)
     return orderPrint.first;
@@ -263,6 +288,7 @@ size_t BlockHashIndex::LoadIndex(std::FILE* mphf)
   size_t relIndexPos;
   read += std::fread(&relIndexPos, sizeof(size_t), 1, mphf);
   std::fseek(m_fileHandle, m_fileHandleStart + relIndexPos, SEEK_SET);
+  m_indexPos = relIndexPos;
 
   m_landmarks.load(mphf);
 
@@ -316,6 +342,100 @@ size_t BlockHashIndex::Load(std::FILE * mphf)
   return byteSize;
 }
 
+size_t BlockHashIndex::LoadMapped(std::FILE * mphf)
+{
+  size_t byteSize = LoadIndex(mphf);
+
+  // blocks run from m_fileHandleStart to the index, mappings start on a page
+  size_t page = util::SizePage();
+  size_t mapStart = m_fileHandleStart / page * page;
+  util::MapRead(util::LAZY, fileno(mphf), mapStart,
+                m_fileHandleStart + m_indexPos - mapStart, m_mapping);
+  m_mappedStart = m_mapping.begin() + (m_fileHandleStart - mapStart);
+
+  m_mappedRanges.reset(new boost::atomic<MappedRange*>[m_seekIndex.size()]);
+  for(size_t i = 0; i < m_seekIndex.size(); i++)
+    m_mappedRanges[i].store(0);
+
+  return byteSize;
+}
+
+const char* BlockHashIndex::MappedRangeBegin(size_t i) const
+{
+  return m_mappedStart + m_seekIndex[i];
+}
+
+const char* BlockHashIndex::MappedRangeEnd(size_t i) const
+{
+  return m_mappedStart + (i + 1 < m_seekIndex.size() ? m_seekIndex[i + 1] : m_indexPos);
+}
+
+BlockHashIndex::MappedRange* BlockHashIndex::LoadMappedRange(size_t i)
+{
+  MappedRange* range = new MappedRange();
+#ifdef HAVE_CMPH
+#if defined(_WIN32) || defined(_WIN64)
+  UTIL_THROW2("Mapped phrase indexes are not supported on Windows");
+#else
+  // cmph only loads from a stream
+  const char* begin = MappedRangeBegin(i);
+  std::FILE* in = fmemopen(const_cast<char*>(begin), MappedRangeEnd(i) - begin, "r");
+  UTIL_THROW_IF2(in == 0, "Could not open block " << i << " of a mapped phrase index");
+  range->hash = (void*)cmph_load(in);
+  range->array = new PairedPackedArray<>(0, m_orderBits, m_fingerPrintBits);
+  range->array->Load(in);
+  std::fclose(in);
+#endif
+#endif
+
+  MappedRange* loaded = 0;
+  if(!m_mappedRanges[i].compare_exchange_strong(loaded, range,
+      boost::memory_order_acq_rel, boost::memory_order_acquire)) {
+    // another thread loaded the block first
+    DeleteMappedRange(range);
+    return loaded;
+  }
+  return range;
+}
+
+void BlockHashIndex::DeleteMappedRange(MappedRange* range)
+{
+  if(range == 0)
+    return;
+#ifdef HAVE_CMPH
+  if(range->hash != 0)
+    cmph_destroy((cmph_t*)range->hash);
+#endif
+  delete range->array;
+  delete range;
+}
+
+void BlockHashIndex::Prefetch(const std::vector<std::string>& keys) const
+{
+  if(!m_mappedRanges)
+    return;
+
+  std::vector<size_t> ranges;
+  for(size_t k = 0; k < keys.size(); k++) {
+    size_t i = GetRange(keys[k].c_str());
+    if(i != 0ul-1 && m_mappedRanges[i].load(boost::memory_order_relaxed) == 0)
+      ranges.push_back(i);
+  }
+  std::sort(ranges.begin(), ranges.end());
+  ranges.erase(std::unique(ranges.begin(), ranges.end()), ranges.end());
+
+  // Blocks are stored back to back, so runs of neighbouring blocks are
+  // advised as one span
+  for(size_t r = 0; r < ranges.size(); ) {
+    size_t last = r;
+    while(last + 1 < ranges.size() && ranges[last + 1] == ranges[last] + 1)
+      last++;
+    const char* begin = MappedRangeBegin(ranges[r]);
+    util::AdviseWillNeed(begin, MappedRangeEnd(ranges[last]) - begin);
+    r = last + 1;
+  }
+}
+
 size_t BlockHashIndex::GetSize() const
 {
   return m_size;
@@ -42,8 +42,12 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <ctime>
 #endif
 
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include "util/mmap.hh"
+
 namespace Moses
 {
 
@@ -71,6 +75,23 @@ private:
   int m_lastDropped;
   size_t m_numLoadedRanges;
 
+  // With LoadMapped, the blocks stay in the mapped file until they are first
+  // used. Each is then loaded by the thread that needs it and published with
+  // a compare-and-swap, so lookups never take a lock.
+  struct MappedRange {
+    void* hash;
+    PairedPackedArray<>* array;
+  };
+  util::scoped_memory m_mapping;
+  const char* m_mappedStart;
+  size_t m_indexPos;
+  boost::scoped_array<boost::atomic<MappedRange*> > m_mappedRanges;
+
+  const char* MappedRangeBegin(size_t i) const;
+  const char* MappedRangeEnd(size_t i) const;
+  MappedRange* LoadMappedRange(size_t i);
+  void DeleteMappedRange(MappedRange* range);
+
 #ifdef WITH_THREADS
   ThreadPool m_threadPool;
   boost::mutex m_mutex;
@@ -99,6 +120,7 @@ private:
 
   size_t GetFprint(const char* key) const;
   size_t GetHash(size_t i, const char* key);
+  size_t GetRange(const char* key) const;
 
 public:
 #ifdef WITH_THREADS
@@ -137,6 +159,13 @@ public:
   size_t Load(std::string filename);
   size_t Load(std::FILE * mphf);
 
+  // Reads only the block index and maps the rest, see m_mappedRanges
+  size_t LoadMapped(std::FILE * mphf);
+
+  // With a mapped index, asks the kernel to page in the not yet loaded
+  // blocks of keys, each block once
+  void Prefetch(const std::vector<std::string>& keys) const;
+
   size_t GetSize() const;
 
   void KeepNLastRanges(float ratio = 0.1, float tolerance = 0.1);
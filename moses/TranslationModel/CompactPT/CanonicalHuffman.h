@@ -23,8 +23,12 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #define moses_CanonicalHuffman_h
 
 #include <string>
+#include <vector>
 #include <algorithm>
+#include <cstring>
+#include <stdint.h>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/static_assert.hpp>
 #include <boost/unordered_map.hpp>
 
 #include "ThrowingFwrite.h"
@@ -43,6 +47,19 @@ private:
   typedef boost::unordered_map<Data, boost::dynamic_bitset<> > EncodeMap;
   EncodeMap m_encodeMap;
 
+  // Decoding table indexed by the next kTableBits bits of a stream, first
+  // bit lowest. If a code ends within these bits, the entry holds its symbol
+  // and length. Otherwise the bits start a longer code and the entry holds
+  // the shortest length such a code can have; the code is then decoded from
+  // a single peek at the stream rather than bit by bit.
+  enum { kTableBits = 10 };
+
+  struct TableEntry {
+    Data symbol;
+    unsigned char length;
+  };
+  std::vector<TableEntry> m_decodeTable;
+
   struct MinHeapSorter {
     std::vector<size_t>& m_vec;
 
@@ -157,6 +174,53 @@ private:
     }
   }
 
+  static uint64_t ReverseBits(uint64_t x) {
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return __builtin_bswap64(x);
+  }
+
+  // Decodes a code of at least minLength bits from the first available bits
+  // of bits (first bit lowest) as the bit by bit loop in ReadBitwise would.
+  // Returns false if no valid code ends within these bits.
+  bool DecodeCode(uint64_t bits, size_t available, size_t minLength,
+                  size_t& length, size_t& index) const {
+    // with the first bit highest, the code of each length is a prefix
+    uint64_t reversed = ReverseBits(bits);
+    for(size_t len = minLength; len <= available && len < m_firstCodes.size(); len++) {
+      size_t intCode = reversed >> (64 - len);
+      if(intCode >= m_firstCodes[len]) {
+        length = len;
+        index = m_lengthIndex[len] + (intCode - m_firstCodes[len]);
+        return index < m_symbols.size();
+      }
+    }
+    return false;
+  }
+
+  void CreateDecodeTable() {
+    m_decodeTable.clear();
+    if(m_firstCodes.size() < 2 || m_symbols.empty())
+      return;
+
+    m_decodeTable.resize(1 << kTableBits);
+    for(size_t bits = 0; bits < m_decodeTable.size(); bits++) {
+      TableEntry& entry = m_decodeTable[bits];
+      size_t length, index;
+      if(DecodeCode(bits, kTableBits, 1, length, index)) {
+        entry.symbol = m_symbols[index];
+        entry.length = length;
+      } else {
+        // of the codes starting with these bits, the one continuing with
+        // ones is the shortest
+        entry.length = kTableBits + 1;
+        if(DecodeCode(bits | ~uint64_t((1 << kTableBits) - 1), 64, kTableBits + 1, length, index))
+          entry.length = length;
+      }
+    }
+  }
+
   const boost::dynamic_bitset<>& Encode(Data data) const {
     typename EncodeMap::const_iterator it = m_encodeMap.find(data);
     UTIL_THROW_IF2(it == m_encodeMap.end(), "Cannot find symbol in encoding map");
@@ -176,6 +240,7 @@ public:
     std::vector<size_t> lengths;
     CalcLengths(begin, end, lengths);
     CalcCodes(lengths);
+    CreateDecodeTable();
 
     if(forEncoding)
       CreateCodeMap();
@@ -195,6 +260,28 @@ public:
 
   template <class BitWrapper>
   Data Read(BitWrapper& bitWrapper) {
+    size_t left = bitWrapper.TellFromEnd();
+    if(left && !m_decodeTable.empty()) {
+      uint64_t bits = bitWrapper.Peek();
+      const TableEntry& entry = m_decodeTable[bits & ((1 << kTableBits) - 1)];
+      size_t length = entry.length, index;
+      if(length <= kTableBits) {
+        if(length <= left) {
+          bitWrapper.Skip(length);
+          return entry.symbol;
+        }
+      } else if(DecodeCode(bits, std::min<size_t>(left, BitWrapper::kPeekBits), length,
+                           length, index)) {
+        bitWrapper.Skip(length);
+        return m_symbols[index];
+      }
+    }
+    return ReadBitwise(bitWrapper);
+  }
+
+  // The plain canonical decoder, one bit at a time
+  template <class BitWrapper>
+  Data ReadBitwise(BitWrapper& bitWrapper) {
     if(bitWrapper.TellFromEnd()) {
       size_t intCode = bitWrapper.Read();
       size_t len = 1;
@@ -224,6 +311,8 @@ public:
     m_lengthIndex.resize(size);
     read += std::fread(&m_lengthIndex[0], sizeof(size_t), size, pFile);
 
+    CreateDecodeTable();
+
     return std::ftell(pFile) - start;
   }
 
@@ -261,6 +350,9 @@ private:
 
 public:
 
+  // number of bits of a Peek that are always valid
+  enum { kPeekBits = 57 };
+
   BitWrapper(Container &data)
     : m_data(data), m_iterator(m_data.begin()), m_currentValue(0),
       m_valueBits(sizeof(typename Container::value_type) * 8),
@@ -287,6 +379,39 @@ public:
     m_bitPos++;
   }
 
+  // Returns the next bits of the stream without reading them, the first bit
+  // lowest. Bits past the end of the stream are zero.
+  uint64_t Peek() const {
+    BOOST_STATIC_ASSERT(sizeof(typename Container::value_type) == 1);
+    size_t byte = m_bitPos / 8;
+    if(byte >= m_data.size())
+      return 0;
+
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(&m_data[0]);
+    uint64_t word = 0;
+    if(byte + 8 <= m_data.size()) {
+      std::memcpy(&word, data + byte, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      word = __builtin_bswap64(word);
+#endif
+    } else {
+      for(size_t i = byte; i < m_data.size(); i++)
+        word |= uint64_t(data[i]) << (8 * (i - byte));
+    }
+    return word >> (m_bitPos % 8);
+  }
+
+  // Moves forward by bits, which must not pass the end of the stream
+  void Skip(size_t bits) {
+    const size_t valueBits = sizeof(typename Container::value_type) * 8;
+    if(bits) {
+      m_bitPos += bits;
+      size_t last = m_bitPos - 1;
+      m_iterator = m_data.begin() + last / valueBits + 1;
+      m_currentValue = m_data[last / valueBits] >> (last % valueBits);
+    }
+  }
+
   size_t Tell() {
     return m_bitPos;
   }
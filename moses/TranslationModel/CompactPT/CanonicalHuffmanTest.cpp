@@ -0,0 +1,90 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2016 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "CanonicalHuffman.h"
+#include "util/exception.hh"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+// Zipfian counts over a vocabulary large enough for codes longer than the
+// decoding table
+struct HuffmanFixture {
+  HuffmanFixture() {
+    for(unsigned i = 0; i < 5000; i++)
+      counts.push_back(make_pair(i, 1000000 / (i + 1) + 1));
+
+    CanonicalHuffman<unsigned> tree(counts.begin(), counts.end());
+    BitWrapper<> bitStream(encoded);
+    unsigned seed = 1;
+    for(size_t i = 0; i < 20000; i++) {
+      seed = seed * 1103515245 + 12345;
+      unsigned symbol = (seed >> 16) % 7 ? (seed >> 16) % 20 : (seed >> 8) % 5000;
+      symbols.push_back(symbol);
+      tree.Put(bitStream, symbol);
+    }
+  }
+
+  vector<pair<unsigned, size_t> > counts;
+  vector<unsigned> symbols;
+  string encoded;
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(canonical_huffman, HuffmanFixture)
+
+BOOST_AUTO_TEST_CASE(table_matches_bitwise)
+{
+  CanonicalHuffman<unsigned> tree(counts.begin(), counts.end(), false);
+
+  BitWrapper<> bitwise(encoded), table(encoded);
+  while(bitwise.TellFromEnd()) {
+    BOOST_REQUIRE_EQUAL(tree.ReadBitwise(bitwise), tree.Read(table));
+    BOOST_REQUIRE_EQUAL(bitwise.Tell(), table.Tell());
+  }
+  BOOST_CHECK_EQUAL(table.TellFromEnd(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(loaded_tree)
+{
+  CanonicalHuffman<unsigned> tree(counts.begin(), counts.end(), false);
+  std::FILE* file = std::tmpfile();
+  BOOST_REQUIRE(file);
+  tree.Save(file);
+  std::rewind(file);
+  CanonicalHuffman<unsigned> loaded(file);
+  std::fclose(file);
+
+  BitWrapper<> bitStream(encoded);
+  for(size_t i = 0; i < symbols.size(); i++)
+    BOOST_REQUIRE_EQUAL(loaded.Read(bitStream), symbols[i]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -20,6 +20,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
 #include <deque>
+#include <limits>
 
 #include "PhraseDecoder.h"
 #include "moses/StaticData.h"
@@ -202,8 +203,13 @@ TargetPhraseVectorPtr PhraseDecoder::CreateTargetPhraseCollection(const Phrase &
     std::pair<TargetPhraseVectorPtr, size_t> cachedPhraseColl
     = m_decodingCache.Retrieve(sourcePhrase);
 
-    // Has been cached and is complete or does not need to be completed
-    if(cachedPhraseColl.first != NULL && (!topLevel || cachedPhraseColl.second == 0))
+    // Has been cached and holds as many target phrases as are needed: a top
+    // level lookup needs the decode limit, a subphrase lookup every rank a
+    // PREnc symbol can refer to
+    size_t needed = topLevel ? GetDecodeLimit()
+                    : (m_maxRank ? m_maxRank : std::numeric_limits<size_t>::max());
+    if(cachedPhraseColl.first != NULL
+        && TargetPhraseCollectionCache::Covers(cachedPhraseColl, needed))
       return cachedPhraseColl.first;
 
     // Has been cached, but is incomplete
@@ -246,7 +252,6 @@ TargetPhraseVectorPtr PhraseDecoder::DecodeCollection(
   const Phrase &sourcePhrase, bool topLevel, bool eval)
 {
 
-  bool extending = tpv->size();
   size_t bitsLeft = encodedBitStream.TellFromEnd();
 
   typedef std::pair<size_t, size_t> AlignPointSizeT;
@@ -435,6 +440,11 @@ TargetPhraseVectorPtr PhraseDecoder::DecodeCollection(
           break;
       }
 
+      // the remaining phrases would fall outside the table limit; with
+      // PREnc the position is cached, so they can still be decoded later
+      if(topLevel && tpv->size() >= GetDecodeLimit())
+        break;
+
       if(encodedBitStream.TellFromEnd() <= 8)
         break;
 
@@ -442,7 +452,8 @@ TargetPhraseVectorPtr PhraseDecoder::DecodeCollection(
     }
   }
 
-  if(m_coding == PREnc && !extending) {
+  // An extended collection replaces the shorter one it was resumed from
+  if(m_coding == PREnc) {
     bitsLeft = bitsLeft > 8 ? bitsLeft : 0;
     m_decodingCache.Cache(sourcePhrase, tpv, bitsLeft, m_maxRank);
   }
@@ -450,9 +461,11 @@ TargetPhraseVectorPtr PhraseDecoder::DecodeCollection(
   return tpv;
 }
 
-void PhraseDecoder::PruneCache()
+size_t PhraseDecoder::GetDecodeLimit() const
 {
-  m_decodingCache.Prune();
+  if(m_phraseDictionary.m_bestFirst && m_phraseDictionary.GetTableLimit())
+    return m_phraseDictionary.GetTableLimit();
+  return std::numeric_limits<size_t>::max();
 }
 
 }
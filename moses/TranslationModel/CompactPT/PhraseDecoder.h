@@ -114,6 +114,9 @@ protected:
 
   std::string MakeSourceKey(std::string &);
 
+  //! number of target phrases decoded for a top level source phrase
+  size_t GetDecodeLimit() const;
+
 public:
 
   PhraseDecoder(
@@ -135,8 +138,6 @@ public:
                                          const Phrase &sourcePhrase,
                                          bool topLevel,
                                          bool eval);
-
-  void PruneCache();
 };
 
 }
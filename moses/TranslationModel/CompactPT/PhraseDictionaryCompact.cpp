@@ -35,7 +35,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/InputFileStream.h"
 #include "moses/StaticData.h"
 #include "moses/Range.h"
+#include "moses/Sentence.h"
 #include "moses/ThreadPool.h"
+#include "moses/TranslationTask.h"
 #include "util/exception.hh"
 
 using namespace std;
@@ -50,12 +52,24 @@ PhraseDictionaryCompact::PhraseDictionaryCompact(const std::string &line)
   :PhraseDictionary(line, true)
   ,m_inMemory(true)//(s_inMemoryByDefault)
   ,m_useAlignmentInfo(true)
+  ,m_bestFirst(false)
   ,m_hash(10, 16)
   ,m_phraseDecoder(0)
 {
   ReadParameters();
 }
 
+void PhraseDictionaryCompact::SetParameter(const std::string& key, const std::string& value)
+{
+  if (key == "best-first") {
+    m_bestFirst = Scan<bool>(value);
+  } else if (key == "mmap") {
+    m_inMemory = !Scan<bool>(value);
+  } else {
+    PhraseDictionary::SetParameter(key, value);
+  }
+}
+
 void PhraseDictionaryCompact::Load(AllOptions::ptr const& opts)
 {
   m_options = opts;
@@ -76,12 +90,12 @@ void PhraseDictionaryCompact::Load(AllOptions::ptr const& opts)
   std::FILE* pFile = std::fopen(tFilePath.c_str() , "r");
 
   size_t indexSize;
-  //if(m_inMemory)
-  // Load source phrase index into memory
-  indexSize = m_hash.Load(pFile);
-  // else
-  // Keep source phrase index on disk
-  //indexSize = m_hash.LoadIndex(pFile);
+  if(m_inMemory)
+    // Load source phrase index into memory
+    indexSize = m_hash.Load(pFile);
+  else
+    // Keep source phrase index on disk, blocks are loaded as they are used
+    indexSize = m_hash.LoadMapped(pFile);
 
   size_t coderSize = m_phraseDecoder->Load(pFile);
 
@@ -169,6 +183,35 @@ PhraseDictionaryCompact::
 AddEquivPhrase(const Phrase &source, const TargetPhrase &targetPhrase)
 { }
 
+void
+PhraseDictionaryCompact::
+InitializeForInput(ttasksptr const& ttask)
+{
+  if(m_inMemory)
+    return;
+
+  // Ask for the index blocks of the sentence's source phrases up front, so
+  // the kernel reads them in parallel rather than one page fault at a time
+  // during lookup.  Only the phrases the search can use are considered, and
+  // nothing is looked up here.
+  const InputType &source = *ttask->GetSource();
+  if(source.GetType() != SentenceInput)
+    return;
+  const Sentence &sentence = static_cast<const Sentence&>(source);
+
+  std::vector<std::string> keys;
+  size_t maxLength = std::min<size_t>(m_phraseDecoder->GetMaxSourcePhraseLength(),
+                                      ttask->options()->search.max_phrase_length);
+  for(size_t start = 0; start < sentence.GetSize(); start++) {
+    for(size_t end = start; end < sentence.GetSize() && end - start < maxLength; end++) {
+      std::string phraseString = sentence.GetSubString(Range(start, end)).GetStringRep(m_input);
+      keys.push_back(m_phraseDecoder->MakeSourceKey(phraseString));
+    }
+  }
+
+  m_hash.Prefetch(keys);
+}
+
 void
 PhraseDictionaryCompact::
 CleanUpAfterSentenceProcessing(const InputType &source)
@@ -176,10 +219,7 @@ CleanUpAfterSentenceProcessing(const InputType &source)
   if(!m_sentenceCache.get())
     m_sentenceCache.reset(new PhraseCache());
 
-  m_phraseDecoder->PruneCache();
   m_sentenceCache->clear();
-
-  ReduceCache();
 }
 
 bool PhraseDictionaryCompact::s_inMemoryByDefault = false;
@@ -52,6 +52,10 @@ protected:
   bool m_inMemory;
   bool m_useAlignmentInfo;
 
+  // the target phrases of each source phrase were stored best first, so with
+  // a table limit only the first ones need decoding (parameter best-first)
+  bool m_bestFirst;
+
   typedef std::vector<TargetPhraseCollection::shared_ptr > PhraseCache;
   typedef boost::thread_specific_ptr<PhraseCache> SentenceCache;
   static SentenceCache m_sentenceCache;
@@ -69,12 +73,15 @@ public:
 
   void Load(AllOptions::ptr const& opts);
 
+  void SetParameter(const std::string& key, const std::string& value);
+
   TargetPhraseCollection::shared_ptr  GetTargetPhraseCollectionNonCacheLEGACY(const Phrase &source) const;
   TargetPhraseVectorPtr GetTargetPhraseCollectionRaw(const Phrase &source) const;
 
   void AddEquivPhrase(const Phrase &source, const TargetPhrase &targetPhrase);
 
   void CacheForCleanup(TargetPhraseCollection::shared_ptr  tpc);
+  void InitializeForInput(ttasksptr const& ttask);
   void CleanUpAfterSentenceProcessing(const InputType &source);
   static void SetStaticDefaultParameters(Parameter const& param);
 
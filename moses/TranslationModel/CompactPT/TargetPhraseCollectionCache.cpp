@@ -24,9 +24,26 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 namespace Moses
 {
 
+void TargetPhraseCollectionCache::Cache(const Phrase &sourcePhrase,
+                                        TargetPhraseVectorPtr tpv,
+                                        size_t bitsLeft, size_t maxRank)
+{
+  if(maxRank && tpv->size() > maxRank) {
+    TargetPhraseVectorPtr tpv_temp(new TargetPhraseVector(tpv->begin(),
+                                   tpv->begin() + maxRank));
+    m_phraseCache.Put(sourcePhrase, Entry(tpv_temp, bitsLeft));
+  } else
+    m_phraseCache.Put(sourcePhrase, Entry(tpv, bitsLeft));
+}
 
-boost::thread_specific_ptr<TargetPhraseCollectionCache::CacheMap>
-TargetPhraseCollectionCache::m_phraseCache;
-
+std::pair<TargetPhraseVectorPtr, size_t>
+TargetPhraseCollectionCache::Retrieve(const Phrase &sourcePhrase)
+{
+  Entry entry;
+  if(m_phraseCache.Get(sourcePhrase, entry))
+    return std::make_pair(entry.m_tpv, entry.m_bitsLeft);
+  else
+    return std::make_pair(TargetPhraseVectorPtr(), 0);
 }
 
+}
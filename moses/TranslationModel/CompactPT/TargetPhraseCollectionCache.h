@@ -22,14 +22,12 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_TargetPhraseCollectionCache_h
 #define moses_TargetPhraseCollectionCache_h
 
-#include <map>
-#include <set>
 #include <vector>
 
-#include <boost/thread/tss.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include "moses/Phrase.h"
+#include "moses/ShardedClockCache.h"
 #include "moses/TargetPhraseCollection.h"
 
 namespace Moses
@@ -39,121 +37,51 @@ namespace Moses
 typedef std::vector<TargetPhrase> TargetPhraseVector;
 typedef boost::shared_ptr<TargetPhraseVector> TargetPhraseVectorPtr;
 
-/** Implementation of Persistent Cache **/
+/** Cache of decoded target phrase collections, shared by all threads.
+ *
+ * Each entry remembers how many bits of the encoded collection were left
+ * when decoding stopped (0 if it was decoded completely), so that a later
+ * lookup that needs more target phrases can carry on from there. Cached
+ * collections are read by several threads and must not be modified.
+ */
 class TargetPhraseCollectionCache
 {
 private:
-  size_t m_max;
-  float m_tolerance;
-
-  struct LastUsed {
-    clock_t m_clock;
+  struct Entry {
     TargetPhraseVectorPtr m_tpv;
     size_t m_bitsLeft;
 
-    LastUsed() : m_clock(0), m_bitsLeft(0) {}
+    Entry() : m_bitsLeft(0) {}
 
-    LastUsed(clock_t clock, TargetPhraseVectorPtr tpv, size_t bitsLeft = 0)
-      : m_clock(clock), m_tpv(tpv), m_bitsLeft(bitsLeft) {}
+    Entry(TargetPhraseVectorPtr tpv, size_t bitsLeft)
+      : m_tpv(tpv), m_bitsLeft(bitsLeft) {}
   };
 
-  typedef std::map<Phrase, LastUsed> CacheMap;
-  static boost::thread_specific_ptr<CacheMap> m_phraseCache;
+  ShardedClockCache<Phrase, Entry> m_phraseCache;
 
 public:
 
-  typedef CacheMap::iterator iterator;
-  typedef CacheMap::const_iterator const_iterator;
-
-  TargetPhraseCollectionCache(size_t max = 5000, float tolerance = 0.2)
-    : m_max(max), m_tolerance(tolerance) {
-  }
-
-  iterator Begin() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->begin();
-  }
-
-  const_iterator Begin() const {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->begin();
-  }
-
-  iterator End() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->end();
-  }
-
-  const_iterator End() const {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->end();
+  TargetPhraseCollectionCache(size_t max = 5000)
+    : m_phraseCache(max) {
   }
 
-  /** retrieve translations for source phrase from persistent cache **/
+  /** store translations for source phrase in persistent cache, keeping at
+   *  most maxRank of them **/
   void Cache(const Phrase &sourcePhrase, TargetPhraseVectorPtr tpv,
-             size_t bitsLeft = 0, size_t maxRank = 0) {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    // check if source phrase is already in cache
-    iterator it = m_phraseCache->find(sourcePhrase);
-    if(it != m_phraseCache->end())
-      // if found, just update clock
-      it->second.m_clock = clock();
-    else {
-      // else, add to cache
-      if(maxRank && tpv->size() > maxRank) {
-        TargetPhraseVectorPtr tpv_temp(new TargetPhraseVector());
-        tpv_temp->resize(maxRank);
-        std::copy(tpv->begin(), tpv->begin() + maxRank, tpv_temp->begin());
-        (*m_phraseCache)[sourcePhrase] = LastUsed(clock(), tpv_temp, bitsLeft);
-      } else
-        (*m_phraseCache)[sourcePhrase] = LastUsed(clock(), tpv, bitsLeft);
-    }
-  }
+             size_t bitsLeft = 0, size_t maxRank = 0);
 
-  std::pair<TargetPhraseVectorPtr, size_t> Retrieve(const Phrase &sourcePhrase) {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    iterator it = m_phraseCache->find(sourcePhrase);
-    if(it != m_phraseCache->end()) {
-      LastUsed &lu = it->second;
-      lu.m_clock = clock();
-      return std::make_pair(lu.m_tpv, lu.m_bitsLeft);
-    } else
-      return std::make_pair(TargetPhraseVectorPtr(), 0);
-  }
+  /** retrieve translations for source phrase from persistent cache **/
+  std::pair<TargetPhraseVectorPtr, size_t> Retrieve(const Phrase &sourcePhrase);
 
-  // if cache full, reduce
-  void Prune() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    if(m_phraseCache->size() > m_max * (1 + m_tolerance)) {
-      typedef std::set<std::pair<clock_t, Phrase> > Cands;
-      Cands cands;
-      for(CacheMap::iterator it = m_phraseCache->begin();
-          it != m_phraseCache->end(); it++) {
-        LastUsed &lu = it->second;
-        cands.insert(std::make_pair(lu.m_clock, it->first));
-      }
-
-      for(Cands::iterator it = cands.begin(); it != cands.end(); it++) {
-        const Phrase& p = it->second;
-        m_phraseCache->erase(p);
-
-        if(m_phraseCache->size() < (m_max * (1 - m_tolerance)))
-          break;
-      }
-    }
+  /** whether retrieved translations hold their first n target phrases, or
+   *  all there are **/
+  static bool Covers(const std::pair<TargetPhraseVectorPtr, size_t> &cached,
+                     size_t n) {
+    return cached.second == 0 || cached.first->size() >= n;
   }
 
   void CleanUp() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    m_phraseCache->clear();
+    m_phraseCache.Clear();
   }
 
 };
@@ -0,0 +1,89 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2016 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+#include "TargetPhraseCollectionCache.h"
+#include "moses/TargetPhrase.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+Phrase MakePhrase(const string &text)
+{
+  vector<FactorType> factorOrder(1, 0);
+  Phrase phrase;
+  phrase.CreateFromString(Input, factorOrder, text, NULL);
+  return phrase;
+}
+
+TargetPhraseVectorPtr MakeCollection(size_t size)
+{
+  return TargetPhraseVectorPtr(new TargetPhraseVector(size));
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(target_phrase_collection_cache)
+
+// With best-first and table-limit 2 < max-rank 5, a top level lookup stops
+// after 2 target phrases.  A PREnc subphrase lookup may refer to any rank
+// below 5, so it must not take that collection as it is.
+BOOST_AUTO_TEST_CASE(table_limit_below_max_rank)
+{
+  const size_t tableLimit = 2;
+  const size_t maxRank = 5;
+  TargetPhraseCollectionCache cache;
+  Phrase source = MakePhrase("das haus");
+
+  cache.Cache(source, MakeCollection(tableLimit), 100, maxRank);
+  pair<TargetPhraseVectorPtr, size_t> cached = cache.Retrieve(source);
+  BOOST_REQUIRE(cached.first);
+  BOOST_CHECK_EQUAL(cached.first->size(), tableLimit);
+  BOOST_CHECK_EQUAL(cached.second, 100);
+  BOOST_CHECK(TargetPhraseCollectionCache::Covers(cached, tableLimit));
+  BOOST_CHECK(!TargetPhraseCollectionCache::Covers(cached, maxRank));
+
+  // decoding resumed up to max-rank replaces the short collection
+  cache.Cache(source, MakeCollection(maxRank + 3), 40, maxRank);
+  cached = cache.Retrieve(source);
+  BOOST_REQUIRE(cached.first);
+  BOOST_CHECK_EQUAL(cached.first->size(), maxRank);
+  BOOST_CHECK(TargetPhraseCollectionCache::Covers(cached, maxRank));
+}
+
+BOOST_AUTO_TEST_CASE(complete_collection_covers_any_limit)
+{
+  TargetPhraseCollectionCache cache;
+  Phrase source = MakePhrase("haus");
+  cache.Cache(source, MakeCollection(1), 0, 5);
+  pair<TargetPhraseVectorPtr, size_t> cached = cache.Retrieve(source);
+  BOOST_REQUIRE(cached.first);
+  BOOST_CHECK(TargetPhraseCollectionCache::Covers(cached, 5));
+  BOOST_CHECK(!cache.Retrieve(MakePhrase("das")).first);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -19,7 +19,6 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
-#include <queue>
 #include "moses/TranslationModel/PhraseDictionary.h"
 #include "moses/StaticData.h"
 #include "moses/InputType.h"
@@ -28,6 +27,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/DecodeGraph.h"
 #include "moses/InputPath.h"
 #include "util/exception.hh"
+#include "util/usage.hh"
 
 using namespace std;
 
@@ -39,11 +39,23 @@ PhraseDictionary::PhraseDictionary(const std::string &line, bool registerNow)
   : DecodeFeature(line, registerNow)
   , m_tableLimit(20) // default
   , m_maxCacheSize(DEFAULT_MAX_TRANS_OPT_CACHE_SIZE)
+  , m_maxCacheBytes(0)
+  , m_cache(DEFAULT_MAX_TRANS_OPT_CACHE_SIZE)
 {
   m_id = s_staticColl.size();
   s_staticColl.push_back(this);
 }
 
+PhraseDictionary::~PhraseDictionary()
+{
+  if (m_cache.GetHits() || m_cache.GetMisses()) {
+    VERBOSE(2, GetScoreProducerDescription() << " cache: "
+            << m_cache.GetHits() << " hits, "
+            << m_cache.GetMisses() << " misses, "
+            << m_cache.GetEvictions() << " evictions" << std::endl);
+  }
+}
+
 bool
 PhraseDictionary::
 ProvidesPrefixCheck() const
@@ -56,25 +68,16 @@ PhraseDictionary::
 GetTargetPhraseCollectionLEGACY(const Phrase& src) const
 {
   TargetPhraseCollection::shared_ptr ret;
-  typedef std::pair<TargetPhraseCollection::shared_ptr , clock_t> entry;
   if (m_maxCacheSize) {
-    CacheColl &cache = GetCache();
-
     size_t hash = hash_value(src);
 
-    CacheColl::iterator iter;
-    iter = cache.find(hash);
-
-    if (iter == cache.end()) {
+    if (!m_cache.Get(hash, ret)) {
       // not in cache, need to look up from phrase table
       ret = GetTargetPhraseCollectionNonCacheLEGACY(src);
       if (ret) { // make a copy
         ret.reset(new TargetPhraseCollection(*ret));
       }
-      cache[hash] = entry(ret, clock());
-    } else { // in cache. just use it
-      iter->second.second = clock();
-      ret = iter->second.first;
+      m_cache.Put(hash, ret);
     }
   } else {
     // don't use cache. look up from phrase table
@@ -105,6 +108,11 @@ SetParameter(const std::string& key, const std::string& value)
 {
   if (key == "cache-size") {
     m_maxCacheSize = Scan<size_t>(value);
+    m_cache.SetLimits(m_maxCacheSize, m_maxCacheBytes);
+  } else if (key == "cache-bytes") {
+    // sort -S syntax, e.g. 500M; 0 = limit by number of entries only
+    m_maxCacheBytes = util::ParseSize(value);
+    m_cache.SetLimits(m_maxCacheSize, m_maxCacheBytes);
   } else if (key == "path") {
     m_filePath = value;
   } else if (key == "table-limit") {
@@ -164,53 +172,6 @@ GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
   }
 }
 
-// reduce presistent cache by half of maximum size
-void PhraseDictionary::ReduceCache() const
-{
-  Timer reduceCacheTime;
-  reduceCacheTime.start();
-  CacheColl &cache = GetCache();
-  if (cache.size() <= m_maxCacheSize) return; // not full
-
-  // find cutoff for last used time
-  priority_queue< clock_t > lastUsedTimes;
-  CacheColl::iterator iter;
-  iter = cache.begin();
-  while( iter != cache.end() ) {
-    lastUsedTimes.push( iter->second.second );
-    iter++;
-  }
-  for( size_t i=0; i < lastUsedTimes.size()-m_maxCacheSize/2; i++ )
-    lastUsedTimes.pop();
-  clock_t cutoffLastUsedTime = lastUsedTimes.top();
-
-  // remove all old entries
-  iter = cache.begin();
-  while( iter != cache.end() ) {
-    if (iter->second.second < cutoffLastUsedTime) {
-      CacheColl::iterator iterRemove = iter++;
-      // delete iterRemove->second.first;
-      cache.erase(iterRemove);
-    } else iter++;
-  }
-  VERBOSE(2,"Reduced persistent translation option cache in "
-          << reduceCacheTime << " seconds." << std::endl);
-}
-
-CacheColl &
-PhraseDictionary::
-GetCache() const
-{
-  CacheColl *cache;
-  cache = m_cache.get();
-  if (cache == NULL) {
-    cache = new CacheColl;
-    m_cache.reset(cache);
-  }
-  assert(cache);
-  return *cache;
-}
-
 bool PhraseDictionary::SatisfyBackoff(const InputPath &inputPath) const
 {
   const Phrase &sourcePhrase = inputPath.GetPhrase();
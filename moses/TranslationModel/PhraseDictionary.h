@@ -30,14 +30,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <stdexcept>
 #include <vector>
 #include <string>
-#include <boost/unordered_map.hpp>
-
-#ifdef WITH_THREADS
-#include <boost/thread/tss.hpp>
-#else
-#include <boost/scoped_ptr.hpp>
-#include <ctime>
-#endif
 
 #include "moses/Phrase.h"
 #include "moses/TargetPhrase.h"
@@ -45,6 +37,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/InputPath.h"
 #include "moses/FF/DecodeFeature.h"
 #include "moses/ContextScope.h"
+#include "moses/TranslationModel/PhraseTableCache.h"
 
 namespace Moses
 {
@@ -56,10 +49,6 @@ class ChartCellCollectionBase;
 class ChartRuleLookupManager;
 class ChartParser;
 
-// typedef std::pair<TargetPhraseCollection::shared_ptr, clock_t> TPCollLastUse;
-typedef std::pair<TargetPhraseCollection::shared_ptr, clock_t> CacheCollEntry;
-typedef boost::unordered_map<size_t, CacheCollEntry> CacheColl;
-
 /**
   * Abstract base class for phrase dictionaries (tables).
   **/
@@ -77,8 +66,7 @@ public:
 
   PhraseDictionary(const std::string &line, bool registerNow);
 
-  virtual ~PhraseDictionary() {
-  }
+  virtual ~PhraseDictionary();
 
   //! table limit number.
   size_t GetTableLimit() const {
@@ -168,24 +156,19 @@ protected:
 
   bool SatisfyBackoff(const InputPath &inputPath) const;
 
-  // cache
-  size_t m_maxCacheSize; // 0 = no caching
-
-#ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::thread_specific_ptr<CacheColl> m_cache;
-#else
-  mutable boost::scoped_ptr<CacheColl> m_cache;
-#endif
+  // cache, shared by all decoder threads
+  size_t m_maxCacheSize; // max entries, 0 = no caching
+  size_t m_maxCacheBytes; // 0 = no byte budget
+  mutable PhraseTableCache m_cache;
 
   virtual
   TargetPhraseCollection::shared_ptr
   GetTargetPhraseCollectionNonCacheLEGACY(const Phrase& src) const;
 
-  void ReduceCache() const;
-
 protected:
-  CacheColl &GetCache() const;
+  PhraseTableCache &GetCache() const {
+    return m_cache;
+  }
   size_t m_id;
 
 };
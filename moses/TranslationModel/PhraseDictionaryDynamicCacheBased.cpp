@@ -146,11 +146,6 @@ void PhraseDictionaryDynamicCacheBased::SetParameter(const std::string& key, con
   }
 }
 
-void PhraseDictionaryDynamicCacheBased::InitializeForInput(ttasksptr const& ttask)
-{
-  ReduceCache();
-}
-
 TargetPhraseCollection::shared_ptr PhraseDictionaryDynamicCacheBased::GetTargetPhraseCollection(const Phrase &source) const
 {
 #ifdef WITH_THREADS
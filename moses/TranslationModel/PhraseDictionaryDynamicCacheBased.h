@@ -128,8 +128,6 @@ public:
 
   void SetParameter(const std::string& key, const std::string& value);
 
-  void InitializeForInput(ttasksptr const& ttask);
-
   //  virtual void InitializeForInput(InputType const&) {
   //    /* Don't do anything source specific here as this object is shared between threads.*/
   //  }
@@ -16,9 +16,12 @@ You should have received a copy of the GNU Lesser General Public
 License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
+#include <boost/functional/hash.hpp>
+
 #include "util/exception.hh"
 #include "util/string_stream.hh"
 
+#include "moses/SimdKernels.h"
 #include "moses/TranslationModel/PhraseDictionaryMultiModel.h"
 
 using namespace std;
@@ -27,6 +30,28 @@ namespace Moses
 
 {
 
+namespace
+{
+
+// a target phrase of one component model; sorting these stably brings the
+// entries of all models for the same target phrase together, in the order
+// the models returned them
+struct ComponentPhrase {
+  size_t hash;
+  string key;
+  size_t model;
+  const TargetPhrase *targetPhrase;
+
+  bool operator<(const ComponentPhrase &other) const {
+    if (hash != other.hash) return hash < other.hash;
+    int cmp = key.compare(other.key);
+    if (cmp) return cmp < 0;
+    return model < other.model;
+  }
+};
+
+}
+
 PhraseDictionaryMultiModel::
 PhraseDictionaryMultiModel(const std::string &line)
   : PhraseDictionary(line, true)
@@ -103,16 +128,119 @@ GetTargetPhraseCollectionLEGACY(const Phrase& src) const
   multimodelweights = getWeights(m_numScoreComponents, true);
   TargetPhraseCollection::shared_ptr ret;
 
-  std::map<std::string, multiModelStats*>* allStats;
-  allStats = new(std::map<std::string,multiModelStats*>);
-  CollectSufficientStatistics(src, allStats);
-  ret = CreateTargetPhraseCollectionLinearInterpolation(src, allStats, multimodelweights);
-  RemoveAllInMap(*allStats);
-  delete allStats; // ??? Why the detour through malloc? UG
+  // the interpolated collection only depends on the source phrase and the
+  // weights, so it is shared between sentences using the same weights
+  size_t cacheKey = MakeCacheKey(src, multimodelweights);
+  if (m_maxCacheSize && GetCache().Get(cacheKey, ret)) {
+    return ret;
+  }
+
+  ret = MergeComponentCollections(src, multimodelweights);
 
   ret->NthElement(m_tableLimit); // sort the phrases for pruning later
-  const_cast<PhraseDictionaryMultiModel*>(this)->CacheForCleanup(ret);
+  if (m_maxCacheSize) {
+    GetCache().Put(cacheKey, ret);
+  } else {
+    const_cast<PhraseDictionaryMultiModel*>(this)->CacheForCleanup(ret);
+  }
+
+  return ret;
+}
+
+size_t
+PhraseDictionaryMultiModel::
+MakeCacheKey(const Phrase& src,
+             const std::vector<std::vector<float> > &multimodelweights) const
+{
+  size_t seed = hash_value(src);
+  for (size_t i = 0; i < multimodelweights.size(); ++i) {
+    boost::hash_range(seed, multimodelweights[i].begin(), multimodelweights[i].end());
+  }
+  return seed;
+}
+
+TargetPhraseCollection::shared_ptr
+PhraseDictionaryMultiModel::
+MergeComponentCollections
+( const Phrase& src,
+  const std::vector<std::vector<float> > &multimodelweights) const
+{
+  // same as CollectSufficientStatistics() followed by
+  // CreateTargetPhraseCollectionLinearInterpolation(), but the target phrases
+  // of the components are sorted and merged instead of collected in a map,
+  // and each score is interpolated with one vectorized inner product over
+  // the models
+  std::vector<TargetPhraseCollection::shared_ptr> components(m_numModels);
+  std::vector<ComponentPhrase> phrases;
+  for(size_t i = 0; i < m_numModels; ++i) {
+    components[i] = m_pd[i]->GetTargetPhraseCollectionLEGACY(src);
+    if (components[i] == NULL) continue;
+
+    TargetPhraseCollection::const_iterator iterTargetPhrase, iterLast;
+    if (m_tableLimit != 0 && components[i]->GetSize() > m_tableLimit) {
+      iterLast = components[i]->begin() + m_tableLimit;
+    } else {
+      iterLast = components[i]->end();
+    }
+    for (iterTargetPhrase = components[i]->begin(); iterTargetPhrase != iterLast;  ++iterTargetPhrase) {
+      ComponentPhrase phrase;
+      phrase.key = (*iterTargetPhrase)->GetStringRep(m_output);
+      phrase.hash = boost::hash_value(phrase.key);
+      phrase.model = i;
+      phrase.targetPhrase = *iterTargetPhrase;
+      phrases.push_back(phrase);
+    }
+  }
+  std::stable_sort(phrases.begin(), phrases.end());
+
+  // weights and probabilities of one score are contiguous, one per model
+  const size_t numModels = m_numModels;
+  std::vector<float> weights(m_numScoreComponents * numModels);
+  for(size_t j = 0; j < m_numScoreComponents; ++j) {
+    std::copy(multimodelweights[j].begin(), multimodelweights[j].end(),
+              weights.begin() + j * numModels);
+  }
+  std::vector<float> p(m_numScoreComponents * numModels);
+  Scores scoreVector(m_numScoreComponents);
+
+  vector<FeatureFunction*> this_feature;
+  this_feature.push_back(const_cast<PhraseDictionaryMultiModel*>(this));
+  const vector<FeatureFunction*> this_feature_const(this_feature);
 
+  TargetPhraseCollection::shared_ptr ret(new TargetPhraseCollection);
+  for (size_t first = 0, last; first < phrases.size(); first = last) {
+    std::fill(p.begin(), p.end(), 0.0f);
+    for (last = first; last < phrases.size()
+         && phrases[last].hash == phrases[first].hash
+         && phrases[last].key == phrases[first].key; ++last) {
+      const ComponentPhrase &phrase = phrases[last];
+      const PhraseDictionary &pd = *m_pd[phrase.model];
+      std::vector<float> raw_scores = phrase.targetPhrase->GetScoreBreakdown().GetScoresForProducer(&pd);
+      for(size_t j = 0; j < m_numScoreComponents; ++j) {
+        p[j * numModels + phrase.model] = UntransformScore(raw_scores[j]);
+      }
+    }
+
+    for(size_t j = 0; j < m_numScoreComponents; ++j) {
+      scoreVector[j] = TransformScore(simd::InnerProduct(&p[j * numModels], &weights[j * numModels], numModels));
+    }
+
+    // take the target phrase from the first model that has it, minus the
+    // scores of that model, as CollectSufficientStatistics() does
+    const ComponentPhrase &phrase = phrases[first];
+    PhraseDictionary *pd = m_pd[phrase.model];
+    TargetPhrase *targetPhrase = new TargetPhrase(*phrase.targetPhrase);
+    targetPhrase->GetScoreBreakdown().InvertDenseFeatures(pd);
+    vector<FeatureFunction*> pd_feature;
+    pd_feature.push_back(pd);
+    const vector<FeatureFunction*> pd_feature_const(pd_feature);
+    targetPhrase->EvaluateInIsolation(src, pd_feature_const);
+    targetPhrase->GetScoreBreakdown().ZeroDenseFeatures(pd);
+
+    targetPhrase->GetScoreBreakdown().Assign(this, scoreVector);
+    targetPhrase->EvaluateInIsolation(src, this_feature_const);
+    ret->Add(targetPhrase);
+  }
   return ret;
 }
 
@@ -204,7 +332,6 @@ CreateTargetPhraseCollectionLinearInterpolation
   return ret;
 }
 
-//TODO: is it worth caching the results as long as weights don't change?
 std::vector<std::vector<float> >
 PhraseDictionaryMultiModel::
 getWeights(size_t numWeights, bool normalize) const
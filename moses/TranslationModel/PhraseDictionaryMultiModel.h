@@ -82,6 +82,11 @@ public:
   (const Phrase& src, std::map<std::string,multiModelStats*>* allStats,
    std::vector<std::vector<float> > &multimodelweights) const;
 
+  TargetPhraseCollection::shared_ptr
+  MergeComponentCollections
+  (const Phrase& src,
+   const std::vector<std::vector<float> > &multimodelweights) const;
+
   std::vector<std::vector<float> >
   getWeights(size_t numWeights, bool normalize) const;
 
@@ -126,6 +131,11 @@ public:
   SetTemporaryMultiModelWeightsVector(std::vector<float> weights);
 
 protected:
+  //! key of the interpolated collection for src in the phrase table cache
+  size_t
+  MakeCacheKey(const Phrase& src,
+               const std::vector<std::vector<float> > &multimodelweights) const;
+
   std::string m_mode;
   std::vector<std::string> m_pdStr;
   std::vector<PhraseDictionary*> m_pd;
@@ -128,6 +128,12 @@ TargetPhraseCollection::shared_ptr PhraseDictionaryMultiModelCounts::GetTargetPh
   normalize = (m_mode == "interpolate") ? true : false;
   multimodelweights = getWeights(4,normalize);
 
+  size_t cacheKey = MakeCacheKey(src, multimodelweights);
+  TargetPhraseCollection::shared_ptr ret;
+  if (m_maxCacheSize && GetCache().Get(cacheKey, ret)) {
+    return ret;
+  }
+
   //source phrase frequency is shared among all phrase pairs
   vector<float> fs(m_numModels);
 
@@ -135,11 +141,14 @@ TargetPhraseCollection::shared_ptr PhraseDictionaryMultiModelCounts::GetTargetPh
 
   CollectSufficientStats(src, fs, allStats);
 
-  TargetPhraseCollection::shared_ptr ret
-  = CreateTargetPhraseCollectionCounts(src, fs, allStats, multimodelweights);
+  ret = CreateTargetPhraseCollectionCounts(src, fs, allStats, multimodelweights);
 
   ret->NthElement(m_tableLimit); // sort the phrases for pruning later
-  const_cast<PhraseDictionaryMultiModelCounts*>(this)->CacheForCleanup(ret);
+  if (m_maxCacheSize) {
+    GetCache().Put(cacheKey, ret);
+  } else {
+    const_cast<PhraseDictionaryMultiModelCounts*>(this)->CacheForCleanup(ret);
+  }
   return ret;
 }
 
@@ -28,11 +28,6 @@ void PhraseDictionaryTransliteration::Load(AllOptions::ptr const& opts)
   SetFeaturesToApply();
 }
 
-void PhraseDictionaryTransliteration::CleanUpAfterSentenceProcessing(const InputType& source)
-{
-  ReduceCache();
-}
-
 void PhraseDictionaryTransliteration::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
 {
 
@@ -62,15 +57,12 @@ GetTargetPhraseCollection(InputPath &inputPath) const
   const Phrase &sourcePhrase = inputPath.GetPhrase();
   size_t hash = hash_value(sourcePhrase);
 
-  CacheColl &cache = GetCache();
+  PhraseTableCache &cache = GetCache();
 
-  CacheColl::iterator iter;
-  iter = cache.find(hash);
-
-  if (iter != cache.end()) {
+  TargetPhraseCollection::shared_ptr cached;
+  if (cache.Get(hash, cached)) {
     // already in cache
-    TargetPhraseCollection::shared_ptr tpColl = iter->second.first;
-    inputPath.SetTargetPhrases(*this, tpColl, NULL);
+    inputPath.SetTargetPhrases(*this, cached, NULL);
   } else {
     // TRANSLITERATE
     const util::temp_file inFile;
@@ -100,7 +92,7 @@ GetTargetPhraseCollection(InputPath &inputPath) const
       TargetPhrase *tp = *iter;
       tpColl->Add(tp);
     }
-    cache[hash] = CacheCollEntry(tpColl, clock());
+    cache.Put(hash, tpColl);
     inputPath.SetTargetPhrases(*this, tpColl, NULL);
   }
 }
@@ -20,7 +20,6 @@ public:
 
   void Load(AllOptions::ptr const& opts);
 
-  virtual void CleanUpAfterSentenceProcessing(const InputType& source);
 
   // for phrase-based model
   void GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const;
@@ -48,8 +48,6 @@ void PhraseDictionaryTreeAdaptor::InitializeForInput(ttasksptr const& ttask)
   InputType const& source = *ttask->GetSource();
   const StaticData &staticData = StaticData::Instance();
 
-  ReduceCache();
-
   PDTAimp *obj = new PDTAimp(this);
 
   vector<float> weight = staticData.GetWeights(this);
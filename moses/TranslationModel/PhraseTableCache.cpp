@@ -0,0 +1,23 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#include "PhraseTableCache.h"
+#include "moses/TargetPhrase.h"
+
+namespace Moses
+{
+
+size_t TargetPhraseCollectionBytes::operator()(
+  TargetPhraseCollection::shared_ptr const& tpc) const
+{
+  if (!tpc) return 0;
+  size_t ret = sizeof(TargetPhraseCollection);
+  TargetPhraseCollection::const_iterator iter;
+  for (iter = tpc->begin(); iter != tpc->end(); ++iter) {
+    const TargetPhrase &tp = **iter;
+    ret += sizeof(void*) + sizeof(TargetPhrase)
+           + tp.GetSize() * sizeof(Word)
+           + tp.GetScoreBreakdown().Size() * sizeof(float);
+  }
+  return ret;
+}
+
+}
@@ -0,0 +1,34 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#pragma once
+
+#include "moses/ShardedClockCache.h"
+#include "moses/TargetPhraseCollection.h"
+
+namespace Moses
+{
+
+//! rough memory footprint of a collection, as charged against the byte budget
+struct TargetPhraseCollectionBytes {
+  size_t operator()(TargetPhraseCollection::shared_ptr const& tpc) const;
+};
+
+/** Cache of target phrase collections shared by all decoder threads.
+ *
+ * Keys are phrase hashes (or any other size_t the phrase table chooses).
+ * A hit may yield a null collection: phrase tables also cache phrases they
+ * have no entry for. Cached collections are shared between threads and must
+ * not be modified after they are added.
+ */
+class PhraseTableCache
+  : public ShardedClockCache<size_t, TargetPhraseCollection::shared_ptr,
+    TargetPhraseCollectionBytes>
+{
+public:
+  //! maxEntries of 0 disables caching, maxBytes of 0 means no byte budget
+  PhraseTableCache(size_t maxEntries, size_t maxBytes = 0)
+    : ShardedClockCache<size_t, TargetPhraseCollection::shared_ptr,
+      TargetPhraseCollectionBytes>(maxEntries, maxBytes) {
+  }
+};
+
+}
@@ -0,0 +1,77 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2016- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include "PhraseTableCache.h"
+
+using namespace Moses;
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(phrase_table_cache)
+
+BOOST_AUTO_TEST_CASE(stores_and_evicts)
+{
+  PhraseTableCache cache(64);
+  TargetPhraseCollection::shared_ptr tpc(new TargetPhraseCollection);
+  TargetPhraseCollection::shared_ptr out;
+  BOOST_CHECK(!cache.Get(1, out));
+  cache.Put(1, tpc);
+  BOOST_CHECK(cache.Get(1, out));
+  BOOST_CHECK(out == tpc);
+
+  // one entry per shard
+  for (size_t key = 2; key < 1000; ++key) {
+    cache.Put(key, tpc);
+  }
+  size_t cached = 0;
+  for (size_t key = 1; key < 1000; ++key) {
+    cached += cache.Get(key, out);
+  }
+  BOOST_CHECK(cached <= 64);
+  BOOST_CHECK_EQUAL(cache.GetEvictions(), 999 - cached);
+}
+
+// cache-size=0 turns the cache off
+BOOST_AUTO_TEST_CASE(zero_size_stores_nothing)
+{
+  PhraseTableCache cache(0);
+  TargetPhraseCollection::shared_ptr tpc(new TargetPhraseCollection);
+  TargetPhraseCollection::shared_ptr out;
+  for (size_t key = 0; key < 1000; ++key) {
+    cache.Put(key, tpc);
+  }
+  for (size_t key = 0; key < 1000; ++key) {
+    BOOST_CHECK(!cache.Get(key, out));
+  }
+  BOOST_CHECK(!out);
+  BOOST_CHECK(tpc.unique());
+
+  // and so does setting it to 0 later
+  PhraseTableCache limited(100);
+  limited.Put(1, tpc);
+  BOOST_CHECK(!tpc.unique());
+  limited.SetLimits(0, 0);
+  BOOST_CHECK(tpc.unique());
+  limited.Put(1, tpc);
+  BOOST_CHECK(!limited.Get(1, out));
+  BOOST_CHECK(tpc.unique());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
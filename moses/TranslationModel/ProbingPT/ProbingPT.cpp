@@ -6,6 +6,8 @@
 #include "moses/TranslationModel/CYKPlusParser/ChartRuleLookupManagerSkeleton.h"
 #include "quering.hh"
 
+#include <boost/unordered_map.hpp>
+
 using namespace std;
 
 namespace Moses
@@ -63,14 +65,18 @@ void ProbingPT::Load(AllOptions::ptr const& opts)
   }
 }
 
-void ProbingPT::InitializeForInput(ttasksptr const& ttask)
-{
-  ReduceCache();
-}
-
 void ProbingPT::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
 {
-  CacheColl &cache = GetCache();
+  PhraseTableCache &cache = GetCache();
+
+  // phrases not in the cache are looked up together, so that the probes into the
+  // mmapped hash table and target phrases are prefetched before any is read
+  std::vector<InputPath*> paths;
+  std::vector<size_t> pathKeys;
+  std::vector<const Phrase*> keyPhrases;
+  std::vector<size_t> keyHashes;
+  std::vector<uint64_t> keys;
+  boost::unordered_map<size_t, size_t> keyIndex;
 
   InputPathList::const_iterator iter;
   for (iter = inputPathQueue.begin(); iter != inputPathQueue.end(); ++iter) {
@@ -81,14 +87,49 @@ void ProbingPT::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQue
       continue;
     }
 
-    TargetPhraseCollection::shared_ptr tpColl = CreateTargetPhrase(sourcePhrase);
-
-    // add target phrase to phrase-table cache
     size_t hash = hash_value(sourcePhrase);
-    std::pair<TargetPhraseCollection::shared_ptr , clock_t> value(tpColl, clock());
-    cache[hash] = value;
+    TargetPhraseCollection::shared_ptr tpColl;
+    if (cache.Get(hash, tpColl)) {
+      inputPath.SetTargetPhrases(*this, tpColl, NULL);
+      continue;
+    }
+
+    bool ok;
+    vector<uint64_t> probingSource = ConvertToProbingSourcePhrase(sourcePhrase, ok);
+    if (!ok) {
+      // source phrase contains a word unknown in the pt.
+      // We know immediately there's no translation for it
+      cache.Put(hash, tpColl);
+      inputPath.SetTargetPhrases(*this, tpColl, NULL);
+      continue;
+    }
 
-    inputPath.SetTargetPhrases(*this, tpColl, NULL);
+    std::pair<boost::unordered_map<size_t, size_t>::iterator, bool> inserted
+      = keyIndex.insert(std::make_pair(hash, keys.size()));
+    if (inserted.second) {
+      keyPhrases.push_back(&sourcePhrase);
+      keyHashes.push_back(hash);
+      keys.push_back(QueryEngine::getKey(probingSource));
+    }
+    paths.push_back(&inputPath);
+    pathKeys.push_back(inserted.first->second);
+  }
+
+  std::vector<const Entry*> entries;
+  m_engine->findBatch(keys, entries);
+
+  // decoded target phrases of the sentence, reused from one source phrase to the next
+  std::vector<target_text> probingTargetPhrases;
+  std::vector<TargetPhraseCollection::shared_ptr> tpColls(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (entries[i]) {
+      tpColls[i] = CreateTargetPhrase(*keyPhrases[i], *entries[i], probingTargetPhrases);
+    }
+    cache.Put(keyHashes[i], tpColls[i]);
+  }
+
+  for (size_t i = 0; i < paths.size(); ++i) {
+    paths[i]->SetTargetPhrases(*this, tpColls[pathKeys[i]], NULL);
   }
 }
 
@@ -111,40 +152,18 @@ std::vector<uint64_t> ProbingPT::ConvertToProbingSourcePhrase(const Phrase &sour
   return ret;
 }
 
-TargetPhraseCollection::shared_ptr ProbingPT::CreateTargetPhrase(const Phrase &sourcePhrase) const
+TargetPhraseCollection::shared_ptr ProbingPT::CreateTargetPhrase(const Phrase &sourcePhrase, const Entry &entry,
+    std::vector<target_text> &probingTargetPhrases) const
 {
-  // create a target phrase from the 1st word of the source, prefix with 'ProbingPT:'
-  assert(sourcePhrase.GetSize());
-
-  TargetPhraseCollection::shared_ptr tpColl;
-  bool ok;
-  vector<uint64_t> probingSource = ConvertToProbingSourcePhrase(sourcePhrase, ok);
-  if (!ok) {
-    // source phrase contains a word unknown in the pt.
-    // We know immediately there's no translation for it
-    return tpColl;
-  }
-
-  std::pair<bool, std::vector<target_text> > query_result;
-
-  //Actual lookup
-  query_result = m_engine->query(probingSource);
-
-  if (query_result.first) {
-    //m_engine->printTargetInfo(query_result.second);
-    tpColl.reset(new TargetPhraseCollection());
-
-    const std::vector<target_text> &probingTargetPhrases = query_result.second;
-    for (size_t i = 0; i < probingTargetPhrases.size(); ++i) {
-      const target_text &probingTargetPhrase = probingTargetPhrases[i];
-      TargetPhrase *tp = CreateTargetPhrase(sourcePhrase, probingTargetPhrase);
-
-      tpColl->Add(tp);
-    }
+  TargetPhraseCollection::shared_ptr tpColl(new TargetPhraseCollection());
 
-    tpColl->Prune(true, m_tableLimit);
+  size_t numTargetPhrases = m_engine->decode(entry, probingTargetPhrases);
+  for (size_t i = 0; i < numTargetPhrases; ++i) {
+    TargetPhrase *tp = CreateTargetPhrase(sourcePhrase, probingTargetPhrases[i]);
+    tpColl->Add(tp);
   }
 
+  tpColl->Prune(true, m_tableLimit);
   return tpColl;
 }
 
@@ -6,6 +6,7 @@
 
 class QueryEngine;
 class target_text;
+struct Entry;
 
 namespace Moses
 {
@@ -23,7 +24,6 @@ public:
 
   void Load(AllOptions::ptr const& opts);
 
-  void InitializeForInput(ttasksptr const& ttask);
 
   // for phrase-based model
   void GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const;
@@ -46,7 +46,8 @@ protected:
   typedef boost::bimap<const Factor *, unsigned int> TargetVocabMap;
   mutable TargetVocabMap m_vocabMap;
 
-  TargetPhraseCollection::shared_ptr CreateTargetPhrase(const Phrase &sourcePhrase) const;
+  TargetPhraseCollection::shared_ptr CreateTargetPhrase(const Phrase &sourcePhrase, const Entry &entry,
+      std::vector<target_text> &probingTargetPhrases) const;
   TargetPhrase *CreateTargetPhrase(const Phrase &sourcePhrase, const target_text &probingTargetPhrase) const;
   const Factor *GetTargetFactor(uint64_t probingId) const;
   uint64_t GetSourceProbingId(const Factor *factor) const;
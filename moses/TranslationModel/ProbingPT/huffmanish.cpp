@@ -1,5 +1,9 @@
 #include "huffmanish.hh"
 
+Huffman::Huffman () : uniq_lines(0)
+{
+}
+
 Huffman::Huffman (const char * filepath)
 {
   //Read the file
@@ -8,7 +12,7 @@ Huffman::Huffman (const char * filepath)
   //Init uniq_lines to zero;
   uniq_lines = 0;
 
-  line_text prev_line; //Check for unique lines.
+  std::string prev_source; //Check for unique lines. A copy, as FilePiece may unmap the line.
   int num_lines = 0 ;
 
   while (true) {
@@ -26,11 +30,11 @@ Huffman::Huffman (const char * filepath)
       break;
     }
 
-    if (new_line.source_phrase == prev_line.source_phrase) {
+    if (new_line.source_phrase == StringPiece(prev_source)) {
       continue;
     } else {
       uniq_lines++;
-      prev_line = new_line;
+      prev_source = new_line.source_phrase.as_string();
     }
   }
 
@@ -71,6 +75,16 @@ void Huffman::count_elements(line_text linein)
 
 }
 
+void Huffman::add_counts(const Huffman &other)
+{
+  for(std::map<std::string, unsigned int>::const_iterator it = other.target_phrase_words.begin(); it != other.target_phrase_words.end(); it++ ) {
+    target_phrase_words[it->first] += it->second;
+  }
+  for(std::map<std::vector<unsigned char>, unsigned int>::const_iterator it = other.word_all1.begin(); it != other.word_all1.end(); it++ ) {
+    word_all1[it->first] += it->second;
+  }
+}
+
 //Assigns huffman values for each unique element
 void Huffman::assign_values()
 {
@@ -138,12 +152,12 @@ void Huffman::serialize_maps(const char * dirname)
   os2.close();
 }
 
-std::vector<unsigned char> Huffman::full_encode_line(line_text line)
+std::vector<unsigned char> Huffman::full_encode_line(line_text line) const
 {
   return vbyte_encode_line((encode_line(line)));
 }
 
-std::vector<unsigned int> Huffman::encode_line(line_text line)
+std::vector<unsigned int> Huffman::encode_line(line_text line) const
 {
   std::vector<unsigned int> retvector;
 
@@ -263,6 +277,50 @@ std::vector<target_text> HuffmanDecoder::full_decode_line (std::vector<unsigned
 
 }
 
+//Decodes the variable byte number at data and moves data past it.
+static inline unsigned int vbyte_decode(const unsigned char *&data)
+{
+  unsigned int num = 0;
+  unsigned char shift = 0;
+  do {
+    num |= (*data & 0x7f) << shift;
+    shift += 7;
+  } while (*data++ >> 7);
+  return num;
+}
+
+size_t HuffmanDecoder::decode_entry (const unsigned char * data, size_t size, int num_scores, std::vector<target_text> &out) const
+{
+  const unsigned char * end = data + size;
+  size_t count = 0;
+  while (data != end) {
+    if (count == out.size()) {
+      out.resize(count + 1);
+    }
+    target_text &target = out[count++];
+
+    //Target words up to the first zero
+    target.target_phrase.clear();
+    for (unsigned int num = vbyte_decode(data); num; num = vbyte_decode(data)) {
+      target.target_phrase.push_back(num);
+    }
+
+    //Exactly num_scores scores, which may be zero, then a zero
+    target.prob.clear();
+    for (int i = 0; i < num_scores; i++) {
+      unsigned int num = vbyte_decode(data);
+      target.prob.push_back(reinterpret_uint(&num));
+    }
+    vbyte_decode(data);
+
+    //Word alignment, then a zero
+    unsigned int wAll = vbyte_decode(data);
+    vbyte_decode(data);
+    target.word_all1 = lookup_word_all1.find(wAll)->second;
+  }
+  return count;
+}
+
 target_text HuffmanDecoder::decode_line (std::vector<unsigned int> input, int num_scores)
 {
   //demo decoder
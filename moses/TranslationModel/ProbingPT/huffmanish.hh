@@ -47,16 +47,18 @@ class Huffman
   std::map<unsigned int, std::vector<unsigned char> > lookup_word_all1;
 
 public:
+  Huffman ();
   Huffman (const char *);
   void count_elements (line_text line);
+  void add_counts (const Huffman &other); //Merge the counts of another (partial) counter
   void assign_values();
   void serialize_maps(const char * dirname);
   void produce_lookups();
 
-  std::vector<unsigned int> encode_line(line_text line);
+  std::vector<unsigned int> encode_line(line_text line) const;
 
   //encode line + variable byte ontop
-  std::vector<unsigned char> full_encode_line(line_text line);
+  std::vector<unsigned char> full_encode_line(line_text line) const;
 
   //Getters
   const std::map<unsigned int, std::string> get_target_lookup_map() const {
@@ -69,6 +71,9 @@ public:
   unsigned long getUniqLines() {
     return uniq_lines;
   }
+  void setUniqLines(unsigned long lines) {
+    uniq_lines = lines;
+  }
 };
 
 class HuffmanDecoder
@@ -96,6 +101,10 @@ public:
 
   //Variable byte decodes a all target phrases contained here and then passes them to decode_line
   std::vector<target_text> full_decode_line (std::vector<unsigned char> lines, int num_scores);
+
+  //Same as full_decode_line, but straight from the binary file and into the elements of
+  //out, whose vectors are reused. Returns the number of target phrases decoded.
+  size_t decode_entry (const unsigned char * data, size_t size, int num_scores, std::vector<target_text> &out) const;
 };
 
 std::string getTargetWordsFromIDs(std::vector<unsigned int> ids, std::map<unsigned int, std::string> * lookup_target_phrase);
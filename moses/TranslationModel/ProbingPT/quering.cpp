@@ -1,4 +1,33 @@
 #include "quering.hh"
+#include "util/mmap.hh"
+
+namespace
+{
+
+//Pages [first, second) holding a region of a mapped file.
+typedef std::pair<uintptr_t, uintptr_t> PageRange;
+
+PageRange pageRange(const void *start, size_t length)
+{
+  const uintptr_t page = util::SizePage();
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(start);
+  return PageRange(begin & ~(page - 1), (begin + length + page - 1) & ~(page - 1));
+}
+
+//Merges overlapping and adjacent page ranges, so that every page is asked
+//for once, with one madvise call per merged range.
+void adviseWillNeed(std::vector<PageRange> &pages)
+{
+  std::sort(pages.begin(), pages.end());
+  for (size_t i = 0; i < pages.size(); ) {
+    uintptr_t begin = pages[i].first, end = pages[i].second;
+    for (i++; i < pages.size() && pages[i].first <= end; i++)
+      end = std::max(end, pages[i].second);
+    util::AdviseWillNeed(reinterpret_cast<const void *>(begin), end - begin);
+  }
+}
+
+}
 
 unsigned char * read_binary_file(const char * filename, size_t filesize)
 {
@@ -86,46 +115,6 @@ QueryEngine::~QueryEngine()
 
 }
 
-std::pair<bool, std::vector<target_text> > QueryEngine::query(std::vector<uint64_t> source_phrase)
-{
-  bool found;
-  std::vector<target_text> translation_entries;
-  const Entry * entry;
-  //TOO SLOW
-  //uint64_t key = util::MurmurHashNative(&source_phrase[0], source_phrase.size());
-  uint64_t key = 0;
-  for (int i = 0; i < source_phrase.size(); i++) {
-    key += (source_phrase[i] << i);
-  }
-
-
-  found = table.Find(key, entry);
-
-  if (found) {
-    //The phrase that was searched for was found! We need to get the translation entries.
-    //We will read the largest entry in bytes and then filter the unnecesarry with functions
-    //from line_splitter
-    uint64_t initial_index = entry -> GetValue();
-    unsigned int bytes_toread = entry -> bytes_toread;
-
-    //ASK HIEU FOR MORE EFFICIENT WAY TO DO THIS!
-    std::vector<unsigned char> encoded_text; //Assign to the vector the relevant portion of the array.
-    encoded_text.reserve(bytes_toread);
-    for (int i = 0; i < bytes_toread; i++) {
-      encoded_text.push_back(binary_mmaped[i+initial_index]);
-    }
-
-    //Get only the translation entries necessary
-    translation_entries = decoder.full_decode_line(encoded_text, num_scores);
-
-  }
-
-  std::pair<bool, std::vector<target_text> > output (found, translation_entries);
-
-  return output;
-
-}
-
 std::pair<bool, std::vector<target_text> > QueryEngine::query(StringPiece source_phrase)
 {
   bool found;
@@ -170,6 +159,49 @@ std::pair<bool, std::vector<target_text> > QueryEngine::query(StringPiece source
 
 }
 
+uint64_t QueryEngine::getKey(const std::vector<uint64_t> &source_phrase)
+{
+  uint64_t key = 0;
+  for (size_t i = 0; i < source_phrase.size(); i++) {
+    key += (source_phrase[i] << i);
+  }
+  return key;
+}
+
+void QueryEngine::findBatch(const std::vector<uint64_t> &keys, std::vector<const Entry *> &entries) const
+{
+  //madvise starts reading the pages that are not in memory yet, the prefetch
+  //brings resident ones into the cache.
+  std::vector<PageRange> pages;
+  pages.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    const Entry *bucket = &*table.Ideal(keys[i]);
+    pages.push_back(pageRange(bucket, sizeof(Entry)));
+    __builtin_prefetch(bucket, 0, 1);
+  }
+  adviseWillNeed(pages);
+
+  pages.clear();
+  entries.resize(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    const Entry *entry;
+    if (table.Find(keys[i], entry)) {
+      const unsigned char *targets = binary_mmaped + entry->GetValue();
+      pages.push_back(pageRange(targets, entry->bytes_toread));
+      __builtin_prefetch(targets, 0, 1);
+      entries[i] = entry;
+    } else {
+      entries[i] = NULL;
+    }
+  }
+  adviseWillNeed(pages);
+}
+
+size_t QueryEngine::decode(const Entry &entry, std::vector<target_text> &targets) const
+{
+  return decoder.decode_entry(binary_mmaped + entry.GetValue(), entry.bytes_toread, num_scores, targets);
+}
+
 void QueryEngine::printTargetInfo(std::vector<target_text> target_phrases)
 {
   int entries = target_phrases.size();
@@ -30,7 +30,16 @@ public:
   QueryEngine (const char *);
   ~QueryEngine();
   std::pair<bool, std::vector<target_text> > query(StringPiece source_phrase);
-  std::pair<bool, std::vector<target_text> > query(std::vector<uint64_t> source_phrase);
+
+  //Batch lookups. findBatch prefetches the hash table buckets of all keys before probing
+  //any of them, and the target phrases of all hits before returning, with one madvise
+  //per run of neighbouring pages. entries[i] is the
+  //entry of keys[i], or NULL if it is not in the table.
+  static uint64_t getKey(const std::vector<uint64_t> &source_phrase);
+  void findBatch(const std::vector<uint64_t> &keys, std::vector<const Entry *> &entries) const;
+  //Decodes the target phrases of an entry into targets, reusing its elements. Returns their number.
+  size_t decode(const Entry &entry, std::vector<target_text> &targets) const;
+
   void printTargetInfo(std::vector<target_text> target_phrases);
   const std::map<unsigned int, std::string> getVocab() const {
     return decoder.get_target_lookup_map();
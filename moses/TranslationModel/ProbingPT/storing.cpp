@@ -1,5 +1,13 @@
 #include "storing.hh"
 
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "util/stream/chain.hh"
+#include "util/stream/line_input.hh"
+
 BinaryFileWriter::BinaryFileWriter (std::string basepath) : os ((basepath + "/binfile.dat").c_str(), std::ios::binary)
 {
   binfile.reserve(10000); //Reserve part of the vector to avoid realocation
@@ -38,6 +46,30 @@ BinaryFileWriter::~BinaryFileWriter ()
   binfile.clear();
 }
 
+//The key is the sum of hashes of individual words bitshifted by their position in the phrase.
+//Probably not entirerly correct, but fast and seems to work fine in practise.
+static uint64_t getSourceKey(StringPiece source_phrase)
+{
+  uint64_t key = 0;
+  std::vector<uint64_t> vocabid_source = getVocabIDs(source_phrase);
+  for (size_t i = 0; i < vocabid_source.size(); i++) {
+    key += (vocabid_source[i] << i);
+  }
+  return key;
+}
+
+static void writeConfig(const std::string &basepath, unsigned long uniq_entries,
+                        const char * num_scores, const char * is_reordering)
+{
+  std::ofstream configfile;
+  configfile.open((basepath + "/config").c_str());
+  configfile << API_VERSION << '\n';
+  configfile << uniq_entries << '\n';
+  configfile << num_scores << '\n';
+  configfile << is_reordering << '\n';
+  configfile.close();
+}
+
 void createProbingPT(const char * phrasetable_path, const char * target_path,
                      const char * num_scores, const char * is_reordering)
 {
@@ -68,7 +100,8 @@ void createProbingPT(const char * phrasetable_path, const char * target_path,
 
   BinaryFileWriter binfile(basepath); //Init the binary file writer.
 
-  line_text prev_line; //Check if the source phrase of the previous line is the same
+  //Check if the source phrase of the previous line is the same. A copy, as FilePiece may unmap the line.
+  std::string prev_source;
 
   //Keep track of the size of each group of target phrases
   uint64_t entrystartidx = 0;
@@ -85,23 +118,17 @@ void createProbingPT(const char * phrasetable_path, const char * target_path,
       add_to_map(&source_vocabids, line.source_phrase);
 
       if ((binfile.dist_from_start + binfile.extra_counter) == 0) {
-        prev_line = line; //For the first iteration assume the previous line is
+        prev_source = line.source_phrase.as_string(); //For the first iteration assume the previous line is
       } //The same as this one.
 
-      if (line.source_phrase != prev_line.source_phrase) {
+      if (line.source_phrase != StringPiece(prev_source)) {
 
         //Create a new entry even
 
         //Create an entry for the previous source phrase:
-        Entry pesho;
+        Entry pesho = Entry();
         pesho.value = entrystartidx;
-        //The key is the sum of hashes of individual words bitshifted by their position in the phrase.
-        //Probably not entirerly correct, but fast and seems to work fine in practise.
-        pesho.key = 0;
-        std::vector<uint64_t> vocabid_source = getVocabIDs(prev_line.source_phrase);
-        for (int i = 0; i < vocabid_source.size(); i++) {
-          pesho.key += (vocabid_source[i] << i);
-        }
+        pesho.key = getSourceKey(prev_source);
         pesho.bytes_toread = binfile.dist_from_start + binfile.extra_counter - entrystartidx;
 
         //Put into table
@@ -114,7 +141,7 @@ void createProbingPT(const char * phrasetable_path, const char * target_path,
         binfile.write(&encoded_line);
 
         //Set prevLine
-        prev_line = line;
+        prev_source = line.source_phrase.as_string();
 
       } else {
         //If we still have the same line, just append to it:
@@ -128,14 +155,9 @@ void createProbingPT(const char * phrasetable_path, const char * target_path,
 
       //After the final entry is constructed we need to add it to the phrase_table
       //Create an entry for the previous source phrase:
-      Entry pesho;
+      Entry pesho = Entry();
       pesho.value = entrystartidx;
-      //The key is the sum of hashes of individual words. Probably not entirerly correct, but fast
-      pesho.key = 0;
-      std::vector<uint64_t> vocabid_source = getVocabIDs(prev_line.source_phrase);
-      for (int i = 0; i < vocabid_source.size(); i++) {
-        pesho.key += (vocabid_source[i] << i);
-      }
+      pesho.key = getSourceKey(prev_source);
       pesho.bytes_toread = binfile.dist_from_start + binfile.extra_counter - entrystartidx;
       //Put into table
       table.Insert(pesho);
@@ -150,12 +172,278 @@ void createProbingPT(const char * phrasetable_path, const char * target_path,
 
   delete[] mem;
 
-  //Write configfile
-  std::ofstream configfile;
-  configfile.open((basepath + "/config").c_str());
-  configfile << API_VERSION << '\n';
-  configfile << uniq_entries << '\n';
-  configfile << num_scores << '\n';
-  configfile << is_reordering << '\n';
-  configfile.close();
+  writeConfig(basepath, uniq_entries, num_scores, is_reordering);
+}
+
+
+namespace
+{
+
+//Memory for the blocks of the phrase table read ahead by the chain. Lines must fit in a block.
+const std::size_t kBlockSize = 64 << 20;
+const std::size_t kBlockCount = 2;
+
+//Returns the line starting at begin, without the newline (and carriage return) like
+//util::FilePiece::ReadLine, and moves begin to the next line.
+StringPiece nextLine(const char *&begin, const char *end)
+{
+  const char *newline = std::find(begin, end, '\n');
+  StringPiece line(begin, newline - begin);
+  begin = (newline == end) ? end : newline + 1;
+  if (!line.empty() && line.data()[line.size() - 1] == '\r') {
+    line = StringPiece(line.data(), line.size() - 1);
+  }
+  return line;
+}
+
+//Terminates the last line of the file if it has no newline, so that atof and atoi
+//do not read past it into whatever the block held before.
+std::size_t terminateBlock(util::stream::Block &block, std::size_t block_size)
+{
+  char *data = static_cast<char*>(block.Get());
+  std::size_t size = block.ValidSize();
+  if (size && data[size - 1] != '\n') {
+    UTIL_THROW_IF2(size == block_size, "The last line of the phrase table does not fit in a block of "
+                   << block_size << " bytes");
+    data[size++] = '\n';
+  }
+  return size;
+}
+
+//Splits the lines in [begin, end) into num_slices roughly equal slices.
+std::vector<const char*> splitBlock(const char *begin, const char *end, std::size_t num_slices)
+{
+  std::vector<const char*> bounds(1, begin);
+  for (std::size_t i = 1; i < num_slices; i++) {
+    const char *at = std::max(bounds.back(), begin + (end - begin) * i / num_slices);
+    at = std::find(at, end, '\n');
+    bounds.push_back(at == end ? end : at + 1);
+  }
+  bounds.push_back(end);
+  return bounds;
+}
+
+//First pass: counts of one thread, and where the source phrase changes in its last slice.
+struct CountedSlice {
+  Huffman counts;
+  bool empty;
+  std::string first_source, last_source;
+  unsigned long changes; //Source phrase changes after the first line of the slice.
+};
+
+void countSlice(const char *begin, const char *end, CountedSlice *slice)
+{
+  slice->empty = (begin == end);
+  slice->changes = 0;
+  StringPiece prev_source;
+  for (bool first = true; begin != end; first = false) {
+    line_text line = splitLine(nextLine(begin, end));
+    slice->counts.count_elements(line);
+    if (first) {
+      slice->first_source = line.source_phrase.as_string();
+    } else if (line.source_phrase != prev_source) {
+      slice->changes++;
+    }
+    prev_source = line.source_phrase;
+  }
+  slice->last_source = prev_source.as_string();
+}
+
+class CountWorker
+{
+  std::vector<CountedSlice> slices;
+  std::string prev_source;
+  unsigned long uniq_lines;
+
+public:
+  explicit CountWorker(std::size_t num_threads) : slices(num_threads), uniq_lines(0) {}
+
+  void Run(const util::stream::ChainPosition &position) {
+    for (util::stream::Link block(position); block; ++block) {
+      const char *begin = static_cast<const char*>(block->Get());
+      std::size_t size = terminateBlock(*block, position.GetChain().BlockSize());
+      std::vector<const char*> bounds = splitBlock(begin, begin + size, slices.size());
+
+      boost::thread_group threads;
+      for (std::size_t i = 0; i < slices.size(); i++) {
+        threads.create_thread(boost::bind(&countSlice, bounds[i], bounds[i + 1], &slices[i]));
+      }
+      threads.join_all();
+
+      //Count source phrases the way Huffman::Huffman does, across slices
+      for (std::size_t i = 0; i < slices.size(); i++) {
+        if (slices[i].empty) continue;
+        if (slices[i].first_source != prev_source) uniq_lines++;
+        uniq_lines += slices[i].changes;
+        prev_source = slices[i].last_source;
+      }
+    }
+  }
+
+  void AddCounts(Huffman &huffman) const {
+    for (std::size_t i = 0; i < slices.size(); i++) {
+      huffman.add_counts(slices[i].counts);
+    }
+    huffman.setUniqLines(uniq_lines);
+  }
+};
+
+//Second pass: a source phrase starting in a slice, with its offset in the encoded slice.
+struct SourceRun {
+  std::string source_phrase;
+  uint64_t key;
+  uint64_t offset;
+};
+
+struct EncodedSlice {
+  std::vector<unsigned char> bytes;
+  std::vector<SourceRun> runs;
+  std::map<uint64_t, std::string> vocabids;
+};
+
+void encodeSlice(const Huffman *encoder, const char *begin, const char *end, EncodedSlice *slice)
+{
+  slice->bytes.clear();
+  slice->runs.clear();
+  slice->vocabids.clear();
+  while (begin != end) {
+    line_text line = splitLine(nextLine(begin, end));
+    if (slice->runs.empty() || line.source_phrase != StringPiece(slice->runs.back().source_phrase)) {
+      add_to_map(&slice->vocabids, line.source_phrase);
+      SourceRun run;
+      run.source_phrase = line.source_phrase.as_string();
+      run.key = getSourceKey(line.source_phrase);
+      run.offset = slice->bytes.size();
+      slice->runs.push_back(run);
+    }
+    std::vector<unsigned char> encoded_line = encoder->full_encode_line(line);
+    slice->bytes.insert(slice->bytes.end(), encoded_line.begin(), encoded_line.end());
+  }
+}
+
+class EncodeWorker
+{
+  const Huffman &encoder;
+  std::vector<EncodedSlice> slices;
+  int binfile;
+  Table &table;
+  std::map<uint64_t, std::string> &source_vocabids;
+
+  //The source phrase whose entry is not in the table yet
+  bool have_entry;
+  std::string entry_source;
+  uint64_t entry_key, entry_start;
+  uint64_t written;
+
+  void insertEntry(uint64_t entry_end) {
+    Entry pesho = Entry();
+    pesho.value = entry_start;
+    pesho.key = entry_key;
+    pesho.bytes_toread = entry_end - entry_start;
+    table.Insert(pesho);
+  }
+
+  //Same as the loop in createProbingPT, one slice at a time
+  void append(const EncodedSlice &slice) {
+    for (std::vector<SourceRun>::const_iterator run = slice.runs.begin(); run != slice.runs.end(); ++run) {
+      if (have_entry && run->source_phrase == entry_source) continue; //Continued from the previous slice
+      uint64_t start = written + run->offset;
+      if (have_entry) insertEntry(start);
+      have_entry = true;
+      entry_source = run->source_phrase;
+      entry_key = run->key;
+      entry_start = start;
+    }
+    for (std::map<uint64_t, std::string>::const_iterator it = slice.vocabids.begin(); it != slice.vocabids.end(); ++it) {
+      source_vocabids.insert(*it);
+    }
+    if (!slice.bytes.empty()) {
+      util::WriteOrThrow(binfile, &slice.bytes[0], slice.bytes.size());
+      written += slice.bytes.size();
+    }
+  }
+
+public:
+  EncodeWorker(const Huffman &encoder, std::size_t num_threads, int binfile, Table &table,
+               std::map<uint64_t, std::string> &source_vocabids)
+    : encoder(encoder), slices(num_threads), binfile(binfile), table(table), source_vocabids(source_vocabids)
+    , have_entry(false), entry_key(0), entry_start(0), written(0) {}
+
+  void Run(const util::stream::ChainPosition &position) {
+    for (util::stream::Link block(position); block; ++block) {
+      const char *begin = static_cast<const char*>(block->Get());
+      std::size_t size = terminateBlock(*block, position.GetChain().BlockSize());
+      std::vector<const char*> bounds = splitBlock(begin, begin + size, slices.size());
+
+      boost::thread_group threads;
+      for (std::size_t i = 0; i < slices.size(); i++) {
+        threads.create_thread(boost::bind(&encodeSlice, &encoder, bounds[i], bounds[i + 1], &slices[i]));
+      }
+      threads.join_all();
+
+      for (std::size_t i = 0; i < slices.size(); i++) {
+        append(slices[i]);
+      }
+    }
+  }
+
+  //Adds the entry of the last source phrase
+  void Finish() {
+    if (have_entry) insertEntry(written);
+  }
+};
+
+}
+
+void createProbingPTParallel(const char * phrasetable_path, const char * target_path,
+                             const char * num_scores, const char * is_reordering,
+                             std::size_t num_threads)
+{
+  //Get basepath and create directory if missing
+  std::string basepath(target_path);
+  mkdir(basepath.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+  num_threads = std::max<std::size_t>(num_threads, 1);
+
+  util::stream::Chain chain(util::stream::ChainConfig(1, kBlockCount, kBlockCount * kBlockSize));
+
+  //Count target words and alignments, and set up huffman and serialize decoder maps.
+  Huffman huffmanEncoder;
+  {
+    CountWorker counter(num_threads);
+    chain >> util::stream::LineInput(util::OpenReadOrThrow(phrasetable_path)) >> boost::ref(counter);
+    chain.Wait(false);
+    counter.AddCounts(huffmanEncoder);
+  }
+  unsigned long uniq_entries = huffmanEncoder.getUniqLines();
+  std::cerr << "Unique entries counted: " << uniq_entries << std::endl;
+  huffmanEncoder.assign_values();
+  huffmanEncoder.produce_lookups();
+  huffmanEncoder.serialize_maps(target_path);
+
+  //Source phrase vocabids
+  std::map<uint64_t, std::string> source_vocabids;
+
+  //Init the probing hash table
+  size_t size = Table::Size(uniq_entries, 1.2);
+  char * mem = new char[size];
+  memset(mem, 0, size);
+  Table table(mem, size);
+
+  //Encode the lines and fill the table
+  {
+    util::scoped_fd binfile(util::CreateOrThrow((basepath + "/binfile.dat").c_str()));
+    EncodeWorker encoder(huffmanEncoder, num_threads, binfile.get(), table, source_vocabids);
+    chain >> util::stream::LineInput(util::OpenReadOrThrow(phrasetable_path)) >> boost::ref(encoder);
+    chain.Wait();
+    encoder.Finish();
+  }
+  std::cerr << "Reading phrase table finished, writing remaining files to disk." << std::endl;
+
+  serialize_table(mem, size, (basepath + "/probing_hash.dat").c_str());
+
+  serialize_map(&source_vocabids, (basepath + "/source_vocabids").c_str());
+
+  delete[] mem;
+
+  writeConfig(basepath, uniq_entries, num_scores, is_reordering);
 }
@@ -17,6 +17,15 @@
 void createProbingPT(const char * phrasetable_path, const char * target_path,
                      const char * num_scores, const char * is_reordering);
 
+//Multi-threaded createProbingPT with the same output. The phrase table is streamed
+//twice in blocks of whole lines through a util::stream chain; each block is split
+//between num_threads threads for counting (first pass) and for hashing and encoding
+//(second pass), and the results are written out in input order. Like createProbingPT,
+//it expects the lines of a source phrase to be consecutive in the phrase table.
+void createProbingPTParallel(const char * phrasetable_path, const char * target_path,
+                             const char * num_scores, const char * is_reordering,
+                             std::size_t num_threads);
+
 class BinaryFileWriter
 {
   std::vector<unsigned char> binfile;
@@ -0,0 +1,244 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2016 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+
+#include "PhraseDictionaryMemoryImage.h"
+#include "moses/InputPath.h"
+#include "moses/StaticData.h"
+#include "moses/TargetPhrase.h"
+#include "moses/Timer.h"
+#include "moses/TranslationModel/CYKPlusParser/ChartRuleLookupManagerMemoryImage.h"
+#include "util/usage.hh"
+
+using namespace std;
+
+namespace Moses
+{
+
+using RuleTableImageFormat::kNone;
+
+PhraseDictionaryMemoryImage::PhraseDictionaryMemoryImage(const std::string &line)
+  : PhraseDictionary(line, true)
+  , m_populate(false)
+{
+  ReadParameters();
+}
+
+void PhraseDictionaryMemoryImage::SetParameter(const std::string& key, const std::string& value)
+{
+  if (key == "populate") {
+    m_populate = Scan<bool>(value);
+  } else {
+    PhraseDictionary::SetParameter(key, value);
+  }
+}
+
+void PhraseDictionaryMemoryImage::Load(AllOptions::ptr const& opts)
+{
+  m_options = opts;
+  SetFeaturesToApply();
+
+#if defined(UNLABELLED_SOURCE)
+  UTIL_THROW2("PhraseDictionaryMemoryImage does not support UNLABELLED_SOURCE builds");
+#endif
+
+  Timer timer;
+  timer.start();
+
+  m_image.Open(m_filePath, m_populate);
+  UTIL_THROW_IF2(m_image.GetNumScores() != m_numScoreComponents,
+                 "Rule table image " << m_filePath << " has " << m_image.GetNumScores()
+                 << " scores. The ini file specified " << m_numScoreComponents << " scores");
+
+  UTIL_THROW_IF2(m_image.GetSourceFactors() && m_image.GetSourceFactors() < m_input.size(),
+                 "Rule table image " << m_filePath << " only keeps " << m_image.GetSourceFactors()
+                 << " factors of each source word. The ini file specified " << m_input.size());
+
+  m_sourceVocab.resize(m_image.GetSourceVocabSize());
+  for (uint32_t id = 0; id < m_sourceVocab.size(); ++id) {
+    const bool isNonTerminal = m_image.IsSourceNonTerminal(id);
+    m_sourceVocab[id].CreateFromString(Input, m_input, m_image.GetSourceString(id), isNonTerminal);
+    if (!isNonTerminal) {
+      // two strings can only give the same word if they differ in factors
+      // this table does not use; the text loader would merge their rules,
+      // which the image can only do when it is created
+      UTIL_THROW_IF2(!m_sourceTerminalIds.insert(make_pair(m_sourceVocab[id], id)).second,
+                     "Source words in " << m_filePath << " have more factors than the "
+                     << "ini file specifies for this phrase table: " << m_image.GetSourceString(id)
+                     << ". Create the image with CreateRuleTableImage --source-factors "
+                     << m_input.size());
+    }
+  }
+
+  m_targetVocab.resize(m_image.GetTargetVocabSize());
+  for (uint32_t id = 0; id < m_targetVocab.size(); ++id) {
+    m_targetVocab[id].CreateFromString(Output, m_output, m_image.GetTargetString(id),
+                                       m_image.IsTargetNonTerminal(id));
+  }
+
+  VERBOSE(1, "Mapped rule table image " << m_filePath << " with "
+          << m_image.GetNumNodes() << " nodes in " << timer.get_elapsed_time()
+          << " seconds, RSS " << (util::RSSMax() >> 20) << "MB" << endl);
+}
+
+ChartRuleLookupManager *PhraseDictionaryMemoryImage::CreateRuleLookupManager(
+  const ChartParser &parser,
+  const ChartCellCollectionBase &cellCollection,
+  std::size_t /*maxChartSpan*/)
+{
+  return new ChartRuleLookupManagerMemoryImage(parser, cellCollection, *this);
+}
+
+uint32_t PhraseDictionaryMemoryImage::GetSourceTerminalId(Word word) const
+{
+  word.OnlyTheseFactors(m_inputFactors);
+  boost::unordered_map<Word, uint32_t, TerminalHasher, TerminalEqualityPred>::const_iterator
+  iter = m_sourceTerminalIds.find(word);
+  return iter == m_sourceTerminalIds.end() ? kNone : iter->second;
+}
+
+TargetPhraseCollection::shared_ptr
+PhraseDictionaryMemoryImage::
+GetTargetPhraseCollection(const Node &node) const
+{
+  TargetPhraseCollection::shared_ptr ret;
+  if (node.numRules == 0) {
+    return ret;
+  }
+
+  PhraseTableCache &cache = GetCache();
+  size_t key = m_image.GetIndex(node);
+  if (!cache.Get(key, ret)) {
+    ret = CreateTargetPhraseCollection(node);
+    cache.Put(key, ret);
+  }
+  return ret;
+}
+
+TargetPhraseCollection::shared_ptr
+PhraseDictionaryMemoryImage::
+CreateTargetPhraseCollection(const Node &node) const
+{
+  // the source phrase is the path from the root
+  std::vector<uint32_t> path;
+  for (const Node *curr = &node; curr->parent != kNone; curr = &m_image.GetNode(curr->parent)) {
+    path.push_back(curr->word);
+  }
+  Phrase sourcePhrase;
+  for (std::vector<uint32_t>::const_reverse_iterator iter = path.rbegin(); iter != path.rend(); ++iter) {
+    sourcePhrase.AddWord(m_sourceVocab[*iter]);
+  }
+
+  TargetPhraseCollection::shared_ptr ret(new TargetPhraseCollection);
+  std::vector<float> scores(m_image.GetNumScores());
+  for (size_t i = 0; i < node.numRules; ++i) {
+    RuleTableImage::Rule rule = m_image.GetRule(node, i);
+
+    TargetPhrase *targetPhrase = new TargetPhrase(this);
+    for (size_t pos = 0; pos < rule.numWords; ++pos) {
+      targetPhrase->AddWord(m_targetVocab[rule.words[pos]]);
+    }
+
+    AlignmentInfo::CollType alignTerm, alignNonTerm;
+    for (size_t j = 0; j < rule.numAlignments; ++j) {
+      std::pair<size_t, size_t> point(rule.alignment[2 * j], rule.alignment[2 * j + 1]);
+      if (targetPhrase->GetWord(point.second).IsNonTerminal()) {
+        alignNonTerm.insert(point);
+      } else {
+        alignTerm.insert(point);
+      }
+    }
+    targetPhrase->SetAlignTerm(alignTerm);
+    targetPhrase->SetAlignNonTerm(alignNonTerm);
+
+    if (rule.lhs != kNone) {
+      targetPhrase->SetTargetLHS(new Word(m_targetVocab[rule.lhs]));
+    }
+    if (!rule.sparse.empty()) {
+      targetPhrase->SetSparseScore(this, rule.sparse);
+    }
+    if (!rule.properties.empty()) {
+      targetPhrase->SetProperties(rule.properties);
+    }
+
+    std::copy(rule.scores, rule.scores + scores.size(), scores.begin());
+    targetPhrase->GetScoreBreakdown().Assign(this, scores);
+    targetPhrase->EvaluateInIsolation(sourcePhrase, GetFeaturesToApply());
+
+    ret->Add(targetPhrase);
+  }
+
+  if (GetTableLimit()) {
+    ret->Sort(true, GetTableLimit());
+  }
+  return ret;
+}
+
+void
+PhraseDictionaryMemoryImage::
+GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
+{
+  InputPathList::const_iterator iter;
+  for (iter = inputPathQueue.begin(); iter != inputPathQueue.end(); ++iter) {
+    InputPath &inputPath = **iter;
+    const Phrase &phrase = inputPath.GetPhrase();
+    const InputPath *prevPath = inputPath.GetPrevPath();
+
+    const Node *prevPtNode = NULL;
+
+    if (prevPath) {
+      prevPtNode = static_cast<const Node*>(prevPath->GetPtNode(*this));
+    } else {
+      // Starting subphrase.
+      assert(phrase.GetSize() == 1);
+      prevPtNode = &m_image.GetRoot();
+    }
+
+    // backoff
+    if (!SatisfyBackoff(inputPath)) {
+      continue;
+    }
+
+    if (prevPtNode) {
+      uint32_t id = GetSourceTerminalId(phrase.GetWord(phrase.GetSize() - 1));
+      const Node *ptNode = (id == kNone) ? NULL : m_image.GetChild(*prevPtNode, id);
+      TargetPhraseCollection::shared_ptr targetPhrases;
+      if (ptNode) {
+        targetPhrases = GetTargetPhraseCollection(*ptNode);
+      }
+      inputPath.SetTargetPhrases(*this, targetPhrases, ptNode);
+    }
+  }
+}
+
+TargetPhraseCollection::shared_ptr
+PhraseDictionaryMemoryImage::
+GetTargetPhraseCollectionLEGACY(const Phrase& source) const
+{
+  const Node *currNode = &m_image.GetRoot();
+  for (size_t pos = 0; pos < source.GetSize() && currNode; ++pos) {
+    uint32_t id = GetSourceTerminalId(source.GetWord(pos));
+    currNode = (id == kNone) ? NULL : m_image.GetChild(*currNode, id);
+  }
+  return currNode ? GetTargetPhraseCollection(*currNode) : TargetPhraseCollection::shared_ptr();
+}
+
+}
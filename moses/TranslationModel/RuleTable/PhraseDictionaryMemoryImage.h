@@ -0,0 +1,95 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2016 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include "RuleTableImage.h"
+#include "moses/Terminal.h"
+#include "moses/Word.h"
+#include "moses/TranslationModel/PhraseDictionary.h"
+
+namespace Moses
+{
+class ChartParser;
+
+/** Rule table read from a binary image made by CreateRuleTableImage.
+ *
+ * Works like PhraseDictionaryMemory, for both phrase-based and chart
+ * decoding, but the trie is the mapped image itself: loading only turns the
+ * vocabularies into Words. Target phrase collections are decoded the first
+ * time a node is used and kept in the shared phrase table cache.
+ *
+ * Parameters, besides those of PhraseDictionary:
+ *   populate=true   read the whole image into memory when loading,
+ *                   instead of paging it in as it is used
+ */
+class PhraseDictionaryMemoryImage : public PhraseDictionary
+{
+public:
+  typedef RuleTableImage::Node Node;
+
+  PhraseDictionaryMemoryImage(const std::string &line);
+
+  void Load(AllOptions::ptr const& opts);
+
+  ChartRuleLookupManager *CreateRuleLookupManager(
+    const ChartParser &,
+    const ChartCellCollectionBase &,
+    std::size_t);
+
+  void GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const;
+
+  TargetPhraseCollection::shared_ptr
+  GetTargetPhraseCollectionLEGACY(const Phrase& src) const;
+
+  void SetParameter(const std::string& key, const std::string& value);
+
+  const RuleTableImage &GetImage() const {
+    return m_image;
+  }
+
+  //! source vocab id of a terminal (input factors only), or kNone
+  uint32_t GetSourceTerminalId(Word word) const;
+
+  const Word &GetTargetWord(uint32_t id) const {
+    return m_targetVocab[id];
+  }
+
+  //! rules of a node, from the cache or decoded from the image. NULL if there are none
+  TargetPhraseCollection::shared_ptr
+  GetTargetPhraseCollection(const Node &node) const;
+
+protected:
+  TargetPhraseCollection::shared_ptr
+  CreateTargetPhraseCollection(const Node &node) const;
+
+  RuleTableImage m_image;
+  bool m_populate;
+
+  std::vector<Word> m_sourceVocab, m_targetVocab;
+  boost::unordered_map<Word, uint32_t, TerminalHasher, TerminalEqualityPred> m_sourceTerminalIds;
+};
+
+}
@@ -39,6 +39,7 @@ PhraseDictionaryOnDisk::PhraseDictionaryOnDisk(const std::string &line)
   : MyBase(line, true)
   , m_maxSpanDefault(NOT_FOUND)
   , m_maxSpanLabelled(NOT_FOUND)
+  , m_mmap(false)
 {
   ReadParameters();
 }
@@ -83,10 +84,9 @@ const OnDiskPt::OnDiskWrapper &PhraseDictionaryOnDisk::GetImplementation() const
 void PhraseDictionaryOnDisk::InitializeForInput(ttasksptr const& ttask)
 {
   InputType const& source = *ttask->GetSource();
-  ReduceCache();
 
   OnDiskPt::OnDiskWrapper *obj = new OnDiskPt::OnDiskWrapper();
-  obj->BeginLoad(m_filePath);
+  obj->BeginLoad(m_filePath, m_mmap);
 
   UTIL_THROW_IF2(obj->GetMisc("Version") != OnDiskPt::OnDiskWrapper::VERSION_NUM,
                  "On-disk phrase table is version " <<  obj->GetMisc("Version")
@@ -171,23 +171,13 @@ GetTargetPhraseCollection(const OnDiskPt::PhraseNode *ptNode) const
 {
   TargetPhraseCollection::shared_ptr ret;
 
-  CacheColl &cache = GetCache();
+  PhraseTableCache &cache = GetCache();
   size_t hash = (size_t) ptNode->GetFilePos();
 
-  CacheColl::iterator iter;
-
-  iter = cache.find(hash);
-
-  if (iter == cache.end()) {
+  if (!cache.Get(hash, ret)) {
     // not in cache, need to look up from phrase table
     ret = GetTargetPhraseCollectionNonCache(ptNode);
-
-    std::pair<TargetPhraseCollection::shared_ptr , clock_t> value(ret, clock());
-    cache[hash] = value;
-  } else {
-    // in cache. just use it
-    iter->second.second = clock();
-    ret = iter->second.first;
+    cache.Put(hash, ret);
   }
 
   return ret;
@@ -220,6 +210,8 @@ void PhraseDictionaryOnDisk::SetParameter(const std::string& key, const std::str
     m_maxSpanDefault = Scan<size_t>(value);
   } else if (key == "max-span-labelled") {
     m_maxSpanLabelled = Scan<size_t>(value);
+  } else if (key == "mmap") {
+    m_mmap = Scan<bool>(value);
   } else {
     PhraseDictionary::SetParameter(key, value);
   }
@@ -58,6 +58,7 @@ protected:
 #endif
 
   size_t m_maxSpanDefault, m_maxSpanLabelled;
+  bool m_mmap;
 
   OnDiskPt::OnDiskWrapper &GetImplementation();
   const OnDiskPt::OnDiskWrapper &GetImplementation() const;
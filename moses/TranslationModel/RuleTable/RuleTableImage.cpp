@@ -0,0 +1,119 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2016 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "RuleTableImage.h"
+#include "util/exception.hh"
+#include "util/file.hh"
+
+using namespace std;
+
+namespace Moses
+{
+
+using namespace RuleTableImageFormat;
+
+namespace
+{
+
+bool TerminalLess(const TerminalEdge &edge, uint32_t word)
+{
+  return edge.word < word;
+}
+
+bool NonTerminalLess(const NonTerminalEdge &edge, const pair<uint32_t, uint32_t> &labels)
+{
+  return edge.targetLabel < labels.first
+         || (edge.targetLabel == labels.first && edge.sourceLabel < labels.second);
+}
+
+}
+
+void RuleTableImage::Open(const std::string &path, bool populate)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(path.c_str()));
+  const uint64_t size = util::SizeOrThrow(file.get());
+  UTIL_THROW_IF2(size < sizeof(Header), path << " is too small to be a rule table image");
+
+  util::MapRead(populate ? util::POPULATE_OR_READ : util::LAZY, file.get(), 0, size, m_memory);
+  m_header = reinterpret_cast<const Header*>(m_memory.begin());
+
+  UTIL_THROW_IF2(memcmp(m_header->magic, kMagic, sizeof(kMagic)),
+                 path << " is not a rule table image");
+  UTIL_THROW_IF2(m_header->byteOrder != kByteOrderMark,
+                 path << " was written on a machine with a different byte order");
+  UTIL_THROW_IF2(m_header->version != kVersion,
+                 "Rule table image " << path << " is version " << m_header->version
+                 << ". This decoder reads version " << kVersion << ", please rebuild it");
+  for (size_t i = 0; i < NumSections; ++i) {
+    UTIL_THROW_IF2(m_header->offset[i] % 8 || m_header->offset[i] > size
+                   || m_header->size[i] > size - m_header->offset[i],
+                   "Rule table image " << path << " is truncated or corrupt");
+  }
+
+  m_sourceVocab = reinterpret_cast<const VocabEntry*>(Section(SourceVocab));
+  m_targetVocab = reinterpret_cast<const VocabEntry*>(Section(TargetVocab));
+  m_nodes = reinterpret_cast<const Node*>(Section(Nodes));
+  m_terminals = reinterpret_cast<const TerminalEdge*>(Section(TerminalEdges));
+  m_nonTerminals = reinterpret_cast<const NonTerminalEdge*>(Section(NonTerminalEdges));
+  m_ruleIndex = reinterpret_cast<const uint64_t*>(Section(RuleIndex));
+  UTIL_THROW_IF2(GetNumNodes() == 0, "Rule table image " << path << " has no root node");
+}
+
+const RuleTableImage::Node *RuleTableImage::GetChild(const Node &node, uint32_t word) const
+{
+  const TerminalEdge *begin = BeginTerminals(node), *end = EndTerminals(node);
+  const TerminalEdge *edge = lower_bound(begin, end, word, TerminalLess);
+  return (edge != end && edge->word == word) ? &m_nodes[edge->node] : NULL;
+}
+
+const RuleTableImage::Node *RuleTableImage::GetChild(const Node &node, uint32_t sourceLabel, uint32_t targetLabel) const
+{
+  const NonTerminalEdge *begin = BeginNonTerminals(node), *end = EndNonTerminals(node);
+  const NonTerminalEdge *edge = lower_bound(begin, end, make_pair(targetLabel, sourceLabel), NonTerminalLess);
+  return (edge != end && edge->targetLabel == targetLabel && edge->sourceLabel == sourceLabel)
+         ? &m_nodes[edge->node] : NULL;
+}
+
+RuleTableImage::Rule RuleTableImage::GetRule(const Node &node, size_t i) const
+{
+  const char *data = Section(Rules) + m_ruleIndex[node.firstRule + i];
+  const RuleHeader &header = *reinterpret_cast<const RuleHeader*>(data);
+  data += sizeof(RuleHeader);
+
+  Rule ret;
+  ret.lhs = header.lhs;
+  ret.scores = reinterpret_cast<const float*>(data);
+  data += m_header->numScores * sizeof(float);
+  ret.words = reinterpret_cast<const uint32_t*>(data);
+  ret.numWords = header.numWords;
+  data += header.numWords * sizeof(uint32_t);
+  ret.alignment = reinterpret_cast<const uint16_t*>(data);
+  ret.numAlignments = header.numAlignments;
+  data += header.numAlignments * 2 * sizeof(uint16_t);
+  ret.sparse = StringPiece(data, header.sparseSize);
+  data += header.sparseSize;
+  ret.properties = StringPiece(data, header.propertiesSize);
+  return ret;
+}
+
+}
@@ -0,0 +1,229 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2016 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <stdint.h>
+
+#include "util/mmap.hh"
+#include "util/string_piece.hh"
+
+namespace Moses
+{
+
+/** Binary image of a text rule table, as read by PhraseDictionaryMemoryImage
+ * and written by RuleTableImageWriter (misc/CreateRuleTableImage).
+ *
+ * The image holds the same trie that PhraseDictionaryMemory builds at
+ * startup, but as flat arrays: nodes, terminal edges sorted by source word
+ * id, non-terminal edges sorted by (target label, source label) and one
+ * variable-length record per rule. All references are array indices or
+ * byte offsets from the start of the file, so the image is mapped and used
+ * in place. Words are stored as ids into two vocabularies of the strings
+ * that appeared in the text table; the decoder turns each string into a
+ * Word once, when the table is loaded.
+ *
+ * Integers are in the byte order of the machine that wrote the image;
+ * a mismatch is detected and reported when it is opened.
+ */
+namespace RuleTableImageFormat
+{
+
+const char kMagic[8] = { 'm', 'o', 's', 'e', 's', 'r', 't', 'i' };
+const uint32_t kVersion = 1;
+const uint32_t kByteOrderMark = 0x01020304;
+//! id used for "no word", eg the edge into the root or a missing LHS
+const uint32_t kNone = 0xFFFFFFFF;
+
+enum Section {
+  Strings = 0,            //! NUL-terminated vocabulary strings
+  SourceVocab,            //! VocabEntry[]
+  TargetVocab,            //! VocabEntry[]
+  Nodes,                  //! Node[], the root is node 0
+  TerminalEdges,          //! TerminalEdge[]
+  NonTerminalEdges,       //! NonTerminalEdge[]
+  RuleIndex,              //! uint64_t[], byte offset of each rule in Rules
+  Rules,                  //! rule records
+  NumSections
+};
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t numScores;
+  uint32_t sourceFactors; //! factors kept of each source terminal, 0 if all
+  uint64_t offset[NumSections]; //! from the start of the file, 8-byte aligned
+  uint64_t size[NumSections]; //! in bytes
+};
+
+struct VocabEntry {
+  uint64_t string; //! offset in Strings
+  uint32_t isNonTerminal;
+  uint32_t reserved;
+};
+
+struct Node {
+  uint32_t parent; //! kNone for the root
+  uint32_t word; //! source vocab id of the edge from the parent
+  uint32_t firstTerminal;
+  uint32_t numTerminals;
+  uint32_t firstNonTerminal;
+  uint32_t numNonTerminals;
+  uint32_t firstRule; //! in RuleIndex
+  uint32_t numRules;
+};
+
+struct TerminalEdge {
+  uint32_t word; //! source vocab id
+  uint32_t node;
+};
+
+struct NonTerminalEdge {
+  uint32_t targetLabel; //! target vocab id
+  uint32_t sourceLabel; //! source vocab id
+  uint32_t node;
+};
+
+/** Fixed part of a rule record. It is followed by
+ *    float scores[numScores]            (already log-transformed and floored)
+ *    uint32_t words[numWords]           (target vocab ids, without the LHS)
+ *    uint16_t alignment[2 * numAlignments]   (source, target pairs)
+ *    char sparse[sparseSize], properties[propertiesSize]
+ *  and padding up to a multiple of 4 bytes. */
+struct RuleHeader {
+  uint32_t lhs; //! target vocab id, kNone for phrase-based rules
+  uint16_t numWords;
+  uint16_t numAlignments;
+  uint32_t sparseSize;
+  uint32_t propertiesSize;
+};
+
+}
+
+/** Read-only view of a mapped rule table image. */
+class RuleTableImage
+{
+public:
+  typedef RuleTableImageFormat::Node Node;
+  typedef RuleTableImageFormat::TerminalEdge TerminalEdge;
+  typedef RuleTableImageFormat::NonTerminalEdge NonTerminalEdge;
+
+  //! a rule record, pointing into the image
+  struct Rule {
+    uint32_t lhs;
+    const float *scores;
+    const uint32_t *words;
+    size_t numWords;
+    const uint16_t *alignment; //! numAlignments (source, target) pairs
+    size_t numAlignments;
+    StringPiece sparse;
+    StringPiece properties;
+  };
+
+  RuleTableImage() : m_header(NULL) {}
+
+  //! map the image; with populate, read it all in up front
+  void Open(const std::string &path, bool populate);
+
+  size_t GetNumScores() const {
+    return m_header->numScores;
+  }
+
+  //! number of factors kept of each source terminal, 0 if all of them
+  size_t GetSourceFactors() const {
+    return m_header->sourceFactors;
+  }
+
+  size_t GetSourceVocabSize() const {
+    return SectionSize<RuleTableImageFormat::VocabEntry>(RuleTableImageFormat::SourceVocab);
+  }
+  size_t GetTargetVocabSize() const {
+    return SectionSize<RuleTableImageFormat::VocabEntry>(RuleTableImageFormat::TargetVocab);
+  }
+  StringPiece GetSourceString(uint32_t id) const {
+    return GetString(m_sourceVocab[id].string);
+  }
+  bool IsSourceNonTerminal(uint32_t id) const {
+    return m_sourceVocab[id].isNonTerminal;
+  }
+  StringPiece GetTargetString(uint32_t id) const {
+    return GetString(m_targetVocab[id].string);
+  }
+  bool IsTargetNonTerminal(uint32_t id) const {
+    return m_targetVocab[id].isNonTerminal;
+  }
+
+  size_t GetNumNodes() const {
+    return SectionSize<Node>(RuleTableImageFormat::Nodes);
+  }
+  const Node &GetRoot() const {
+    return m_nodes[0];
+  }
+  const Node &GetNode(uint32_t index) const {
+    return m_nodes[index];
+  }
+  uint32_t GetIndex(const Node &node) const {
+    return &node - m_nodes;
+  }
+
+  const TerminalEdge *BeginTerminals(const Node &node) const {
+    return m_terminals + node.firstTerminal;
+  }
+  const TerminalEdge *EndTerminals(const Node &node) const {
+    return m_terminals + node.firstTerminal + node.numTerminals;
+  }
+  const NonTerminalEdge *BeginNonTerminals(const Node &node) const {
+    return m_nonTerminals + node.firstNonTerminal;
+  }
+  const NonTerminalEdge *EndNonTerminals(const Node &node) const {
+    return m_nonTerminals + node.firstNonTerminal + node.numNonTerminals;
+  }
+
+  //! child of node along the terminal with the given source vocab id, or NULL
+  const Node *GetChild(const Node &node, uint32_t word) const;
+
+  //! child along the non-terminal pair, or NULL
+  const Node *GetChild(const Node &node, uint32_t sourceLabel, uint32_t targetLabel) const;
+
+  Rule GetRule(const Node &node, size_t i) const;
+
+private:
+  util::scoped_memory m_memory;
+  const RuleTableImageFormat::Header *m_header;
+  const RuleTableImageFormat::VocabEntry *m_sourceVocab, *m_targetVocab;
+  const Node *m_nodes;
+  const TerminalEdge *m_terminals;
+  const NonTerminalEdge *m_nonTerminals;
+  const uint64_t *m_ruleIndex;
+
+  const char *Section(RuleTableImageFormat::Section section) const {
+    return m_memory.begin() + m_header->offset[section];
+  }
+  template <class T> size_t SectionSize(RuleTableImageFormat::Section section) const {
+    return m_header->size[section] / sizeof(T);
+  }
+  StringPiece GetString(uint64_t offset) const {
+    return StringPiece(Section(RuleTableImageFormat::Strings) + offset);
+  }
+};
+
+}
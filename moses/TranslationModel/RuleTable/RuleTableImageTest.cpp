@@ -0,0 +1,166 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2016- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <string>
+
+#include "RuleTableImage.h"
+#include "RuleTableImageWriter.h"
+#include "util/exception.hh"
+
+using namespace Moses;
+using namespace std;
+using RuleTableImageFormat::kNone;
+
+namespace
+{
+
+uint32_t FindSource(const RuleTableImage &image, const string &word, bool isNonTerminal)
+{
+  for (uint32_t id = 0; id < image.GetSourceVocabSize(); ++id) {
+    if (image.GetSourceString(id) == word && image.IsSourceNonTerminal(id) == isNonTerminal) return id;
+  }
+  return kNone;
+}
+
+uint32_t FindTarget(const RuleTableImage &image, const string &word, bool isNonTerminal)
+{
+  for (uint32_t id = 0; id < image.GetTargetVocabSize(); ++id) {
+    if (image.GetTargetString(id) == word && image.IsTargetNonTerminal(id) == isNonTerminal) return id;
+  }
+  return kNone;
+}
+
+struct ImageFixture {
+  ImageFixture() : path(boost::filesystem::unique_path(
+                            boost::filesystem::temp_directory_path() / "rule-table-image-%%%%%%%%").string()) {}
+  ~ImageFixture() {
+    boost::filesystem::remove(path);
+  }
+  string path;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(rule_table_image)
+
+BOOST_FIXTURE_TEST_CASE(round_trip, ImageFixture)
+{
+  RuleTableImageWriter writer(2);
+  BOOST_CHECK(writer.AddRule("das Haus [X] ||| the house [X] ||| 0.5 0.25 ||| 0-1 1-1 ||| 1 1 1"));
+  BOOST_CHECK(writer.AddRule("das [X][NP] [X] ||| [X][NP] of the [S] ||| 1 0.5 ||| 1-0 ||| 1 1 1 ||| sp=1 ||| {{Tree [S]}}"));
+  BOOST_CHECK(writer.AddRule("das Haus [X] ||| home [X] ||| 0.1 0.2 ||| 1-0"));
+  BOOST_CHECK(!writer.AddRule(" ||| nothing [X] ||| 0.1 0.2 ||| "));
+  BOOST_CHECK_EQUAL(writer.GetNumRules(), 3);
+  writer.Write(path);
+
+  RuleTableImage image;
+  image.Open(path, false);
+  BOOST_CHECK_EQUAL(image.GetNumScores(), 2);
+  BOOST_CHECK_EQUAL(image.GetNumNodes(), 4);
+
+  const RuleTableImage::Node &root = image.GetRoot();
+  uint32_t das = FindSource(image, "das", false);
+  uint32_t haus = FindSource(image, "Haus", false);
+  uint32_t sourceX = FindSource(image, "X", true);
+  uint32_t targetNP = FindTarget(image, "NP", true);
+  BOOST_REQUIRE(das != kNone && haus != kNone && sourceX != kNone && targetNP != kNone);
+  BOOST_CHECK(image.GetChild(root, haus) == NULL);
+
+  const RuleTableImage::Node *dasNode = image.GetChild(root, das);
+  BOOST_REQUIRE(dasNode);
+  BOOST_CHECK_EQUAL(dasNode->numRules, 0);
+  BOOST_CHECK(image.GetChild(*dasNode, targetNP, sourceX) == NULL);
+
+  // two rules for the same source phrase share a node, in table order
+  const RuleTableImage::Node *hausNode = image.GetChild(*dasNode, haus);
+  BOOST_REQUIRE(hausNode);
+  BOOST_CHECK_EQUAL(hausNode->parent, image.GetIndex(*dasNode));
+  BOOST_CHECK_EQUAL(hausNode->word, haus);
+  BOOST_REQUIRE_EQUAL(hausNode->numRules, 2);
+  RuleTableImage::Rule rule = image.GetRule(*hausNode, 0);
+  BOOST_CHECK_EQUAL(rule.lhs, FindTarget(image, "X", true));
+  BOOST_CHECK_CLOSE(rule.scores[0], log(0.5f), 0.001);
+  BOOST_CHECK_CLOSE(rule.scores[1], log(0.25f), 0.001);
+  BOOST_REQUIRE_EQUAL(rule.numWords, 2);
+  BOOST_CHECK_EQUAL(image.GetTargetString(rule.words[1]), "house");
+  BOOST_REQUIRE_EQUAL(rule.numAlignments, 2);
+  BOOST_CHECK_EQUAL(rule.alignment[2], 1);
+  BOOST_CHECK_EQUAL(rule.alignment[3], 1);
+  BOOST_CHECK(rule.sparse.empty());
+  BOOST_CHECK_EQUAL(image.GetTargetString(image.GetRule(*hausNode, 1).words[0]), "home");
+
+  // non-terminals are keyed by source and target label
+  const RuleTableImage::Node *ntNode = image.GetChild(*dasNode, sourceX, targetNP);
+  BOOST_REQUIRE(ntNode);
+  BOOST_REQUIRE_EQUAL(ntNode->numRules, 1);
+  rule = image.GetRule(*ntNode, 0);
+  BOOST_CHECK_EQUAL(rule.lhs, FindTarget(image, "S", true));
+  BOOST_REQUIRE_EQUAL(rule.numWords, 3);
+  BOOST_CHECK_EQUAL(rule.words[0], targetNP);
+  BOOST_CHECK_EQUAL(rule.sparse, " sp=1 ");
+  BOOST_CHECK_EQUAL(rule.properties, " {{Tree [S]}}");
+}
+
+// as in the text loader, words that only differ in factors the decoder
+// does not use lead to the same node
+BOOST_FIXTURE_TEST_CASE(strips_source_factors, ImageFixture)
+{
+  RuleTableImageWriter writer(1, 1);
+  BOOST_CHECK(writer.AddRule("das|ART|x Haus|NN ||| the house ||| 0.5 ||| 0-0 1-1"));
+  BOOST_CHECK(writer.AddRule("das|PDS Haus|NE ||| that house ||| 0.25 ||| 0-0 1-1"));
+  BOOST_CHECK(writer.AddRule("Haus ||| house ||| 0.1 ||| 0-0"));
+  writer.Write(path);
+
+  RuleTableImage image;
+  image.Open(path, false);
+  BOOST_CHECK_EQUAL(image.GetSourceFactors(), 1);
+  BOOST_CHECK_EQUAL(image.GetSourceVocabSize(), 2);
+  BOOST_CHECK_EQUAL(image.GetNumNodes(), 4);
+  uint32_t das = FindSource(image, "das", false);
+  uint32_t haus = FindSource(image, "Haus", false);
+  BOOST_REQUIRE(das != kNone && haus != kNone);
+  const RuleTableImage::Node *dasNode = image.GetChild(image.GetRoot(), das);
+  BOOST_REQUIRE(dasNode);
+  const RuleTableImage::Node *hausNode = image.GetChild(*dasNode, haus);
+  BOOST_REQUIRE(hausNode);
+  BOOST_CHECK_EQUAL(hausNode->numRules, 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(rejects_other_files, ImageFixture)
+{
+  {
+    RuleTableImageWriter writer(1);
+    writer.Write(path);
+  }
+  RuleTableImage image;
+  image.Open(path, true);
+  BOOST_CHECK_EQUAL(image.GetNumNodes(), 1);
+
+  FILE *file = fopen(path.c_str(), "r+");
+  fputs("not an image", file);
+  fclose(file);
+  RuleTableImage other;
+  BOOST_CHECK_THROW(other.Open(path, false), util::Exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
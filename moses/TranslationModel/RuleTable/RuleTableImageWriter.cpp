@@ -0,0 +1,388 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2016 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "RuleTableImageWriter.h"
+#include "moses/Util.h"
+#include "util/double-conversion/double-conversion.h"
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/tokenize_piece.hh"
+
+using namespace std;
+
+namespace Moses
+{
+
+using namespace RuleTableImageFormat;
+
+namespace
+{
+
+bool IsBracketed(const StringPiece &word)
+{
+  return word.size() >= 2 && word.data()[0] == '[' && word.data()[word.size() - 1] == ']';
+}
+
+// the label a "[source][target]" non-terminal has on one side, as in
+// Phrase::CreateFromString
+StringPiece NonTerminalLabel(const StringPiece &word, bool source)
+{
+  size_t nextPos = word.find('[', 1);
+  UTIL_THROW_IF2(nextPos == StringPiece::npos,
+                 "Incorrect formatting of non-terminal. Should have 2 non-terms, eg. [X][X]. "
+                 << "Current string: " << word);
+  return source ? word.substr(1, nextPos - 2) : word.substr(nextPos + 1, word.size() - nextPos - 2);
+}
+
+void Split(const StringPiece &phrase, vector<StringPiece> &out)
+{
+  out.clear();
+  for (util::TokenIter<util::AnyCharacter, true> it(phrase, "\t "); it; ++it) {
+    out.push_back(*it);
+  }
+}
+
+size_t ParseAlignmentPos(const StringPiece &str)
+{
+  char *endptr;
+  size_t ret = strtoul(str.data(), &endptr, 10);
+  UTIL_THROW_IF2(endptr != str.data() + str.size(), "Error parsing alignment " << str);
+  return ret;
+}
+
+template <class T> void Append(string &out, const T *data, size_t count)
+{
+  out.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+
+struct TerminalEdgeOrder {
+  bool operator()(const TerminalEdge &a, const TerminalEdge &b) const {
+    return a.word < b.word;
+  }
+};
+
+// must match the search in RuleTableImage::GetChild
+struct NonTerminalEdgeOrder {
+  bool operator()(const NonTerminalEdge &a, const NonTerminalEdge &b) const {
+    return a.targetLabel < b.targetLabel
+           || (a.targetLabel == b.targetLabel && a.sourceLabel < b.sourceLabel);
+  }
+};
+
+// the first numFactors factors of word, or all of it if numFactors is 0
+StringPiece FirstFactors(const StringPiece &word, size_t numFactors)
+{
+  if (numFactors == 0) {
+    return word;
+  }
+  size_t end = 0;
+  for (size_t i = 0; i < numFactors; ++i) {
+    end = word.find('|', end);
+    if (end == StringPiece::npos) {
+      return word;
+    }
+    if (i + 1 < numFactors) {
+      ++end;
+    }
+  }
+  return word.substr(0, end);
+}
+
+void Pad(string &out, size_t alignment)
+{
+  out.resize((out.size() + alignment - 1) / alignment * alignment, '\0');
+}
+
+}
+
+RuleTableImageWriter::RuleTableImageWriter(size_t numScores, size_t sourceFactors)
+  : m_numScores(numScores)
+  , m_sourceFactors(sourceFactors)
+{
+  CreateNode(kNone, kNone);
+}
+
+bool RuleTableImageWriter::AddRule(const StringPiece &line)
+{
+  util::TokenIter<util::MultiCharacter> pipes(line, "|||");
+  StringPiece sourceString(*pipes);
+  StringPiece targetString(*++pipes);
+  StringPiece scoreString(*++pipes);
+  StringPiece alignString, sparseString, propertiesString;
+  if (++pipes) alignString = *pipes;
+  ++pipes;  // skip over counts field
+  if (++pipes) sparseString = *pipes;
+  if (++pipes) propertiesString = *pipes;
+
+  if (sourceString.find_first_not_of(" \t") == StringPiece::npos) {
+    return false;
+  }
+
+  double_conversion::StringToDoubleConverter converter(double_conversion::StringToDoubleConverter::NO_FLAGS, NAN, NAN, "inf", "nan");
+  m_scores.clear();
+  for (util::TokenIter<util::AnyCharacter, true> s(scoreString, " \t"); s; ++s) {
+    int processed;
+    float score = converter.StringToFloat(s->data(), s->length(), &processed);
+    UTIL_THROW_IF2(std::isnan(score), "Bad score " << *s << " in rule " << line);
+    m_scores.push_back(FloorScore(TransformScore(score)));
+  }
+  UTIL_THROW_IF2(m_scores.size() != m_numScores,
+                 "Size of scoreVector != number (" << m_scores.size() << "!="
+                 << m_numScores << ") of score components in rule " << line);
+
+  // the source LHS is dropped, as in the memory phrase table
+  Split(sourceString, m_sourceWords);
+  if (IsBracketed(m_sourceWords.back())) {
+    m_sourceWords.pop_back();
+  }
+
+  Split(targetString, m_targetWords);
+  uint32_t lhs = kNone;
+  if (!m_targetWords.empty() && IsBracketed(m_targetWords.back())) {
+    const StringPiece &word = m_targetWords.back();
+    lhs = GetVocabId(m_targetIds, m_targetVocab, word.substr(1, word.size() - 2), true);
+    m_targetWords.pop_back();
+  }
+  UTIL_THROW_IF2(m_targetWords.size() > 0xFFFF, "Target phrase too long in rule " << line);
+
+  vector<uint32_t> targetIds(m_targetWords.size());
+  vector<bool> targetIsNonTerminal(m_targetWords.size());
+  for (size_t i = 0; i < m_targetWords.size(); ++i) {
+    const StringPiece &word = m_targetWords[i];
+    targetIsNonTerminal[i] = IsBracketed(word);
+    targetIds[i] = targetIsNonTerminal[i]
+                   ? GetVocabId(m_targetIds, m_targetVocab, NonTerminalLabel(word, false), true)
+                   : GetVocabId(m_targetIds, m_targetVocab, word, false);
+  }
+
+  m_alignment.clear();
+  vector<pair<size_t, size_t> > alignNonTerm;
+  for (util::TokenIter<util::AnyCharacter, true> token(alignString, " \t"); token; ++token) {
+    util::TokenIter<util::SingleCharacter, false> dash(*token, util::SingleCharacter('-'));
+    size_t sourcePos = ParseAlignmentPos(*dash);
+    size_t targetPos = ParseAlignmentPos(*++dash);
+    UTIL_THROW_IF2(++dash, "Extra gunk in alignment " << *token);
+    UTIL_THROW_IF2(targetPos >= m_targetWords.size() || sourcePos > 0xFFFF,
+                   "Alignment point " << *token << " out of range in rule " << line);
+    m_alignment.push_back(make_pair(uint16_t(sourcePos), uint16_t(targetPos)));
+    if (targetIsNonTerminal[targetPos]) {
+      alignNonTerm.push_back(make_pair(sourcePos, targetPos));
+    }
+  }
+  sort(alignNonTerm.begin(), alignNonTerm.end());
+  alignNonTerm.erase(unique(alignNonTerm.begin(), alignNonTerm.end()), alignNonTerm.end());
+
+  // walk down the trie as PhraseDictionaryMemory::GetOrCreateNode does
+  uint32_t node = 0;
+  vector<pair<size_t, size_t> >::const_iterator iterAlign = alignNonTerm.begin();
+  for (size_t pos = 0; pos < m_sourceWords.size(); ++pos) {
+    const StringPiece &word = m_sourceWords[pos];
+    if (IsBracketed(word)) {
+      UTIL_THROW_IF2(iterAlign == alignNonTerm.end(),
+                     "No alignment for non-term at position " << pos);
+      UTIL_THROW_IF2(iterAlign->first != pos,
+                     "Alignment info incorrect at position " << pos);
+      uint32_t sourceLabel = GetVocabId(m_sourceIds, m_sourceVocab, NonTerminalLabel(word, true), true);
+      node = GetOrCreateNonTerminalChild(node, sourceLabel, targetIds[iterAlign->second]);
+      ++iterAlign;
+    } else {
+      node = GetOrCreateTerminalChild(node, GetVocabId(m_sourceIds, m_sourceVocab,
+                                      FirstFactors(word, m_sourceFactors), false));
+    }
+  }
+
+  UTIL_THROW_IF2(m_ruleRefs.size() == kNone, "Too many rules for a rule table image");
+  m_ruleRefs.push_back(make_pair(node, uint64_t(m_rules.size())));
+
+  RuleHeader header;
+  header.lhs = lhs;
+  header.numWords = targetIds.size();
+  header.numAlignments = m_alignment.size();
+  header.sparseSize = sparseString.size();
+  header.propertiesSize = propertiesString.size();
+  Append(m_rules, &header, 1);
+  Append(m_rules, &m_scores[0], m_scores.size());
+  if (!targetIds.empty()) Append(m_rules, &targetIds[0], targetIds.size());
+  for (size_t i = 0; i < m_alignment.size(); ++i) {
+    uint16_t point[2] = { m_alignment[i].first, m_alignment[i].second };
+    Append(m_rules, point, 2);
+  }
+  m_rules.append(sparseString.data(), sparseString.size());
+  m_rules.append(propertiesString.data(), propertiesString.size());
+  Pad(m_rules, 4);
+  return true;
+}
+
+uint32_t RuleTableImageWriter::GetVocabId(VocabIds &ids, vector<VocabEntry> &vocab,
+    const StringPiece &word, bool isNonTerminal)
+{
+  string key;
+  key.reserve(word.size() + 1);
+  key += isNonTerminal ? 'N' : 'T';
+  key.append(word.data(), word.size());
+  pair<VocabIds::iterator, bool> ins = ids.insert(make_pair(key, uint32_t(vocab.size())));
+  if (ins.second) {
+    UTIL_THROW_IF2(vocab.size() == kNone, "Vocabulary too large for a rule table image");
+    VocabEntry entry;
+    entry.string = m_strings.size();
+    entry.isNonTerminal = isNonTerminal;
+    entry.reserved = 0;
+    vocab.push_back(entry);
+    m_strings.append(word.data(), word.size());
+    m_strings += '\0';
+  }
+  return ins.first->second;
+}
+
+uint32_t RuleTableImageWriter::CreateNode(uint32_t parent, uint32_t word)
+{
+  UTIL_THROW_IF2(m_nodes.size() == kNone, "Too many nodes for a rule table image");
+  Node node;
+  memset(&node, 0, sizeof(node));
+  node.parent = parent;
+  node.word = word;
+  m_nodes.push_back(node);
+  return m_nodes.size() - 1;
+}
+
+uint32_t RuleTableImageWriter::GetOrCreateTerminalChild(uint32_t parent, uint32_t word)
+{
+  uint64_t key = (uint64_t(parent) << 32) | word;
+  boost::unordered_map<uint64_t, uint32_t>::const_iterator iter = m_terminals.find(key);
+  if (iter != m_terminals.end()) return iter->second;
+  uint32_t child = CreateNode(parent, word);
+  m_terminals[key] = child;
+  return child;
+}
+
+uint32_t RuleTableImageWriter::GetOrCreateNonTerminalChild(uint32_t parent, uint32_t sourceLabel, uint32_t targetLabel)
+{
+  pair<uint64_t, uint32_t> key((uint64_t(parent) << 32) | targetLabel, sourceLabel);
+  boost::unordered_map<pair<uint64_t, uint32_t>, uint32_t>::const_iterator iter = m_nonTerminals.find(key);
+  if (iter != m_nonTerminals.end()) return iter->second;
+  uint32_t child = CreateNode(parent, sourceLabel);
+  m_nonTerminals[key] = child;
+  return child;
+}
+
+void RuleTableImageWriter::Write(const std::string &path) const
+{
+  vector<Node> nodes(m_nodes);
+
+  // group the edges and rules by node: count, take prefix sums, fill
+  vector<TerminalEdge> terminals(m_terminals.size());
+  vector<NonTerminalEdge> nonTerminals(m_nonTerminals.size());
+  vector<uint64_t> ruleIndex(m_ruleRefs.size());
+  for (boost::unordered_map<uint64_t, uint32_t>::const_iterator p = m_terminals.begin(); p != m_terminals.end(); ++p) {
+    ++nodes[p->first >> 32].numTerminals;
+  }
+  for (boost::unordered_map<pair<uint64_t, uint32_t>, uint32_t>::const_iterator p = m_nonTerminals.begin(); p != m_nonTerminals.end(); ++p) {
+    ++nodes[p->first.first >> 32].numNonTerminals;
+  }
+  for (size_t i = 0; i < m_ruleRefs.size(); ++i) {
+    ++nodes[m_ruleRefs[i].first].numRules;
+  }
+  uint32_t terminalPos = 0, nonTerminalPos = 0, rulePos = 0;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    nodes[i].firstTerminal = terminalPos;
+    nodes[i].firstNonTerminal = nonTerminalPos;
+    nodes[i].firstRule = rulePos;
+    terminalPos += nodes[i].numTerminals;
+    nonTerminalPos += nodes[i].numNonTerminals;
+    rulePos += nodes[i].numRules;
+    // reused as fill counters below
+    nodes[i].numTerminals = nodes[i].numNonTerminals = nodes[i].numRules = 0;
+  }
+  for (boost::unordered_map<uint64_t, uint32_t>::const_iterator p = m_terminals.begin(); p != m_terminals.end(); ++p) {
+    Node &parent = nodes[p->first >> 32];
+    TerminalEdge &edge = terminals[parent.firstTerminal + parent.numTerminals++];
+    edge.word = uint32_t(p->first);
+    edge.node = p->second;
+  }
+  for (boost::unordered_map<pair<uint64_t, uint32_t>, uint32_t>::const_iterator p = m_nonTerminals.begin(); p != m_nonTerminals.end(); ++p) {
+    Node &parent = nodes[p->first.first >> 32];
+    NonTerminalEdge &edge = nonTerminals[parent.firstNonTerminal + parent.numNonTerminals++];
+    edge.targetLabel = uint32_t(p->first.first);
+    edge.sourceLabel = p->first.second;
+    edge.node = p->second;
+  }
+  // rules keep the order of the text table within each node
+  for (size_t i = 0; i < m_ruleRefs.size(); ++i) {
+    Node &node = nodes[m_ruleRefs[i].first];
+    ruleIndex[node.firstRule + node.numRules++] = m_ruleRefs[i].second;
+  }
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const Node &node = nodes[i];
+    sort(terminals.begin() + node.firstTerminal, terminals.begin() + node.firstTerminal + node.numTerminals,
+         TerminalEdgeOrder());
+    sort(nonTerminals.begin() + node.firstNonTerminal, nonTerminals.begin() + node.firstNonTerminal + node.numNonTerminals,
+         NonTerminalEdgeOrder());
+  }
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byteOrder = kByteOrderMark;
+  header.numScores = m_numScores;
+  header.sourceFactors = m_sourceFactors;
+
+  const char *data[NumSections];
+  data[Strings] = m_strings.data();
+  header.size[Strings] = m_strings.size();
+  data[SourceVocab] = reinterpret_cast<const char*>(m_sourceVocab.empty() ? NULL : &m_sourceVocab[0]);
+  header.size[SourceVocab] = m_sourceVocab.size() * sizeof(VocabEntry);
+  data[TargetVocab] = reinterpret_cast<const char*>(m_targetVocab.empty() ? NULL : &m_targetVocab[0]);
+  header.size[TargetVocab] = m_targetVocab.size() * sizeof(VocabEntry);
+  data[Nodes] = reinterpret_cast<const char*>(&nodes[0]);
+  header.size[Nodes] = nodes.size() * sizeof(Node);
+  data[TerminalEdges] = reinterpret_cast<const char*>(terminals.empty() ? NULL : &terminals[0]);
+  header.size[TerminalEdges] = terminals.size() * sizeof(TerminalEdge);
+  data[NonTerminalEdges] = reinterpret_cast<const char*>(nonTerminals.empty() ? NULL : &nonTerminals[0]);
+  header.size[NonTerminalEdges] = nonTerminals.size() * sizeof(NonTerminalEdge);
+  data[RuleIndex] = reinterpret_cast<const char*>(ruleIndex.empty() ? NULL : &ruleIndex[0]);
+  header.size[RuleIndex] = ruleIndex.size() * sizeof(uint64_t);
+  data[Rules] = m_rules.data();
+  header.size[Rules] = m_rules.size();
+
+  uint64_t offset = sizeof(Header);
+  for (size_t i = 0; i < NumSections; ++i) {
+    offset = (offset + 7) / 8 * 8;
+    header.offset[i] = offset;
+    offset += header.size[i];
+  }
+
+  util::scoped_fd file(util::CreateOrThrow(path.c_str()));
+  util::WriteOrThrow(file.get(), &header, sizeof(header));
+  uint64_t written = sizeof(Header);
+  const char padding[8] = { 0 };
+  for (size_t i = 0; i < NumSections; ++i) {
+    util::WriteOrThrow(file.get(), padding, header.offset[i] - written);
+    if (header.size[i]) util::WriteOrThrow(file.get(), data[i], header.size[i]);
+    written = header.offset[i] + header.size[i];
+  }
+}
+
+}
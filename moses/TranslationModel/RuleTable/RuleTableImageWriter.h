@@ -0,0 +1,99 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2016 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/unordered_map.hpp>
+
+#include "RuleTableImage.h"
+#include "util/string_piece.hh"
+
+namespace Moses
+{
+
+/** Builds a RuleTableImage from the lines of a Moses-format text rule table,
+ * producing the trie that RuleTableLoaderStandard would build.
+ *
+ * Words are kept as the strings in the table; splitting them into factors
+ * is left to the decoder. With sourceFactors, source terminals are cut to
+ * their first sourceFactors '|'-separated factors, so that words which only
+ * differ in factors the decoder ignores share a node, as they do in the
+ * text loader. Scores are log-transformed here, but rules are neither sorted
+ * nor pruned, as both depend on the weights.
+ */
+class RuleTableImageWriter
+{
+public:
+  explicit RuleTableImageWriter(size_t numScores, size_t sourceFactors = 0);
+
+  //! returns false if the line was skipped because its source side is empty
+  bool AddRule(const StringPiece &line);
+
+  void Write(const std::string &path) const;
+
+  size_t GetNumRules() const {
+    return m_ruleRefs.size();
+  }
+  size_t GetNumNodes() const {
+    return m_nodes.size();
+  }
+
+private:
+  typedef RuleTableImageFormat::Node Node;
+  typedef RuleTableImageFormat::TerminalEdge TerminalEdge;
+  typedef RuleTableImageFormat::NonTerminalEdge NonTerminalEdge;
+
+  //! vocabulary ids by word string, with a leading 'T' or 'N' for terminals and non-terminals
+  typedef boost::unordered_map<std::string, uint32_t> VocabIds;
+
+  size_t m_numScores;
+  size_t m_sourceFactors;
+
+  std::string m_strings;
+  std::vector<RuleTableImageFormat::VocabEntry> m_sourceVocab, m_targetVocab;
+  VocabIds m_sourceIds, m_targetIds;
+
+  // edges are collected in hash maps while rules arrive in any order, and
+  // grouped by parent when the image is written
+  std::vector<Node> m_nodes;
+  boost::unordered_map<uint64_t, uint32_t> m_terminals; //! (parent, word) -> child
+  boost::unordered_map<std::pair<uint64_t, uint32_t>, uint32_t> m_nonTerminals; //! ((parent, target label), source label) -> child
+
+  std::string m_rules;
+  std::vector<std::pair<uint32_t, uint64_t> > m_ruleRefs; //! (node, offset in m_rules)
+
+  // reused buffers
+  std::vector<StringPiece> m_sourceWords, m_targetWords;
+  std::vector<float> m_scores;
+  std::vector<std::pair<uint16_t, uint16_t> > m_alignment;
+
+  uint32_t GetVocabId(VocabIds &ids, std::vector<RuleTableImageFormat::VocabEntry> &vocab,
+                      const StringPiece &word, bool isNonTerminal);
+  uint32_t GetOrCreateTerminalChild(uint32_t parent, uint32_t word);
+  uint32_t GetOrCreateNonTerminalChild(uint32_t parent, uint32_t sourceLabel, uint32_t targetLabel);
+  uint32_t CreateNode(uint32_t parent, uint32_t word);
+};
+
+}
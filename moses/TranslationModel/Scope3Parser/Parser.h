@@ -62,6 +62,11 @@ public:
     size_t last,
     ChartParserCallback &outColl);
 
+  //! rule applications are found for all spans up front
+  bool SupportsWidthOrder() const {
+    return true;
+  }
+
 private:
   // Define a callback type for use by StackLatticeSearcher.
   struct MatchCallback {
@@ -18,29 +18,24 @@ void SkeletonPT::Load(AllOptions::ptr const& opts)
   SetFeaturesToApply();
 }
 
-void SkeletonPT::InitializeForInput(ttasksptr const& ttask)
-{
-  ReduceCache();
-}
-
 void SkeletonPT::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
 {
-  CacheColl &cache = GetCache();
+  PhraseTableCache &cache = GetCache();
 
   InputPathList::const_iterator iter;
   for (iter = inputPathQueue.begin(); iter != inputPathQueue.end(); ++iter) {
     InputPath &inputPath = **iter;
     const Phrase &sourcePhrase = inputPath.GetPhrase();
 
-    TargetPhrase *tp = CreateTargetPhrase(sourcePhrase);
-    TargetPhraseCollection::shared_ptr tpColl(new TargetPhraseCollection);
-    tpColl->Add(tp);
-
-    // add target phrase to phrase-table cache
+    // the phrase-table cache is shared by all threads
     size_t hash = hash_value(sourcePhrase);
-    std::pair<TargetPhraseCollection::shared_ptr, clock_t>
-    value(tpColl, clock());
-    cache[hash] = value;
+    TargetPhraseCollection::shared_ptr tpColl;
+    if (!cache.Get(hash, tpColl)) {
+      TargetPhrase *tp = CreateTargetPhrase(sourcePhrase);
+      tpColl.reset(new TargetPhraseCollection);
+      tpColl->Add(tp);
+      cache.Put(hash, tpColl);
+    }
 
     inputPath.SetTargetPhrases(*this, tpColl, NULL);
   }
@@ -18,7 +18,6 @@ public:
 
   void Load(AllOptions::ptr const& opts);
 
-  void InitializeForInput(ttasksptr const& ttask);
 
   // for phrase-based model
   void GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const;
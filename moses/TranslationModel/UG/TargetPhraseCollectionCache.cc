@@ -1,23 +1,49 @@
 #include "TargetPhraseCollectionCache.h"
+#include <algorithm>
 
 namespace Moses
 {
   using std::vector;
 
   TPCollCache::
-  TPCollCache(size_t capacity)
+  TPCollCache(size_t capacity, size_t num_shards)
+  {
+    UTIL_THROW_IF2(capacity <= 2, "Cache capacity must be > 1!");
+    // each shard must hold at least three items
+    m_num_shards = std::max(size_t(1), std::min(num_shards, capacity / 3));
+    m_shards.reset(new Shard[m_num_shards]);
+    for (size_t i = 0; i < m_num_shards; ++i)
+      m_shards[i].setCapacity((capacity + m_num_shards - 1) / m_num_shards);
+  }
+
+  SPTR<TPCollWrapper>
+  TPCollCache::
+  get(uint64_t key, size_t revision)
+  {
+    // phrase keys are (shifted) offsets into the suffix array, so mix the
+    // bits before picking a shard
+    uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+    return m_shards[(h >> 32) % m_num_shards].get(key, revision);
+  }
+
+  TPCollCache::Shard::
+  Shard() : m_capacity(0)
   {
     m_qfirst = m_qlast = m_cache.end();
+  }
+
+  void
+  TPCollCache::Shard::
+  setCapacity(uint32_t capacity)
+  {
     m_capacity = capacity;
-    UTIL_THROW_IF2(m_capacity <= 2, "Cache capacity must be > 1!");
   }
 
   SPTR<TPCollWrapper>
-  TPCollCache::
+  TPCollCache::Shard::
   get(uint64_t key, size_t revision)
   {
-    using namespace boost;
-    unique_lock<shared_mutex> lock(m_lock);
+    boost::unique_lock<boost::mutex> lock(m_lock);
 
 #if 0
     size_t ctr=0;
@@ -92,7 +118,7 @@ namespace Moses
 	// if (oldsize > m_cache.size()) std::cerr << "\n" << std::endl;
       }
     return ret;
-  } // TPCollCache::get(...)
+  } // TPCollCache::Shard::get(...)
   
   TPCollWrapper::
   TPCollWrapper(uint64_t key_, size_t revision_)
@@ -3,24 +3,39 @@
 #include <time.h>
 #include "moses/TargetPhraseCollection.h"
 #include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
 #include "mm/ug_typedefs.h"
 namespace Moses
 {
 
   class TPCollWrapper;
 
+  // The cache is split into shards by phrase key. Each shard has its own
+  // lock and LRU queue, so that concurrent lookups (from all decoder
+  // threads and all sessions sharing the cache) only wait for each other
+  // when they hit the same shard.
   class TPCollCache
   {
   public:
     // typedef boost::unordered_map<uint64_t, SPTR<TPCollWrapper> > cache_t;
     typedef std::map<uint64_t, SPTR<TPCollWrapper> > cache_t;
   private:
-    uint32_t m_capacity; // capacity of cache
-    cache_t     m_cache; // maps from ids to items
-    cache_t::iterator m_qfirst, m_qlast;
-    mutable boost::shared_mutex  m_lock; 
+    class Shard
+    {
+      uint32_t m_capacity; // capacity of shard
+      cache_t     m_cache; // maps from ids to items
+      cache_t::iterator m_qfirst, m_qlast;
+      boost::mutex m_lock;
+    public:
+      Shard();
+      void setCapacity(uint32_t capacity);
+      SPTR<TPCollWrapper> get(uint64_t key, size_t revision);
+    };
+
+    size_t m_num_shards;
+    boost::scoped_array<Shard> m_shards;
   public:
-    TPCollCache(size_t capacity=10000);
+    TPCollCache(size_t capacity=10000, size_t num_shards=64);
 
     SPTR<TPCollWrapper>
     get(uint64_t key, size_t revision);
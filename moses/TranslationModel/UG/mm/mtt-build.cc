@@ -28,6 +28,7 @@
 #include "ug_deptree.h"
 #include "moses/TranslationModel/UG/generic/sorting/VectorIndexSorter.h"
 #include "moses/TranslationModel/UG/mm/ug_im_tsa.h"
+#include "moses/TranslationModel/UG/mm/ug_mm_tsa_builder.h"
 
 using namespace std;
 using namespace sapt;
@@ -43,6 +44,8 @@ int with_sfas;
 bool incremental = false; // build / grow vocabs automatically
 bool is_conll    = false; // text or conll format?
 bool quiet       = false; // no progress reporting
+size_t threads   = 0;     // for sorting; 0: one per core
+size_t sort_mem  = 0;     // MB for sorting; 0: sort everything in memory
 
 string vocabBase; // base name for existing vocabs that should be used
 string baseName;  // base name for all files
@@ -367,7 +370,14 @@ build_mmTSA(string infile, string outfile)
   boost::shared_ptr<mmTtrack<Token> > T(new mmTtrack<Token>(infile));
   bdBitset filter;
   filter.resize(T->size(),true);
-  imTSA<Token> S(T,&filter,(quiet?NULL:&cerr));
+  if (sort_mem)
+    {
+      size_t entries = (sort_mem << 20) / sizeof(ttrack::Position);
+      mmTsaBuilder<Token> B(T,&filter,entries,threads,(quiet?NULL:&cerr));
+      B.save_as_mm_tsa(outfile);
+      return;
+    }
+  imTSA<Token> S(T,&filter,(quiet?NULL:&cerr),threads);
   S.save_as_mm_tsa(outfile);
   // exit(0);
 }
@@ -469,6 +479,13 @@ interpret_args(int ac, char* av[])
     ("unk,u", po::value<string>(&UNK)->default_value("UNK"),
      "label for unknown tokens")
 
+    ("threads,t", po::value<size_t>(&threads)->default_value(0),
+     "number of threads for sorting (0: one per core)")
+
+    ("sort-memory,M", po::value<size_t>(&sort_mem)->default_value(0),
+     "memory in MB for the suffix arrays; larger sections are sorted in "
+     "runs on disk and merged (0: sort everything in memory)")
+
     // ("map,m", po::value<string>(&vmap),
     // "map words to word classes for indexing")
 
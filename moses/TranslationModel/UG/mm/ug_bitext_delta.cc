@@ -0,0 +1,112 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#include "ug_bitext_delta.h"
+
+#include <fcntl.h>
+#include <cstring>
+#include <fstream>
+
+#include "util/exception.hh"
+#include "util/mmap.hh"
+
+namespace sapt
+{
+  BitextDelta::
+  BitextDelta(std::string const& fname)
+    : m_fname(fname)
+    , m_fd(open(fname.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644))
+  {
+    UTIL_THROW_IF2(m_fd.get() == -1, "Could not open delta file " << fname);
+    m_size = util::SizeOrThrow(m_fd.get());
+    if (m_size)
+      {
+        util::scoped_memory mem;
+        util::MapRead(util::LAZY, m_fd.get(), 0, m_size, mem);
+        char const* p = reinterpret_cast<char const*>(mem.get());
+        uint64_t end = m_size;
+        while (end && p[end-1] != '\n') --end;
+        if (end < m_size) // drop torn line from an interrupted append
+          {
+            util::ResizeOrThrow(m_fd.get(), end);
+            m_size = end;
+          }
+      }
+  }
+
+  size_t
+  BitextDelta::
+  read(uint64_t start,
+       std::vector<std::string>& s1,
+       std::vector<std::string>& s2,
+       std::vector<std::string>& aln) const
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    UTIL_THROW_IF2(start > m_size, "Delta file " << m_fname << " has only "
+                   << m_size << " bytes, but the static bitext claims to "
+                   << "contain " << start);
+    if (start == m_size) return 0;
+
+    util::scoped_memory mem;
+    util::MapRead(util::LAZY, m_fd.get(), 0, m_size, mem);
+    char const* base = reinterpret_cast<char const*>(mem.get());
+    char const* p = base + start;
+    char const* stop = base + m_size;
+    size_t ret = 0;
+    while (p < stop)
+      {
+        char const* eol = static_cast<char const*>(memchr(p, '\n', stop - p));
+        char const* t1 = static_cast<char const*>(memchr(p, '\t', eol - p));
+        char const* t2 = t1 ? static_cast<char const*>(memchr(t1+1, '\t', eol - t1 - 1)) : NULL;
+        UTIL_THROW_IF2(!t2, "Malformed line in delta file " << m_fname
+                       << " at byte " << (p - base));
+        s1.push_back(std::string(p, t1));
+        s2.push_back(std::string(t1 + 1, t2));
+        aln.push_back(std::string(t2 + 1, eol));
+        p = eol + 1;
+        ++ret;
+      }
+    return ret;
+  }
+
+  void
+  BitextDelta::
+  append(std::vector<std::string> const& s1,
+         std::vector<std::string> const& s2,
+         std::vector<std::string> const& aln)
+  {
+    UTIL_THROW_IF2(s1.size() != s2.size() || s1.size() != aln.size(),
+                   "Number of sentences and alignments differ");
+    std::string buf;
+    for (size_t i = 0; i < s1.size(); ++i)
+      {
+        UTIL_THROW_IF2(s1[i].find_first_of("\t\n") != std::string::npos ||
+                       s2[i].find_first_of("\t\n") != std::string::npos ||
+                       aln[i].find_first_of("\t\n") != std::string::npos,
+                       "Tab or newline in sentence pair added to bitext");
+        buf += s1[i]; buf += '\t';
+        buf += s2[i]; buf += '\t';
+        buf += aln[i]; buf += '\n';
+      }
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    util::WriteOrThrow(m_fd.get(), buf.data(), buf.size());
+    util::FSyncOrThrow(m_fd.get());
+    m_size += buf.size();
+  }
+
+  uint64_t
+  BitextDelta::
+  size() const
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    return m_size;
+  }
+
+  uint64_t
+  delta_offset(std::string const& base,
+               std::string const& L1, std::string const& L2)
+  {
+    uint64_t ret = 0;
+    std::ifstream in((base + L1 + "-" + L2 + ".delta-offset").c_str());
+    if (in) in >> ret;
+    return ret;
+  }
+}
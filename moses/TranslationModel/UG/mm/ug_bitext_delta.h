@@ -0,0 +1,54 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#pragma once
+
+#include <string>
+#include <vector>
+#include <boost/thread.hpp>
+#include "util/file.hh"
+
+namespace sapt
+{
+  // Append-only file of the sentence pairs added to a dynamic bitext, so
+  // that they survive a restart without rebuilding the static bitext.
+  // Each pair is one line: source sentence, target sentence and word
+  // alignment, separated by tabs. Lines are only ever appended (and
+  // synced to disk before the pair becomes visible to lookups), so after
+  // a crash the file is complete up to its last full line; a torn line at
+  // the end is cut off when the file is opened again.
+  //
+  // A compacted static bitext records how many bytes of the file it
+  // already contains (see scripts/training/compact-mmsapt-delta.perl);
+  // only the rest needs to be replayed into the dynamic bitext.
+  class BitextDelta
+  {
+    std::string m_fname;
+    util::scoped_fd m_fd;
+    uint64_t m_size; // bytes up to and including the last complete line
+    mutable boost::mutex m_lock;
+  public:
+    BitextDelta(std::string const& fname); // opens or creates the file
+
+    // read all pairs from byte offset /start/ on; returns number of pairs
+    size_t
+    read(uint64_t start,
+         std::vector<std::string>& s1,
+         std::vector<std::string>& s2,
+         std::vector<std::string>& aln) const;
+
+    // append pairs and sync them to disk
+    void
+    append(std::vector<std::string> const& s1,
+           std::vector<std::string> const& s2,
+           std::vector<std::string> const& aln);
+
+    uint64_t size() const; // in bytes
+
+    std::string const& name() const { return m_fname; }
+  };
+
+  // byte offset into the delta file up to which the static bitext
+  // /base/ already contains the sentence pairs (0 if not compacted)
+  uint64_t
+  delta_offset(std::string const& base,
+               std::string const& L1, std::string const& L2);
+}
@@ -3,9 +3,7 @@
 #ifndef _ug_im_tsa_h
 #define _ug_im_tsa_h
 
-// TO DO:
-// - multi-threaded sorting during TSA construction (currently painfully slow!)
-
+#include <algorithm>
 #include <iostream>
 
 #include <boost/iostreams/device/mapped_file.hpp>
@@ -51,6 +49,101 @@ namespace sapt
     
   };
 
+  // merges two adjacent sorted runs [begin,middle) and [middle,end)
+  template<typename TOKEN, typename SORTER>
+  class TsaMerger
+  {
+  public:
+    typedef typename Ttrack<TOKEN>::Position cpos;
+    typedef typename std::vector<cpos>::iterator iter;
+  private:
+    SORTER m_sorter;
+    iter m_begin;
+    iter m_middle;
+    iter m_end;
+  public:
+    TsaMerger(SORTER sorter, iter begin, iter middle, iter end)
+      : m_sorter(sorter),
+        m_begin(begin),
+        m_middle(middle),
+        m_end(end) { }
+
+    bool
+    operator()()
+    {
+      std::inplace_merge(m_begin, m_middle, m_end, m_sorter);
+      return true;
+    }
+
+  };
+
+  // Sorts each section [sections[i],sections[i+1]) of sufa on its own.
+  // Sections are sorted in parallel. The most frequent words have sections
+  // far larger than the average share of a thread, so these are cut into
+  // chunks that are sorted in parallel and then merged pairwise, each round
+  // of merges again in parallel. Ties are broken by position (see LESS), so
+  // the result is the same for any number of threads.
+  template<typename TOKEN, typename SORTER>
+  void
+  sort_tsa_sections(std::vector<typename Ttrack<TOKEN>::Position>& sufa,
+                    std::vector<filepos_type> const& sections,
+                    SORTER sorter, size_t threads, std::ostream* log = NULL)
+  {
+    if (threads == 0)
+      threads = boost::thread::hardware_concurrency();
+    size_t chunk = std::max(sufa.size() / (4 * threads) + 1, size_t(1) << 16);
+    std::vector<std::vector<size_t> > runs; // chunk boundaries of cut sections
+
+    boost::scoped_ptr<ug::ThreadPool> tpool;
+    tpool.reset(new ug::ThreadPool(threads));
+    for (size_t i = 0; i + 1 < sections.size(); i++)
+      {
+        size_t const n = sections[i+1] - sections[i];
+        if (n > 1)
+	  {
+            std::vector<size_t> bounds(1, sections[i]);
+            size_t pieces = threads > 1 ? (n + chunk - 1) / chunk : 1;
+            for (size_t k = 1; k <= pieces; ++k)
+              bounds.push_back(sections[i] + n * k / pieces);
+            for (size_t k = 1; k < bounds.size(); ++k)
+              {
+                typename std::vector<typename Ttrack<TOKEN>::Position>::iterator b,e;
+                b = sufa.begin()+bounds[k-1];
+                e = sufa.begin()+bounds[k];
+                TsaSorter<TOKEN,SORTER> foo(sorter,b,e);
+                tpool->add(foo);
+              }
+            if (pieces > 1) runs.push_back(bounds);
+	  }
+      }
+    tpool.reset();
+
+    while (runs.size())
+      {
+        if (log) *log << "merging chunks of " << runs.size()
+                      << " sections" << std::endl;
+        tpool.reset(new ug::ThreadPool(threads));
+        std::vector<std::vector<size_t> > next;
+        for (size_t i = 0; i < runs.size(); ++i)
+          {
+            std::vector<size_t> const& bounds = runs[i];
+            std::vector<size_t> merged(1, bounds[0]);
+            for (size_t k = 2; k < bounds.size(); k += 2)
+              {
+                TsaMerger<TOKEN,SORTER>
+                  foo(sorter, sufa.begin()+bounds[k-2],
+                      sufa.begin()+bounds[k-1], sufa.begin()+bounds[k]);
+                tpool->add(foo);
+                merged.push_back(bounds[k]);
+              }
+            if (bounds.size() % 2 == 0) // odd number of runs
+              merged.push_back(bounds.back());
+            if (merged.size() > 2) next.push_back(merged);
+          }
+        tpool.reset();
+        runs.swap(next);
+      }
+  }
 
  //-----------------------------------------------------------------------
   template<typename TOKEN>
@@ -230,30 +323,14 @@ namespace sapt
 #ifndef NO_MOSES
     double start_time = util::WallTime();
 #endif
-    boost::scoped_ptr<ug::ThreadPool> tpool;
-    tpool.reset(new ug::ThreadPool(threads));
-    
     index.resize(wcnt.size()+1,0);
-    typedef typename ttrack::Position::LESS<Ttrack<TOKEN> > sorter_t;
-    sorter_t sorter(c.get());
     for (size_t i = 0; i < wcnt.size(); i++)
       {
-        // if (log && wcnt[i] > 5000)
-        //   *log << "sorting " << wcnt[i]
-        //        << " entries starting with id " << i << "." << std::endl;
         index[i+1] = index[i]+wcnt[i];
         assert(index[i+1]==tmp[i]); // sanity check
-        if (wcnt[i]>1)
-	  {
-	    typename std::vector<cpos>::iterator b,e;
-	    b = sufa.begin()+index[i];
-	    e = sufa.begin()+index[i+1];
-	    TsaSorter<TOKEN,sorter_t> foo(sorter,b,e);
-	    tpool->add(foo);
-	    // sort(sufa.begin()+index[i],sufa.begin()+index[i+1],sorter);
-	  }
       }
-    tpool.reset();
+    typedef typename ttrack::Position::LESS<Ttrack<TOKEN> > sorter_t;
+    sort_tsa_sections<TOKEN>(sufa, index, sorter_t(c.get()), threads, log);
 #ifndef NO_MOSES
     if (log) *log << "Done sorting after " << util::WallTime() - start_time
 		  << " seconds." << std::endl;
@@ -0,0 +1,323 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+// Builds a memory-mapped suffix array (the format written by
+// imTSA::save_as_mm_tsa) with a bounded amount of memory.
+#ifndef _ug_mm_tsa_builder_h
+#define _ug_mm_tsa_builder_h
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "ug_im_tsa.h"
+#include "util/exception.hh"
+
+namespace sapt
+{
+  // Write the suffix array of the sentences in c selected by filter to
+  // fname, holding at most maxEntries positions in memory at a time.
+  //
+  // Positions are sorted in batches of consecutive first-token sections that
+  // fit into maxEntries, one pass over the corpus per batch. A section that
+  // alone is larger than maxEntries is sorted in runs of maxEntries
+  // positions that are spilled to fname + ".runs" and merged from there.
+  // LESS is a total order, so the file is identical to the one written by
+  // imTSA::save_as_mm_tsa. Besides the positions, memory use is
+  // proportional to the vocabulary size and the number of runs, and the
+  // corpus itself is only read. Note that with several threads the merges
+  // in sort_tsa_sections may briefly need a buffer as large as the section
+  // being merged.
+  template<typename TOKEN>
+  class mmTsaBuilder
+  {
+    typedef typename Ttrack<TOKEN>::Position cpos;
+    typedef typename ttrack::Position::LESS<Ttrack<TOKEN> > sorter_t;
+
+    // a sorted run in the spill file, read back through a small buffer
+    class Run
+    {
+      std::FILE* m_file;
+      ::uint64_t m_pos, m_end; // next and last entry in the file
+      std::vector<cpos> m_buf;
+      size_t m_next;
+    public:
+      Run(std::FILE* file, ::uint64_t start, ::uint64_t end, size_t bufsize)
+        : m_file(file), m_pos(start), m_end(end), m_next(0)
+      {
+        m_buf.reserve(bufsize);
+        fill();
+      }
+
+      bool empty() const { return m_next == m_buf.size(); }
+      cpos const& top() const { return m_buf[m_next]; }
+
+      void
+      pop()
+      {
+        if (++m_next == m_buf.size()) fill();
+      }
+
+    private:
+      void
+      fill()
+      {
+        size_t n = std::min(::uint64_t(m_buf.capacity()), m_end - m_pos);
+        m_buf.resize(n);
+        m_next = 0;
+        if (n == 0) return;
+        UTIL_THROW_IF2(fseeko(m_file, m_pos * sizeof(cpos), SEEK_SET)
+                       || std::fread(&m_buf[0], sizeof(cpos), n, m_file) != n,
+                       "Could not read back a sorted run");
+        m_pos += n;
+      }
+    };
+
+    // orders runs by their smallest remaining entry, smallest on top
+    class RunGreater
+    {
+      sorter_t m_sorter;
+    public:
+      RunGreater(sorter_t const& sorter) : m_sorter(sorter) { }
+      bool operator()(Run* a, Run* b) const
+      { return m_sorter(b->top(), a->top()); }
+    };
+
+    boost::shared_ptr<Ttrack<TOKEN> const> m_corpus;
+    bdBitset const* m_filter;
+    size_t m_maxEntries;
+    size_t m_threads;
+    std::ostream* m_log;
+    sorter_t m_sorter;
+
+    static int const slimit = 65536; // see the imTSA constructor
+
+    template<typename VISITOR>
+    void scan(id_type lo, id_type hi, VISITOR& visit) const;
+
+    void write(std::ostream& out, std::vector<cpos> const& sufa,
+               size_t begin, size_t end) const;
+
+    void write_section(std::ostream& out, id_type wid, count_type count,
+                       std::string const& spillfile) const;
+
+  public:
+    mmTsaBuilder(boost::shared_ptr<Ttrack<TOKEN> const> c,
+                 bdBitset const* filter, size_t maxEntries,
+                 size_t threads = 0, std::ostream* log = NULL)
+      : m_corpus(c), m_filter(filter), m_maxEntries(std::max(maxEntries, size_t(2)))
+      , m_threads(threads), m_log(log), m_sorter(c.get())
+    { }
+
+    void save_as_mm_tsa(std::string const& fname) const;
+  };
+
+  // Puts the positions of the tokens with ids in [lo,hi) into their
+  // section of a buffer.
+  template<typename TOKEN>
+  struct mmTsaBatchFiller
+  {
+    typedef typename Ttrack<TOKEN>::Position cpos;
+    std::vector<cpos>& sufa;
+    std::vector<filepos_type> next; // insertion point per section
+    id_type lo;
+
+    mmTsaBatchFiller(std::vector<cpos>& s, std::vector<filepos_type> const& sections,
+                     id_type l)
+      : sufa(s), next(sections), lo(l) { }
+
+    void operator()(id_type wid, cpos const& p)
+    { sufa[next[wid - lo]++] = p; }
+  };
+
+  // Collects the positions of one token in runs of at most maxEntries and
+  // spills full runs to a file.
+  template<typename TOKEN, typename SORTER>
+  struct mmTsaRunSpiller
+  {
+    typedef typename Ttrack<TOKEN>::Position cpos;
+    std::vector<cpos> buf;
+    std::vector< ::uint64_t> runs; // run boundaries, in entries
+    size_t maxEntries;
+    std::FILE* file;
+    SORTER sorter;
+    size_t threads;
+
+    mmTsaRunSpiller(size_t m, std::FILE* f, SORTER s, size_t t)
+      : runs(1, 0), maxEntries(m), file(f), sorter(s), threads(t)
+    { buf.reserve(maxEntries); }
+
+    void operator()(id_type, cpos const& p)
+    {
+      buf.push_back(p);
+      if (buf.size() == maxEntries) spill();
+    }
+
+    void
+    spill()
+    {
+      if (buf.empty()) return;
+      std::vector<filepos_type> sections(1, 0);
+      sections.push_back(buf.size());
+      sort_tsa_sections<TOKEN>(buf, sections, sorter, threads);
+      UTIL_THROW_IF2(std::fwrite(&buf[0], sizeof(cpos), buf.size(), file)
+                     != buf.size(), "Could not write a sorted run");
+      runs.push_back(runs.back() + buf.size());
+      buf.clear();
+    }
+  };
+
+  template<typename TOKEN>
+  template<typename VISITOR>
+  void
+  mmTsaBuilder<TOKEN>::
+  scan(id_type lo, id_type hi, VISITOR& visit) const
+  {
+    Ttrack<TOKEN> const& c = *m_corpus;
+    for (id_type sid = m_filter->find_first();
+         sid < m_filter->size();
+         sid = m_filter->find_next(sid))
+      {
+        TOKEN const* k = c.sntStart(sid);
+        TOKEN const* const stop = c.sntEnd(sid);
+        if (stop - k >= slimit) continue;
+        for (ushort p = 0; k < stop; ++p, ++k)
+          {
+            id_type wid = k->id();
+            if (wid >= lo && wid < hi) visit(wid, cpos(sid, p));
+          }
+      }
+  }
+
+  template<typename TOKEN>
+  void
+  mmTsaBuilder<TOKEN>::
+  write(std::ostream& out, std::vector<cpos> const& sufa,
+        size_t begin, size_t end) const
+  {
+    for (size_t k = begin; k < end; ++k)
+      {
+        tpt::tightwrite(out,sufa[k].sid,0);
+        tpt::tightwrite(out,sufa[k].offset,1);
+      }
+  }
+
+  template<typename TOKEN>
+  void
+  mmTsaBuilder<TOKEN>::
+  write_section(std::ostream& out, id_type wid, count_type count,
+                std::string const& spillfile) const
+  {
+    std::FILE* file = std::fopen(spillfile.c_str(), "w+b");
+    UTIL_THROW_IF2(!file, "Could not open " << spillfile);
+    std::vector<Run*> runs;
+    try
+      {
+        mmTsaRunSpiller<TOKEN,sorter_t>
+          spiller(m_maxEntries, file, m_sorter, m_threads);
+        scan(wid, wid + 1, spiller);
+        spiller.spill();
+        assert(spiller.runs.back() == count);
+        if (m_log) *m_log << "merging " << spiller.runs.size() - 1
+                          << " runs of " << count << " entries starting with id "
+                          << wid << std::endl;
+
+        // the read buffers of all runs together hold at most maxEntries
+        size_t nruns = spiller.runs.size() - 1;
+        size_t bufsize = std::max(m_maxEntries / nruns, size_t(1));
+        std::vector<cpos>().swap(spiller.buf);
+        RunGreater greater(m_sorter);
+        std::priority_queue<Run*, std::vector<Run*>, RunGreater> heap(greater);
+        for (size_t i = 0; i < nruns; ++i)
+          {
+            runs.push_back(new Run(file, spiller.runs[i], spiller.runs[i+1],
+                                   bufsize));
+            heap.push(runs.back());
+          }
+        while (heap.size())
+          {
+            Run* r = heap.top();
+            heap.pop();
+            tpt::tightwrite(out,r->top().sid,0);
+            tpt::tightwrite(out,r->top().offset,1);
+            r->pop();
+            if (!r->empty()) heap.push(r);
+          }
+      }
+    catch (...)
+      {
+        BOOST_FOREACH(Run* r, runs) delete r;
+        std::fclose(file);
+        std::remove(spillfile.c_str());
+        throw;
+      }
+    BOOST_FOREACH(Run* r, runs) delete r;
+    std::fclose(file);
+    std::remove(spillfile.c_str());
+  }
+
+  template<typename TOKEN>
+  void
+  mmTsaBuilder<TOKEN>::
+  save_as_mm_tsa(std::string const& fname) const
+  {
+    std::vector<count_type> wcnt;
+    if (m_log) *m_log << "counting tokens ... ";
+    size_t total = m_corpus->count_tokens(wcnt, m_filter, slimit, m_log);
+    if (m_log) *m_log << total << "." << std::endl;
+
+    std::ofstream out(fname.c_str());
+    filepos_type idxStart(0);
+    id_type idxSize(wcnt.size() + 1);
+    tpt::numwrite(out,idxStart);
+    tpt::numwrite(out,idxSize);
+    std::vector<filepos_type> mmIndex;
+
+    std::vector<cpos> sufa;
+    for (id_type lo = 0; lo < wcnt.size(); )
+      {
+        if (wcnt[lo] > m_maxEntries)
+          {
+            mmIndex.push_back(out.tellp());
+            write_section(out, lo, wcnt[lo], fname + ".runs");
+            ++lo;
+            continue;
+          }
+
+        // the next batch of sections that fits into memory
+        std::vector<filepos_type> sections(1, 0);
+        id_type hi = lo;
+        while (hi < wcnt.size() && sections.back() + wcnt[hi] <= m_maxEntries)
+          sections.push_back(sections.back() + wcnt[hi++]);
+        if (m_log) *m_log << "sorting " << sections.back()
+                          << " entries starting with ids " << lo << " to "
+                          << hi - 1 << std::endl;
+        sufa.resize(sections.back());
+        mmTsaBatchFiller<TOKEN> filler(sufa, sections, lo);
+        scan(lo, hi, filler);
+        sort_tsa_sections<TOKEN>(sufa, sections, m_sorter, m_threads, m_log);
+        for (size_t i = 0; i + 1 < sections.size(); ++i)
+          {
+            mmIndex.push_back(out.tellp());
+            write(out, sufa, sections[i], sections[i+1]);
+          }
+        lo = hi;
+      }
+    std::vector<cpos>().swap(sufa);
+
+    mmIndex.push_back(out.tellp());
+    idxStart = out.tellp();
+    for (size_t i = 0; i < mmIndex.size(); i++)
+      tpt::numwrite(out,mmIndex[i]-mmIndex[0]);
+    out.seekp(0);
+    tpt::numwrite(out,idxStart);
+    out.close();
+    UTIL_THROW_IF2(!out, "Could not write " << fname);
+  }
+}
+#endif
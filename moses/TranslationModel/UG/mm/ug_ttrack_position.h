@@ -71,7 +71,13 @@ namespace sapt
             a = next(a);
             b = next(b);
             if (a < bosA || a >= eosA)
-              return (b >= bosB && b < eosB);
+              {
+                if (b >= bosB && b < eosB) return true;
+                // identical suffixes: order them by position, so that the
+                // order of a sorted array does not depend on how it was sorted
+                return (A.sid < B.sid ||
+                        (A.sid == B.sid && A.offset < B.offset));
+              }
             if (b < bosB || b >= eosB)
                 return false;
           }
@@ -6,6 +6,9 @@
 #include <boost/intrusive_ptr.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/thread/locks.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/unordered_map.hpp>
 #include <algorithm>
 #include "util/exception.hh"
 #include <set>
@@ -253,6 +256,9 @@ namespace Moses
     if ((m = param.find("extra")) != param.end())
       m_extra_data = m->second;
 
+    if ((m = param.find("delta")) != param.end())
+      m_delta_file = m->second;
+
     if ((m = param.find("method")) != param.end())
       {
         if (m->second == "random")
@@ -291,6 +297,7 @@ namespace Moses
     known_parameters.push_back("coh");
     known_parameters.push_back("config");
     known_parameters.push_back("cumb");
+    known_parameters.push_back("delta");
     known_parameters.push_back("extra");
     known_parameters.push_back("feature-sets");
     known_parameters.push_back("input-factor");
@@ -333,6 +340,22 @@ namespace Moses
     m_bias = btfix->loadSentenceBias(fname);
   }
 
+  void
+  Mmsapt::
+  load_delta(string const& fname)
+  {
+    // Replay the sentence pairs added in earlier runs that have not been
+    // compacted into the static bitext yet. Only these need indexing here,
+    // so a restart takes time proportional to the updates, not the corpus.
+    m_delta.reset(new BitextDelta(fname));
+    vector<string> text1,text2,symal;
+    m_delta->read(delta_offset(m_bname, L1, L2), text1, text2, symal);
+    if (text1.size())
+      btdyn = btdyn->add(text1,text2,symal);
+    cerr << "Replayed " << text1.size() << " sentence pairs from "
+         << fname << endl;
+  }
+
   void
   Mmsapt::
   load_extra_data(string bname, bool locking = true)
@@ -509,6 +532,9 @@ namespace Moses
     if (m_extra_data.size())
       load_extra_data(m_extra_data, false);
 
+    if (m_delta_file.size())
+      load_delta(m_delta_file);
+
 #if 0
     // currently not used
     LexicalPhraseScorer2<Token>::table_t & COOC = calc_lex.scorer.COOC;
@@ -530,7 +556,11 @@ namespace Moses
     vector<string> S1(1,s1);
     vector<string> S2(1,s2);
     vector<string> ALN(1,a);
+    // Log the pair first, so that it is never visible without being on
+    // disk, and under the same lock as the update, so that a replay adds
+    // the pairs in the order they were added here.
     boost::unique_lock<boost::shared_mutex> guard(m_lock);
+    if (m_delta) m_delta->append(S1,S2,ALN);
     btdyn = btdyn->add(S1,S2,ALN);
   }
 
@@ -619,25 +649,170 @@ namespace Moses
     return tp;
   }
 
+  class
+  Mmsapt::
+  SpanJob
+  {
+  public:
+    // counts the jobs of a sentence that have not finished yet
+    class Counter
+    {
+      boost::mutex m_lock;
+      boost::condition_variable m_done;
+      size_t m_pending;
+    public:
+      Counter() : m_pending(0) { }
+
+      void add()
+      {
+        boost::unique_lock<boost::mutex> lock(m_lock);
+        ++m_pending;
+      }
+
+      void release()
+      {
+        boost::unique_lock<boost::mutex> lock(m_lock);
+        if (--m_pending == 0) m_done.notify_all();
+      }
+
+      void wait()
+      {
+        boost::unique_lock<boost::mutex> lock(m_lock);
+        while (m_pending) m_done.wait(lock);
+      }
+    };
+
+  private:
+    Mmsapt const& m_sapt;
+    ttasksptr const m_ttask;
+    SPTR<ContextForQuery> const m_context;
+    SPTR<imBitext<Token> > const m_dyn;
+    TSA<Token>::tree_iterator const m_mfix, m_mdyn;
+    bool const m_in_fix, m_in_dyn;
+    Counter& m_counter;
+    boost::atomic<bool> m_claimed; // set by whoever runs the job
+  public:
+    vector<PhrasePair<Token> > ppfix, ppdyn;
+    string error;
+
+    SpanJob(Mmsapt const& sapt, ttasksptr const& ttask,
+            SPTR<ContextForQuery> const& context,
+            SPTR<imBitext<Token> > const& dyn,
+            TSA<Token>::tree_iterator const& mfix, bool const in_fix,
+            TSA<Token>::tree_iterator const& mdyn, bool const in_dyn,
+            Counter& counter)
+      : m_sapt(sapt), m_ttask(ttask), m_context(context), m_dyn(dyn)
+      , m_mfix(mfix), m_mdyn(mdyn), m_in_fix(in_fix), m_in_dyn(in_dyn)
+      , m_counter(counter), m_claimed(false)
+    {
+      m_counter.add();
+    }
+
+    // Runs the job unless somebody else already does. The decoder thread
+    // calls this for all jobs of its sentence after posting them to the
+    // thread pool, so it works instead of waiting when the pool is busy.
+    void
+    operator()(bool const in_worker)
+    {
+      if (m_claimed.exchange(true)) return;
+      try
+        {
+          m_sapt.collect_phrase_pairs(m_ttask, m_context,
+                                      m_in_fix ? &m_mfix : NULL,
+                                      m_in_dyn ? &m_mdyn : NULL,
+                                      m_dyn, in_worker, ppfix, ppdyn);
+        }
+      catch (std::exception const& e)
+        {
+          error = e.what();
+        }
+      m_counter.release();
+    }
+  };
+
   void
   Mmsapt::
   GetTargetPhraseCollectionBatch(ttasksptr const& ttask,
                                  const InputPathList &inputPathQueue) const
   {
+    // All spans of the sentence go to the thread pool together: one job
+    // per distinct source phrase that is not in the cache yet samples the
+    // bitexts and extracts the phrase pairs. Target phrases are built here once all
+    // jobs are done, because feature functions evaluated on them expect
+    // to run in the decoder thread.
+    SPTR<imBitext<Token> > dyn;
+    { // braces are needed for scoping lock!
+      boost::shared_lock<boost::shared_mutex> guard(m_lock);
+      dyn = btdyn;
+    }
+    assert(dyn);
+
+    SPTR<ContextScope> const& scope = ttask->GetScope();
+    SPTR<TPCollCache> cache = scope->get<TPCollCache>(cache_key);
+    if (!cache) cache = m_cache; // no context-specific cache, use global one
+    SPTR<ContextForQuery> context = scope->get<ContextForQuery>(btfix.get());
+
+    SpanJob::Counter counter;
+    vector<SPTR<TPCollWrapper> > tpcolls(inputPathQueue.size());
+    vector<SPTR<SpanJob> > jobs(inputPathQueue.size());
+    vector<id_type> sphrase;
+    // spans with the same phrase id share the first one's collection
+    boost::unordered_map<uint64_t, size_t> first_span;
     InputPathList::const_iterator iter;
-    for (iter = inputPathQueue.begin(); iter != inputPathQueue.end(); ++iter)
+    size_t i = 0;
+    for (iter = inputPathQueue.begin(); iter != inputPathQueue.end(); ++iter, ++i)
       {
-        InputPath &inputPath = **iter;
-        const Phrase &phrase = inputPath.GetPhrase();
-        PrefixExists(ttask, phrase); // launches parallel lookup
+        fillIdSeq((*iter)->GetPhrase(), m_ifactor, *(btfix->V1), sphrase);
+        if (sphrase.size() == 0) continue;
+
+        TSA<Token>::tree_iterator mfix(btfix->I1.get(), &sphrase[0], sphrase.size());
+        TSA<Token>::tree_iterator mdyn(dyn->I1.get());
+        if (dyn->I1.get()) // we have a dynamic bitext
+          for (size_t k = 0; mdyn.size() == k && k < sphrase.size(); ++k)
+            mdyn.extend(sphrase[k]);
+        bool const in_fix = mfix.size() == sphrase.size();
+        bool const in_dyn = mdyn.size() == sphrase.size();
+        if (!in_fix && !in_dyn) continue;
+
+        uint64_t phrasekey = in_fix ? (mfix.getPid()<<1) : (mdyn.getPid()<<1)+1;
+        std::pair<boost::unordered_map<uint64_t, size_t>::iterator, bool> seen
+          = first_span.insert(std::make_pair(phrasekey, i));
+        if (!seen.second)
+          {
+            tpcolls[i] = tpcolls[seen.first->second];
+            continue;
+          }
+        tpcolls[i] = cache->get(phrasekey, dyn->revision());
+        {
+          boost::shared_lock<boost::shared_mutex> rlock(tpcolls[i]->lock);
+          if (tpcolls[i]->GetSize()) continue;
+        }
+
+        jobs[i].reset(new SpanJob(*this, ttask, context, dyn,
+                                  mfix, in_fix, mdyn, in_dyn, counter));
+        boost::function<void()> job = boost::bind(&SpanJob::operator(), jobs[i], true);
+        m_thread_pool->add(job);
       }
-    for (iter = inputPathQueue.begin(); iter != inputPathQueue.end(); ++iter)
+
+    BOOST_FOREACH(SPTR<SpanJob> const& job, jobs)
+      if (job) (*job)(false);
+    counter.wait();
+
+    // a repeated span comes after the first one, whose collection is
+    // filled by then
+    for (iter = inputPathQueue.begin(), i = 0; iter != inputPathQueue.end(); ++iter, ++i)
       {
         InputPath &inputPath = **iter;
-        const Phrase &phrase = inputPath.GetPhrase();
-        TargetPhraseCollection::shared_ptr targetPhrases
-          = this->GetTargetPhraseCollectionLEGACY(ttask,phrase);
-        inputPath.SetTargetPhrases(*this, targetPhrases, NULL);
+        if (jobs[i])
+          {
+            UTIL_THROW_IF2(jobs[i]->error.size(), jobs[i]->error);
+            boost::unique_lock<boost::shared_mutex> wlock(tpcolls[i]->lock);
+            // maybe another thread did the work in the meantime
+            if (!tpcolls[i]->GetSize())
+              fill_tpcoll(ttask, inputPath.GetPhrase(), jobs[i]->ppfix,
+                          jobs[i]->ppdyn, dyn, *tpcolls[i]);
+          }
+        inputPath.SetTargetPhrases(*this, tpcolls[i], NULL);
       }
   }
   
@@ -666,7 +841,7 @@ namespace Moses
     // is added. /dyn/ keeps the old bitext around as long as we need it.
     SPTR<imBitext<Token> > dyn;
     { // braces are needed for scoping mutex lock guard!
-      boost::unique_lock<boost::shared_mutex> guard(m_lock);
+      boost::shared_lock<boost::shared_mutex> guard(m_lock);
       assert(btdyn);
       dyn = btdyn;
     }
@@ -713,6 +888,27 @@ namespace Moses
     if (ret->GetSize()) return ret; 
 
     // OK: pt entry NOT found or NOT up to date
+    SPTR<ContextForQuery> context = scope->get<ContextForQuery>(btfix.get());
+    vector<PhrasePair<Token> > ppfix,ppdyn;
+    collect_phrase_pairs(ttask, context,
+                         mfix.size() == sphrase.size() ? &mfix : NULL,
+                         mdyn.size() == sphrase.size() ? &mdyn : NULL,
+                         dyn, false, ppfix, ppdyn);
+    fill_tpcoll(ttask, src, ppfix, ppdyn, dyn, *ret);
+    return ret;
+  }
+
+  void
+  Mmsapt::
+  collect_phrase_pairs(ttasksptr const& ttask,
+                       SPTR<ContextForQuery> const& context,
+                       TSA<Token>::tree_iterator const* mfix,
+                       TSA<Token>::tree_iterator const* mdyn,
+                       SPTR<imBitext<Token> > const& dyn,
+                       bool const in_worker,
+                       vector<PhrasePair<Token> >& ppfix,
+                       vector<PhrasePair<Token> >& ppdyn) const
+  {
     // lookup and expansion could be done in parallel threads,
     // but ppdyn is probably small anyway
     // TO DO: have Bitexts return lists of PhrasePairs instead of pstats
@@ -720,14 +916,21 @@ namespace Moses
     // for btfix.
     SPTR<pstats> sfix,sdyn;
 
-    if (mfix.size() == sphrase.size()) 
+    if (mfix)
       {
-        SPTR<ContextForQuery> context = scope->get<ContextForQuery>(btfix.get());
-        SPTR<pstats> const* foo = context->cache1->get(mfix.getPid());
-        if (foo) { sfix = *foo; sfix->wait(); }
+        SPTR<pstats> const* foo = context->cache1->get(mfix->getPid());
+        bool ready = foo;
+        if (foo && in_worker)
+          {
+            // A worker thread must not wait for stats whose sampler may
+            // still be queued behind it in the thread pool.
+            boost::unique_lock<boost::mutex> lock((*foo)->lock);
+            ready = (*foo)->in_progress == 0;
+          }
+        if (ready) { sfix = *foo; sfix->wait(); }
         else 
           {
-            BitextSampler<Token> s(btfix, mfix, context->bias, 
+            BitextSampler<Token> s(btfix, *mfix, context->bias, 
                                    m_min_sample_size, 
                                    m_default_sample_size, 
                                    m_sampling_method);
@@ -736,38 +939,46 @@ namespace Moses
           }
       }
 
-    if (mdyn.size() == sphrase.size()) 
-      sdyn = dyn->lookup(ttask, mdyn);
+    if (mdyn) 
+      sdyn = dyn->lookup(ttask, *mdyn);
 
-    vector<PhrasePair<Token> > ppfix,ppdyn;
     PhrasePair<Token>::SortByTargetIdSeq sort_by_tgt_id;
     if (sfix)
       {
-        expand(mfix, *btfix, *sfix, ppfix, m_bias_log);
+        expand(*mfix, *btfix, *sfix, ppfix, m_bias_log);
         sort(ppfix.begin(), ppfix.end(),sort_by_tgt_id);
       }
     if (sdyn)
       {
-        expand(mdyn, *dyn, *sdyn, ppdyn, m_bias_log);
+        expand(*mdyn, *dyn, *sdyn, ppdyn, m_bias_log);
         sort(ppdyn.begin(), ppdyn.end(),sort_by_tgt_id);
       }
+  }
 
+  void
+  Mmsapt::
+  fill_tpcoll(ttasksptr const& ttask, Phrase const& src,
+              vector<PhrasePair<Token> >& ppfix,
+              vector<PhrasePair<Token> >& ppdyn,
+              SPTR<imBitext<Token> > const& dyn,
+              TPCollWrapper& ret) const
+  {
     // now we have two lists of Phrase Pairs, let's merge them
     PhrasePair<Token>::SortByTargetIdSeq sorter;
     size_t i = 0; size_t k = 0;
     while (i < ppfix.size() && k < ppdyn.size())
       {
         int cmp = sorter.cmp(ppfix[i], ppdyn[k]);
-        if      (cmp  < 0) ret->Add(mkTPhrase(ttask,src,&ppfix[i++],NULL,dyn));
-        else if (cmp == 0) ret->Add(mkTPhrase(ttask,src,&ppfix[i++],&ppdyn[k++],dyn));
-        else               ret->Add(mkTPhrase(ttask,src,NULL,&ppdyn[k++],dyn));
+        if      (cmp  < 0) ret.Add(mkTPhrase(ttask,src,&ppfix[i++],NULL,dyn));
+        else if (cmp == 0) ret.Add(mkTPhrase(ttask,src,&ppfix[i++],&ppdyn[k++],dyn));
+        else               ret.Add(mkTPhrase(ttask,src,NULL,&ppdyn[k++],dyn));
       }
-    while (i < ppfix.size()) ret->Add(mkTPhrase(ttask,src,&ppfix[i++],NULL,dyn));
-    while (k < ppdyn.size()) ret->Add(mkTPhrase(ttask,src,NULL,&ppdyn[k++],dyn));
+    while (i < ppfix.size()) ret.Add(mkTPhrase(ttask,src,&ppfix[i++],NULL,dyn));
+    while (k < ppdyn.size()) ret.Add(mkTPhrase(ttask,src,NULL,&ppdyn[k++],dyn));
 
     // Pruning should not be done here but outside!
-    if (m_tableLimit) ret->Prune(true, m_tableLimit);
-    else ret->Prune(true,ret->GetSize());
+    if (m_tableLimit) ret.Prune(true, m_tableLimit);
+    else ret.Prune(true,ret.GetSize());
 
 #if 1
     if (m_bias_log && m_lr_func && m_bias_loglevel > 3)
@@ -781,7 +992,6 @@ namespace Moses
           }
       }
 #endif
-    return ret;
   }
 
   size_t
@@ -929,7 +1139,7 @@ namespace Moses
 
     SPTR<imBitext<Token> > dyn;
     { // braces are needed for scoping lock!
-      boost::unique_lock<boost::shared_mutex> guard(m_lock);
+      boost::shared_lock<boost::shared_mutex> guard(m_lock);
       dyn = btdyn;
     }
     assert(dyn);
@@ -22,6 +22,7 @@
 #include "moses/TranslationModel/UG/mm/tpt_pickler.h"
 #include "moses/TranslationModel/UG/mm/ug_bitext.h"
 #include "moses/TranslationModel/UG/mm/ug_bitext_sampler.h"
+#include "moses/TranslationModel/UG/mm/ug_bitext_delta.h"
 #include "moses/TranslationModel/UG/mm/ug_lexical_phrase_scorer2.h"
 
 #include "moses/TranslationModel/UG/TargetPhraseCollectionCache.h"
@@ -74,6 +75,8 @@ namespace Moses
     SPTR<mmbitext> btfix;
     SPTR<imbitext> btdyn;
     std::string m_bname, m_extra_data, m_bias_file,m_bias_server;
+    std::string m_delta_file;
+    boost::scoped_ptr<sapt::BitextDelta> m_delta; // log of pairs added with add()
     std::string L1;
     std::string L2;
     float  m_lbop_conf; // confidence level for lbop smoothing
@@ -181,6 +184,30 @@ namespace Moses
               sapt::PhrasePair<Token>* dyn,
               SPTR<sapt::Bitext<Token> > const& dynbt) const;
 
+    // sampling and phrase pair extraction for one span of a sentence,
+    // see GetTargetPhraseCollectionBatch()
+    class SpanJob;
+
+    void
+    collect_phrase_pairs
+    (ttasksptr const& ttask,
+     SPTR<sapt::ContextForQuery> const& context,
+     sapt::TSA<Token>::tree_iterator const* mfix,
+     sapt::TSA<Token>::tree_iterator const* mdyn,
+     SPTR<imbitext> const& dyn,
+     bool const in_worker,
+     std::vector<sapt::PhrasePair<Token> >& ppfix,
+     std::vector<sapt::PhrasePair<Token> >& ppdyn) const;
+
+    void
+    fill_tpcoll
+    (ttasksptr const& ttask,
+     Phrase const& src,
+     std::vector<sapt::PhrasePair<Token> >& ppfix,
+     std::vector<sapt::PhrasePair<Token> >& ppdyn,
+     SPTR<imbitext> const& dyn,
+     TPCollWrapper& ret) const;
+
     void
     process_pstats
     (Phrase   const& src,
@@ -205,6 +232,7 @@ namespace Moses
      TargetPhraseCollection::shared_ptr  tpcoll) const;
 
     void load_extra_data(std::string bname, bool locking);
+    void load_delta(std::string const& fname);
     void load_bias(std::string bname);
 
   public:
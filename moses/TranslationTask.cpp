@@ -157,6 +157,11 @@ interpret_dlt()
 }
 
 
+size_t TranslationTask::GetCost() const
+{
+  return m_source ? m_source->GetSize() : 0;
+}
+
 void TranslationTask::Run()
 {
   UTIL_THROW_IF2(!m_source || !m_ioWrapper,
@@ -9,6 +9,7 @@ namespace Moses
     : pop_limit(DEFAULT_CUBE_PRUNING_POP_LIMIT)
     , diversity(DEFAULT_CUBE_PRUNING_DIVERSITY)
     , lazy_scoring(false)
+    , lazy_requeue(false)
     , deterministic_search(false)
   {}
 
@@ -21,6 +22,8 @@ namespace Moses
     param.SetParameter(diversity, "cube-pruning-diversity",
 		       DEFAULT_CUBE_PRUNING_DIVERSITY);
     param.SetParameter(lazy_scoring, "cube-pruning-lazy-scoring", false);
+    param.SetParameter(lazy_requeue, "cube-pruning-lazy-requeue", false);
+    lazy_scoring = lazy_scoring || lazy_requeue;
     param.SetParameter(deterministic_search, "cube-pruning-deterministic-search", false);
     return true;
   }
@@ -54,6 +57,22 @@ namespace Moses
 	      }
 	    }
 
+      si = params.find("cube-pruning-lazy-requeue");
+      if (si != params.end())
+      {
+        std::string spec = xmlrpc_c::value_string(si->second);
+        if (spec == "true" or spec == "on" or spec == "1")
+          lazy_scoring = lazy_requeue = true;
+        else if (spec == "false" or spec == "off" or spec == "0")
+          lazy_requeue = false;
+        else
+        {
+          char const* msg
+          = "Error parsing specification for cube-pruning-lazy-requeue";
+          xmlrpc_c::fault(msg, xmlrpc_c::fault::CODE_PARSE);
+        }
+      }
+
       si = params.find("cube-pruning-deterministic-search");
       if (si != params.end())
       {
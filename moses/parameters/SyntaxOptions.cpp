@@ -15,6 +15,8 @@ namespace Moses {
     , default_non_term_only_for_empty_range(false)
     , source_label_overlap(SourceLabelOverlapAdd)
     , rule_limit(DEFAULT_MAX_TRANS_OPT_SIZE)
+    , cell_threads(1)
+    , s2t_matching_threads(1)
   { }
 
   bool
@@ -28,6 +30,8 @@ namespace Moses {
                        "default-non-term-for-empty-range-only", false);
     param.SetParameter(source_label_overlap, "source-label-overlap", 
                        SourceLabelOverlapAdd);
+    param.SetParameter(cell_threads, "chart-cell-threads", size_t(1));
+    param.SetParameter(s2t_matching_threads, "s2t-matching-threads", size_t(1));
     return true;
   }
 
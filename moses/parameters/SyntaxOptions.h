@@ -22,6 +22,8 @@ namespace Moses
     UnknownLHSList unknown_lhs;
     SourceLabelOverlap source_label_overlap; // m_sourceLabelOverlap;
     size_t rule_limit;
+    size_t cell_threads; // threads decoding the cells of a span width
+    size_t s2t_matching_threads; // threads matching rules with the S2T scope-3 parser
 
     SyntaxOptions();
 
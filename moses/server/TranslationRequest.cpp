@@ -208,7 +208,7 @@ insertTranslationOptions(Moses::Manager& manager,
         toptXml["start"]  = xmlrpc_c::value_int(s);
         toptXml["end"]    = xmlrpc_c::value_int(e);
         vector<xmlrpc_c::value> scoresXml;
-        const std::valarray<FValue> &scores
+        const FCoreVector &scores
 	  = topt->GetScoreBreakdown().getCoreFeatures();
         for (size_t j = 0; j < scores.size(); ++j)
           scoresXml.push_back(xmlrpc_c::value_double(scores[j]));
@@ -146,6 +146,16 @@ void UnmapOrThrow(void *start, size_t length) {
 #endif
 }
 
+void AdviseWillNeed(const void *start, std::size_t length) {
+#if !defined(_WIN32) && !defined(_WIN64)
+  if (!length) return;
+  const uintptr_t page = SizePage();
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(start) & ~(page - 1);
+  const uintptr_t end = reinterpret_cast<uintptr_t>(start) + length;
+  madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+#endif
+}
+
 // Linux huge pages.
 #ifdef __linux__
 
@@ -115,6 +115,11 @@ void SyncOrThrow(void *start, size_t length);
 // Cross-platform, error-checking wrapper for munmap().
 void UnmapOrThrow(void *start, size_t length);
 
+// Hint that [start, start + length) of a mapping will be read soon, so the
+// kernel can start paging it in.  start need not be page aligned.  This is
+// only advice: errors are ignored and it does nothing on Windows.
+void AdviseWillNeed(const void *start, std::size_t length);
+
 // Allocate memory, promising that all/vast majority of it will be used.  Tries
 // hard to use huge pages on Linux.
 // If you want zeroed memory, pass zeroed = true.